@@ -0,0 +1,84 @@
+/**
+ * \file sesstype/bulk.h
+ * \brief Construction of a whole session from flat arrays in one call.
+ */
+#ifndef SESSTYPE__BULK_H__
+#define SESSTYPE__BULK_H__
+
+#include "sesstype/msg.h"
+#include "sesstype/node.h"
+#include "sesstype/role.h"
+#include "sesstype/session.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Flat description of a session (st_tree) for st_tree_mk_bulk.
+ *
+ * Strings are referenced by index into the role and label tables. Nodes are
+ * listed in pre-order: node 0 is the root (parent -1) and every other node
+ * has a parent with a smaller index, which is a block-like node (ST_NODE_ROOT,
+ * ST_NODE_CHOICE, ST_NODE_RECUR or ST_NODE_PARALLEL). Children are appended
+ * to their parent in index order.
+ *
+ * Per node, depending on kinds[i]:
+ *  - ST_NODE_SENDRECV: args[i] is a message index, roles[i] the sender (or
+ *    -1) and rcvrs[rcvr_offsets[i] .. rcvr_offsets[i+1]) the receivers.
+ *  - ST_NODE_CHOICE: roles[i] is the choice maker (or -1).
+ *  - ST_NODE_RECUR, ST_NODE_CONTINUE: args[i] is a label index.
+ *  - ST_NODE_ROOT, ST_NODE_PARALLEL: no arguments.
+ *
+ * Message m has label msg_labels[m] and payloads
+ * [payload_offsets[m] .. payload_offsets[m+1]) of payload_types and
+ * payload_names (payload_names may be NULL, as may any of its entries).
+ * rcvr_offsets and rcvrs may be NULL if no node has receivers, roles and
+ * args may be NULL if no node uses them.
+ */
+typedef struct st_tree_bulk {
+    const char *name;
+
+    unsigned int num_roles;
+    const char *const *role_names;
+
+    unsigned int num_labels;
+    const char *const *label_names;
+
+    unsigned int num_msgs;
+    const unsigned int *msg_labels;
+    const unsigned int *payload_offsets;  ///< num_msgs + 1 entries.
+    const char *const *payload_types;
+    const char *const *payload_names;
+
+    unsigned int num_nodes;
+    const unsigned int *kinds;
+    const int *parents;
+    const int *roles;
+    const unsigned int *args;
+    const unsigned int *rcvr_offsets;     ///< num_nodes + 1 entries.
+    const unsigned int *rcvrs;
+} st_tree_bulk;
+
+/// \brief Build a whole session from a flat description.
+///
+/// The result is the same as building the session with st_tree_mk_init,
+/// st_tree_add_role, st_mk_*_node, st_interaction_node_set_from/add_to and
+/// st_node_append_child, without a call per node.
+/// \param[in] desc of session.
+/// \returns session allocated dynamically, or NULL if desc is malformed.
+st_tree *st_tree_mk_bulk(const st_tree_bulk *desc);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__BULK_H__
@@ -8,7 +8,9 @@
 #ifdef __cplusplus
 #include <string>
 #include <iterator>
+#include <stdexcept>
 #include <unordered_map>
+#include <vector>
 #endif
 
 #include "sesstype/import.h"
@@ -24,6 +26,11 @@ namespace sesstype {
 #ifdef __cplusplus
 /**
  * \brief Module is a container class for multiple logically related Sessions.
+ *
+ * A Module can be frozen (see ModuleTmpl::freeze) once it is fully built, so
+ * that it can be shared by many threads: a frozen Module, its Sessions,
+ * their Roles and bodies are immutable and all lookups are read-only (see
+ * SessionTmpl for what is not frozen).
  */
 template <class ImportType, class SessionType>
 class ModuleTmpl {
@@ -31,16 +38,22 @@ class ModuleTmpl {
     // Pair<Import * theimport, bool is_alias>
     std::unordered_map<std::string, std::pair<ImportType *, bool>> imports_;
     std::unordered_map<std::string, SessionType *> sessions_;
+    std::vector<SessionType *> session_index_; // Built by freeze()
+    bool frozen_;
 
   public:
     using ImportContainer  = std::unordered_map<std::string, std::pair<ImportType *, bool>>;
     using SessionContainer = std::unordered_map<std::string, SessionType *>;
 
     /// \brief Module constructor with "default" as Module name.
-    ModuleTmpl() : name_("default"), imports_(), sessions_() { }
+    ModuleTmpl()
+        : name_("default"), imports_(), sessions_(), session_index_(),
+          frozen_(false) { }
 
     /// \brief Module constructor.
-    ModuleTmpl(std::string name) : name_(name), imports_(), sessions_() { }
+    ModuleTmpl(std::string name)
+        : name_(name), imports_(), sessions_(), session_index_(),
+          frozen_(false) { }
 
     /// \brief Module destructor.
     virtual ~ModuleTmpl()
@@ -60,14 +73,18 @@ class ModuleTmpl {
 
     /// \brief Replace Module name.
     /// \param[in] name of Module to replace with.
+    /// \exception std::logic_error if Module is frozen.
     void set_name(std::string name)
     {
+        check_mutable();
         name_ = name;
     }
 
     /// \param[in] Session to add as component of Module.
+    /// \exception std::logic_error if Module is frozen.
     void add_session(SessionType *session)
     {
+        check_mutable();
         sessions_.insert({ session->name(), session });
     }
 
@@ -91,6 +108,21 @@ class ModuleTmpl {
         return sessions_.at(name);
     }
 
+    /// \returns Session at position <tt>idx</tt> in iteration order.
+    /// \exception std::out_of_range if <tt>idx</tt> is out of bounds.
+    SessionType *session_at(unsigned int idx) const
+    {
+        if (frozen_) {
+            return session_index_.at(idx);
+        }
+        if (idx >= sessions_.size()) {
+            throw std::out_of_range("Module::session_at");
+        }
+        auto it = sessions_.begin();
+        std::advance(it, idx);
+        return it->second;
+    }
+
     typename SessionContainer::const_iterator session_begin() const
     {
         return sessions_.begin();
@@ -102,8 +134,10 @@ class ModuleTmpl {
     }
 
     /// \param[in] import to add to Module.
+    /// \exception std::logic_error if Module is frozen.
     void add_import(ImportType *import)
     {
+        check_mutable();
         imports_.insert({ import->name(), std::make_pair(import, false)});
         if (import->as() != "") {
             imports_.insert({ import->as(), std::make_pair(import, true/*alias*/)});
@@ -139,6 +173,39 @@ class ModuleTmpl {
     {
         return imports_.end();
     }
+
+    /// \brief Make Module and all its Sessions immutable for shared reading.
+    ///
+    /// The positional Session index is built eagerly, so no lookup on a
+    /// frozen Module modifies it. Freezing a frozen Module has no effect.
+    /// \returns this Module, safe to read from any number of threads.
+    const ModuleTmpl *freeze()
+    {
+        if (!frozen_) {
+            session_index_.reserve(sessions_.size());
+            for (auto session_pair : sessions_) {
+                session_pair.second->freeze();
+                session_index_.push_back(session_pair.second);
+            }
+            frozen_ = true;
+        }
+        return this;
+    }
+
+    /// \returns true if Module is frozen.
+    bool is_frozen() const
+    {
+        return frozen_;
+    }
+
+  protected:
+    /// \exception std::logic_error if Module is frozen.
+    void check_mutable() const
+    {
+        if (frozen_) {
+            throw std::logic_error("Module is frozen");
+        }
+    }
 };
 
 using Module = ModuleTmpl<Import, Session>;
@@ -175,6 +242,11 @@ st_tree *st_module_get_tree_at_idx(st_module *const module, unsigned int index);
 /// \returns modified module.
 st_module *st_module_import(st_module *const module, st_import *import);
 
+/// \brief Bind ContinueNodes and freeze every tree in module.
+/// \param[in,out] module to freeze.
+/// \returns frozen module, or NULL if a ContinueNode cannot be bound.
+const st_module *st_module_freeze(st_module *const module);
+
 /// \param[in,out] module object to destroy.
 void st_module_free(st_module *module);
 
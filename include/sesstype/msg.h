@@ -13,6 +13,7 @@
 #endif
 
 #include "sesstype/util/clonable.h"
+#include "sesstype/util/stamped.h"
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -27,7 +28,7 @@ namespace sesstype {
  * non-empty datatype. The datatypes can have multi-dimensional Expr parameters
  * for representing multi-dimensional arrays.
  */
-class MsgPayload : public util::Clonable {
+class MsgPayload : public util::Clonable, public util::Stamped {
     std::string name_;
     std::string type_;
 
@@ -74,7 +75,7 @@ class MsgPayload : public util::Clonable {
  * message-passing based interactions), which contains a message label (for
  * identifying messages) and optionally payload types (see MsgPayload).
  */
-class MsgSig : public util::Clonable {
+class MsgSig : public util::Clonable, public util::Stamped {
     std::string label_;
     std::vector<MsgPayload *> payloads_;
 
@@ -89,7 +90,7 @@ class MsgSig : public util::Clonable {
     MsgSig(const MsgSig &msgsig) : label_(msgsig.label_), payloads_()
     {
         for (auto payload : msgsig.payloads_) {
-            payloads_.push_back(payload);
+            payloads_.push_back(payload->clone());
         }
     }
 
@@ -117,7 +118,15 @@ class MsgSig : public util::Clonable {
     /// \param[in] payload to add.
     void add_payload(MsgPayload *payload)
     {
+        check_mutable();
         payloads_.push_back(payload->clone());
+        touch();
+    }
+
+    /// \returns revision stamp of MsgSig, including its payloads.
+    unsigned long revision() const override
+    {
+        return max_revision(Stamped::revision(), payloads_.begin(), payloads_.end());
     }
 
     /// \returns number of payload paramaters.
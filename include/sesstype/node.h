@@ -5,9 +5,16 @@
 #ifndef SESSTYPE__NODE_H__
 #define SESSTYPE__NODE_H__
 
+#ifdef __cplusplus
+#include <stdexcept>
+#else
+#include <stdbool.h>
+#endif
+
 #include "sesstype/msg.h"
 #include "sesstype/role.h"
 #include "sesstype/util/clonable.h"
+#include "sesstype/util/stamped.h"
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -37,8 +44,17 @@ namespace sesstype {
  * \brief Session Type statements (st_node).
  *
  * Contains Node::accept method for visitors.
+ *
+ * Every Node carries a revision stamp which is refreshed whenever the Node
+ * itself is modified (see util::Stamped::touch), so that analyses can tell
+ * which parts of a tree changed since they last looked at it. The revision
+ * of a Node includes the Roles and MsgSigs it owns, so editing them through
+ * a getter (e.g. <tt>node->sndr()->set_name(...)</tt>) also changes it.
+ *
+ * A frozen Node (see Node::freeze) can no longer be modified and is safe
+ * to read from any number of threads without locking.
  */
-class Node : public util::Clonable {
+class Node : public util::Clonable, public util::Stamped {
     unsigned int type_;
 
   public:
@@ -53,7 +69,13 @@ class Node : public util::Clonable {
     friend std::ostream &operator<<(std::ostream &os, Node &node);
 
   protected:
-    explicit Node(unsigned int type) : type_(type) { }
+    explicit Node(unsigned int type)
+        : util::Stamped(), type_(type) { }
+
+    /// \brief Node copy constructor, a copy is a new (mutable) Node with its
+    /// own revision.
+    Node(const Node &node)
+        : util::Clonable(), util::Stamped(), type_(node.type_) { }
 };
 #endif // __cplusplus
 
@@ -69,6 +91,10 @@ typedef struct Node st_node;
 
 st_node *st_node_project(st_node *const node, st_role *const endpoint);
 
+/// \brief Bind every ContinueNode under node to its enclosing RecurNode.
+/// \returns true if all ContinueNode were bound.
+bool st_node_bind_recur(st_node *const node);
+
 void st_node_print(st_node *const node);
 
 void st_node_free(st_node *node);
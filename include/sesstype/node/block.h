@@ -2,6 +2,8 @@
 #define SESSTYPE__NODE__BLOCK_H__
 
 #ifdef __cplusplus
+#include <stdexcept>
+#include <utility>
 #include <vector>
 #endif
 
@@ -28,7 +30,7 @@ class BlockNodeTmpl : public BaseNode {
     BlockNodeTmpl() : BaseNode(ST_NODE_ROOT), children_() { }
 
     /// \brief BlockNode copy constructor.
-    BlockNodeTmpl(const BlockNodeTmpl &node) : BaseNode(ST_NODE_ROOT), children_()
+    BlockNodeTmpl(const BlockNodeTmpl &node) : BaseNode(node), children_()
     {
         for (BaseNode *child : node.children_) {
             children_.push_back(static_cast<BaseNode *>(child->clone()));
@@ -69,12 +71,83 @@ class BlockNodeTmpl : public BaseNode {
     /// \param[in] child Node.
     void append_child(BaseNode *child)
     {
+        this->check_mutable();
         children_.push_back(child);
+        this->touch();
     }
 
     void set_child(unsigned int idx, BaseNode *child)
     {
+        this->check_mutable();
         children_.at(idx) = child;
+        this->touch();
+    }
+
+    /// \brief Remove child Node from current Block without deleting it.
+    /// \param[in] idx of Node in BlockNode.
+    /// \returns detached child Node, now owned by the caller.
+    /// \exception std::out_of_range if <tt>idx</tt> is out of bounds.
+    BaseNode *detach_child(unsigned int idx)
+    {
+        this->check_mutable();
+        BaseNode *child = children_.at(idx);
+        children_.erase(children_.begin() + idx);
+        this->touch();
+        return child;
+    }
+
+    /// \brief Insert child Node before position <tt>idx</tt>.
+    /// \param[in] idx of insertion, num_children() to append.
+    /// \param[in] child Node, now owned by this BlockNode.
+    /// \exception std::out_of_range if <tt>idx</tt> is out of bounds.
+    void insert_child(unsigned int idx, BaseNode *child)
+    {
+        this->check_mutable();
+        if (idx > children_.size()) {
+            throw std::out_of_range("BlockNode::insert_child");
+        }
+        children_.insert(children_.begin() + idx, child);
+        this->touch();
+    }
+
+    /// \brief Move children [first, last) of src before position <tt>idx</tt>.
+    ///
+    /// Ownership of the moved children is transferred to this BlockNode, src
+    /// may be this BlockNode if <tt>idx</tt> is not inside the moved range.
+    /// \param[in] idx of insertion in this BlockNode (before the move).
+    /// \param[in,out] src BlockNode to move children from.
+    /// \param[in] first index of first child to move.
+    /// \param[in] last index past the last child to move.
+    /// \exception std::out_of_range if any index is out of bounds.
+    void splice(unsigned int idx, BlockNodeTmpl *src, unsigned int first, unsigned int last)
+    {
+        this->check_mutable();
+        src->check_mutable();
+        if (first > last || last > src->children_.size() || idx > children_.size()) {
+            throw std::out_of_range("BlockNode::splice");
+        }
+        if (src == this) {
+            if (idx > first && idx < last) {
+                throw std::out_of_range("BlockNode::splice");
+            }
+            if (idx >= last) {
+                idx -= (last - first);
+            }
+        }
+        NodeContainer moved(src->children_.begin() + first, src->children_.begin() + last);
+        src->children_.erase(src->children_.begin() + first, src->children_.begin() + last);
+        children_.insert(children_.begin() + idx, moved.begin(), moved.end());
+        src->touch();
+        this->touch();
+    }
+
+    /// \brief Swap positions of two children.
+    /// \exception std::out_of_range if an index is out of bounds.
+    void swap_children(unsigned int i, unsigned int j)
+    {
+        this->check_mutable();
+        std::swap(children_.at(i), children_.at(j));
+        this->touch();
     }
 
     /// \brief Start iterator for children.
@@ -89,10 +162,37 @@ class BlockNodeTmpl : public BaseNode {
         return children_.end();
     }
 
+    /// \brief Make BlockNode and all its descendants (with the Roles and
+    ///        MsgSigs they own) immutable.
+    ///
+    /// The tree is walked with an explicit stack, so freezing is not limited
+    /// by the depth of the tree.
+    void freeze() override
+    {
+        std::vector<BaseNode *> stack(1, this);
+        while (!stack.empty()) {
+            BaseNode *node = stack.back();
+            stack.pop_back();
+            if (auto *blk = dynamic_cast<BlockNodeTmpl *>(node)) {
+                blk->BaseNode::freeze();
+                blk->freeze_parts();
+                for (BaseNode *child : blk->children_) {
+                    if (child != nullptr) stack.push_back(child);
+                }
+            } else {
+                node->freeze();
+            }
+        }
+    }
+
     virtual void accept(VisitorType &v) override;
 
   protected:
     BlockNodeTmpl(int type) : BaseNode(type), children_() { }
+
+    /// \brief Freeze the Roles and MsgSigs owned by the block itself (but
+    ///        not by its children).
+    virtual void freeze_parts() { }
 };
 
 using BlockNode = BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>;
@@ -108,6 +208,20 @@ unsigned int st_node_num_children(st_node *const parent);
 
 st_node *st_node_get_child(st_node *const parent, unsigned int index);
 
+/// \brief Detach child without deleting it.
+/// \returns detached child (owned by caller) or NULL if parent is not a block.
+st_node *st_node_detach_child(st_node *const parent, unsigned int index);
+
+/// \brief Insert child (now owned by parent) before index.
+st_node *st_node_insert_child(st_node *const parent, unsigned int index, st_node *child);
+
+/// \brief Move children [first, last) of src to parent before index.
+st_node *st_node_splice_children(st_node *const parent, unsigned int index,
+                                 st_node *const src, unsigned int first, unsigned int last);
+
+/// \brief Swap children at index i and j.
+st_node *st_node_swap_children(st_node *const parent, unsigned int i, unsigned int j);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -33,7 +33,7 @@ class ChoiceNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Vis
     /// \brief ChoiceNode copy constructor.
     ChoiceNodeTmpl(const ChoiceNodeTmpl &node)
         : BlockNodeTmpl<BaseNode, RoleType, MessageType, VisitorType>(node),
-          at_(node.at_) { }
+          at_(node.at_ ? node.at_->clone() : nullptr) { }
 
     /// \brief ChoiceNode destructor.
     ~ChoiceNodeTmpl() override
@@ -50,8 +50,10 @@ class ChoiceNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Vis
     /// \param[in] at Role to set as choice maker.
     void set_at(RoleType *at)
     {
+        this->check_mutable();
         delete at_;
         at_ = at->clone();
+        this->touch();
     }
 
     /// \returns choice maker Role.
@@ -66,6 +68,23 @@ class ChoiceNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Vis
         this->append_child(choice);
     }
 
+    /// \returns revision stamp of ChoiceNode, including its choice maker Role.
+    unsigned long revision() const override
+    {
+        unsigned long revision = BaseNode::revision();
+        return at_ != nullptr ? std::max(revision, at_->revision()) : revision;
+    }
+
+  protected:
+    void freeze_parts() override
+    {
+        if (at_ != nullptr) {
+            at_->freeze();
+        }
+    }
+
+  public:
+
     void accept(VisitorType &v) override;
 };
 
@@ -17,22 +17,38 @@ namespace sesstype {
 #ifdef __cplusplus
 /**
  * \brief Continue statements.
+ *
+ * A ContinueNode refers to its RecurNode by label. Once bound (see
+ * util::RecurBinder), it also records the scope of its RecurNode, i.e. the
+ * number of RecurNode between the ContinueNode and its target RecurNode,
+ * so the target can be found by position. The scope is relative, and is
+ * therefore preserved by cloning and by projection.
+ *
+ * Only set_label unbinds a ContinueNode, so a binding may be stale after
+ * RecurNode::set_label or edits of the enclosing BlockNodes. The binding
+ * also records its target RecurNode and the largest revision of the
+ * enclosing RecurNodes, and consumers (util::RecurScope::target and
+ * util::CFSMBuilder) only use it if both are unchanged (see is_bound_to),
+ * otherwise they find the target by label.
  */
 template <class BaseNode, class RoleType, class MessageType, class VisitorType>
 class ContinueNodeTmpl : public BaseNode {
     std::string label_;
+    int scope_;
+    const BaseNode *target_;  // RecurNode bound to.
+    unsigned long stamp_;     // Largest revision of enclosing RecurNodes.
 
   public:
     /// \brief ContinueNode constructor.
     /// \param[in] label of Choice Node.
     ContinueNodeTmpl(std::string label)
         : BaseNode(ST_NODE_CONTINUE),
-          label_(label) { }
+          label_(label), scope_(-1), target_(nullptr), stamp_(0) { }
 
     /// \brief ContinueNode copy constructor.
     ContinueNodeTmpl(const ContinueNodeTmpl &node)
         : BaseNode(ST_NODE_CONTINUE),
-          label_(node.label_) { }
+          label_(node.label_), scope_(node.scope_), target_(node.target_), stamp_(node.stamp_) { }
 
     /// \brief clone a ContinueNode.
     ContinueNodeTmpl *clone() const override
@@ -44,7 +60,11 @@ class ContinueNodeTmpl : public BaseNode {
     /// \param[in] label of ContinueNode to replace with.
     void set_label(std::string label)
     {
+        this->check_mutable();
         label_ = label;
+        scope_ = -1;
+        target_ = nullptr;
+        this->touch();
     }
 
     /// \returns label of ContinueNode.
@@ -53,6 +73,41 @@ class ContinueNodeTmpl : public BaseNode {
         return label_;
     }
 
+    /// \brief Bind ContinueNode to an enclosing RecurNode.
+    /// \param[in] scope of target RecurNode (0 is the innermost RecurNode).
+    /// \param[in] target RecurNode, or nullptr if only the scope is known.
+    /// \param[in] stamp largest revision of the enclosing RecurNodes.
+    /// \exception std::logic_error if ContinueNode is frozen.
+    void bind(unsigned int scope, const BaseNode *target = nullptr, unsigned long stamp = 0)
+    {
+        this->check_mutable();
+        scope_ = scope;
+        target_ = target;
+        stamp_ = stamp;
+    }
+
+    /// \returns true if the binding is still valid in constant time, i.e.
+    ///          target is the RecurNode bound to and no enclosing RecurNode
+    ///          was modified or added since.
+    /// \param[in] target RecurNode at scope() of the enclosing RecurNodes.
+    /// \param[in] stamp largest revision of the enclosing RecurNodes.
+    bool is_bound_to(const BaseNode *target, unsigned long stamp) const
+    {
+        return scope_ >= 0 && target_ != nullptr && target_ == target && stamp_ == stamp;
+    }
+
+    /// \returns true if ContinueNode is bound to a RecurNode.
+    bool is_bound() const
+    {
+        return scope_ >= 0;
+    }
+
+    /// \returns scope of target RecurNode, or -1 if not bound.
+    int scope() const
+    {
+        return scope_;
+    }
+
     void accept(VisitorType &v) override;
 };
 
@@ -69,6 +124,9 @@ st_node *st_continue_node_set_label(st_node *node, char *label);
 
 const char *st_continue_node_get_label(st_node *node);
 
+/// \returns scope of target RecurNode, or -1 if not bound (see st_node_bind_recur).
+int st_continue_node_get_scope(st_node *node);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -70,8 +70,10 @@ class InteractionNodeTmpl : public BaseNode {
     /// \param[in] msgsig of InteractionNode to replace with.
     void set_msg(MessageType *msg)
     {
+        this->check_mutable();
         if (msg_) delete msg_;
         msg_ = msg->clone();
+        this->touch();
     }
 
     /// \returns message signature of InteractionNode.
@@ -83,8 +85,10 @@ class InteractionNodeTmpl : public BaseNode {
     /// \param[in] from Role of InteractionNode.
     void set_sndr(RoleType *sndr)
     {
+        this->check_mutable();
         if (sndr_) delete sndr_;
         sndr_ = sndr->clone();
+        this->touch();
     }
 
     /// \returns <tt>from</tt> Role of InteractionNode.
@@ -96,14 +100,18 @@ class InteractionNodeTmpl : public BaseNode {
     /// \brief Remove from Role.
     void remove_sndr()
     {
+        this->check_mutable();
         delete sndr_;
         sndr_ = nullptr;
+        this->touch();
     }
 
     /// \param[in] to Role to add to this InteractionNode.
     void add_rcvr(RoleType *rcvr)
     {
+        this->check_mutable();
         rcvrs_.push_back(rcvr->clone());
+        this->touch();
     }
 
     /// \returns number of <tt>to</tt> Role.
@@ -128,10 +136,12 @@ class InteractionNodeTmpl : public BaseNode {
     /// \brief Remove to Role (all of them);
     void remove_rcvrs()
     {
+        this->check_mutable();
         for (auto rcvr : rcvrs_) {
             delete rcvr;
         }
         rcvrs_.clear();
+        this->touch();
     }
 
     /// \brief Start iterator for to Role.
@@ -146,6 +156,29 @@ class InteractionNodeTmpl : public BaseNode {
         return rcvrs_.end();
     }
 
+    /// \returns revision stamp of InteractionNode, including its MsgSig and Roles.
+    unsigned long revision() const override
+    {
+        unsigned long revision = std::max(BaseNode::revision(), msg_->revision());
+        if (sndr_ != nullptr) {
+            revision = std::max(revision, sndr_->revision());
+        }
+        return this->max_revision(revision, rcvrs_.begin(), rcvrs_.end());
+    }
+
+    /// \brief Make InteractionNode, its MsgSig and Roles immutable.
+    void freeze() override
+    {
+        BaseNode::freeze();
+        msg_->freeze();
+        if (sndr_ != nullptr) {
+            sndr_->freeze();
+        }
+        for (auto rcvr : rcvrs_) {
+            rcvr->freeze();
+        }
+    }
+
     void accept(VisitorType &v) override;
 };
 
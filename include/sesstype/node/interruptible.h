@@ -94,7 +94,9 @@ class InterruptibleNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageTy
     /// \param[in] scope_name to set for this interrupt.
     void set_scope(std::string scope)
     {
+        this->check_mutable();
         scope_ = scope;
+        this->touch();
     }
 
     /// \returns scope name of interrupt.
@@ -108,7 +110,9 @@ class InterruptibleNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageTy
     /// \param[in] msg as an interrupt message.
     void add_interrupt(RoleType *role, MessageType *msg)
     {
+        this->check_mutable();
         interrupts_.insert({ role, msg });
+        this->touch();
     }
 
     /// \returns total number of interruptible rules.
@@ -158,7 +162,9 @@ class InterruptibleNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageTy
     /// \param[in] msg as an interrupt message.
     void add_throw(RoleType *role, MessageType *msg)
     {
+        this->check_mutable();
         throws_.insert({ role, msg });
+        this->touch();
     }
 
     /// \returns total number of throw rules.
@@ -209,7 +215,9 @@ class InterruptibleNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageTy
     /// \param[in] msg as an interrupt message.
     void add_catch(RoleType *role, MessageType *msg)
     {
+        this->check_mutable();
         catches_.insert({ role, msg });
+        this->touch();
     }
 
     /// \returns total number of catch rules.
@@ -254,6 +262,32 @@ class InterruptibleNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageTy
         return catches_.end();
     }
 
+    /// \returns revision stamp of InterruptibleNode, including the Roles and
+    ///          MsgSigs of its interrupts, throws and catches.
+    unsigned long revision() const override
+    {
+        unsigned long revision = BaseNode::revision();
+        for (auto *interrupts : { &interrupts_, &throws_, &catches_ }) {
+            for (auto &interrupt : *interrupts) {
+                revision = std::max(revision, interrupt.first->revision());
+                revision = std::max(revision, interrupt.second->revision());
+            }
+        }
+        return revision;
+    }
+
+  protected:
+    void freeze_parts() override
+    {
+        for (auto *interrupts : { &interrupts_, &throws_, &catches_ }) {
+            for (auto &interrupt : *interrupts) {
+                interrupt.first->freeze();
+                interrupt.second->freeze();
+            }
+        }
+    }
+
+  public:
     void accept(VisitorType &v) override;
 };
 
@@ -78,7 +78,9 @@ class NestedNodeTmpl : public BaseNode {
     /// \param[in] scope_name to use for this NestedNode
     void set_scope(std::string scope)
     {
+        this->check_mutable();
         scope_ = scope;
+        this->touch();
     }
 
     /// \returns scope name.
@@ -91,7 +93,9 @@ class NestedNodeTmpl : public BaseNode {
     /// \param[in] arg for instantiation of message parameter.
     void add_arg(MessageType *msg)
     {
+        this->check_mutable();
         args_.push_back(msg);
+        this->touch();
     }
 
     /// \returns number of Message arguments.
@@ -119,7 +123,9 @@ class NestedNodeTmpl : public BaseNode {
     /// \param[in] role for instantiation of protocol.
     void add_arg(RoleType *role)
     {
+        this->check_mutable();
         role_args_.push_back(role);
+        this->touch();
     }
 
     /// \returns number of Role arguments.
@@ -144,6 +150,26 @@ class NestedNodeTmpl : public BaseNode {
         return role_args_.end();
     }
 
+    /// \returns revision stamp of NestedNode, including its arguments.
+    unsigned long revision() const override
+    {
+        unsigned long revision = BaseNode::revision();
+        revision = this->max_revision(revision, args_.begin(), args_.end());
+        return this->max_revision(revision, role_args_.begin(), role_args_.end());
+    }
+
+    /// \brief Make NestedNode and its arguments immutable.
+    void freeze() override
+    {
+        BaseNode::freeze();
+        for (auto arg : args_) {
+            arg->freeze();
+        }
+        for (auto role_arg : role_args_) {
+            role_arg->freeze();
+        }
+    }
+
     void accept(VisitorType &v) override;
 };
 
@@ -46,7 +46,9 @@ class RecurNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
     /// \param[in] label of RecurNode to replace with.
     void set_label(std::string label)
     {
+        this->check_mutable();
         label_ = label;
+        this->touch();
     }
 
     /// \returns label of RecursionNode.
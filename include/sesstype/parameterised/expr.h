@@ -159,6 +159,9 @@ st_expr *st_expr_mk_binary(st_expr *lhs, int type, st_expr *rhs);
 st_expr *st_expr_copy(const st_expr *e);
 
 /// \brief Test if two expressions are identical.
+///
+/// Expressions are compared by their canonical form (see st_expr_eval), so
+/// i+1+1 and 2+i are identical.
 /// \param[in] e0 Expression to compare.
 /// \param[in] e1 Expression to compare.
 /// \returns true if identical, false otherwise.
@@ -166,7 +169,8 @@ bool st_expr_is_identical(st_expr *e0, st_expr *e1);
 
 /// \brief Evaluate an expression.
 ///
-/// Simplify mathematical expressions and return a canonical form if possible.
+/// Simplify mathematical expressions and return a canonical form: a sum of
+/// monomials ordered by descending degree, with the constant term last.
 /// \param[in,out] e Expression to evaluate.
 /// \returns pointer to dynamically allocated, simplified expression.
 st_expr *st_expr_eval(st_expr *const e);
@@ -14,7 +14,7 @@ class LogExpr : public Expr {
     Expr *base_;
 
   public:
-    LogExpr(Expr *val, Expr *base) : Expr(ST_EXPR_LOG), value_(), base_() { }
+    LogExpr(Expr *val, Expr *base) : Expr(ST_EXPR_LOG), value_(val), base_(base) { }
 
     LogExpr(const LogExpr &expr)
         : Expr(ST_EXPR_LOG), value_(expr.value_->clone()), base_(expr.base_->clone()) { }
@@ -49,8 +49,10 @@ class ModuleTmpl : public sesstype::ModuleTmpl<ImportType, SessionType> {
     }
 
     /// \param[in] constant to add to Module.
+    /// \exception std::logic_error if Module is frozen.
     void add_constant(ConstantType *c)
     {
+        this->check_mutable();
         consts_.insert({ c->name(), c });
     }
 
@@ -38,8 +38,8 @@ class MsgPayload : public sesstype::MsgPayload {
     MsgPayload(const MsgPayload &payload)
         : sesstype::MsgPayload(payload), param_()
     {
-        for (auto param : param_) {
-            param_.emplace_back(param);
+        for (auto param : payload.param_) {
+            param_.push_back(param->clone());
         }
     }
 
@@ -51,6 +51,11 @@ class MsgPayload : public sesstype::MsgPayload {
         }
     }
 
+    MsgPayload *clone() const override
+    {
+        return new MsgPayload(*this);
+    }
+
     /// \returns number of dimensions in MsgPayload.
     unsigned int num_dimens() const
     {
@@ -61,7 +66,9 @@ class MsgPayload : public sesstype::MsgPayload {
     /// \param[in] expr to use as new parameter.
     void add_param(Expr *param)
     {
+        check_mutable();
         param_.push_back(param);
+        touch();
     }
 
     /// \brief Get parameter at dimension <tt>idx</tt> using [] notation.
@@ -71,6 +78,18 @@ class MsgPayload : public sesstype::MsgPayload {
     {
         return param_.at(idx);
     }
+
+    /// \brief Replace parameter at dimension <tt>idx</tt>.
+    /// \param[in] idx of the parameter.
+    /// \param[in] param to replace with (takes ownership).
+    void set_param(unsigned int idx, Expr *param)
+    {
+        check_mutable();
+        Expr *&current = param_.at(idx);
+        delete current;
+        current = param;
+        touch();
+    }
 };
 
 using MsgSig = sesstype::MsgSig;
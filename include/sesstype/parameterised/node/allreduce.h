@@ -44,7 +44,9 @@ class AllReduceNodeTmpl : public BaseNode {
     /// \param[in] msgsig to replace with.
     void set_msg(MessageType *msg)
     {
+        this->check_mutable();
         msg_ = msg;
+        this->touch();
     }
 
     /// \returns message signature of AllReduceNode.
@@ -53,6 +55,22 @@ class AllReduceNodeTmpl : public BaseNode {
         return msg_;
     }
 
+    /// \returns revision stamp of AllReduceNode, including its MsgSig.
+    unsigned long revision() const override
+    {
+        unsigned long revision = BaseNode::revision();
+        return msg_ != nullptr ? std::max(revision, msg_->revision()) : revision;
+    }
+
+    /// \brief Make AllReduceNode and its MsgSig immutable.
+    void freeze() override
+    {
+        BaseNode::freeze();
+        if (msg_ != nullptr) {
+            msg_->freeze();
+        }
+    }
+
     virtual void accept(VisitorType &v) override;
 };
 
@@ -36,8 +36,9 @@ class ForNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visito
 
     /// \brief ForNode copy constructor.
     ForNodeTmpl(const ForNodeTmpl &node)
-        : BlockNodeTmpl<BaseNode, RoleType, MessageType, VisitorType>(ST_NODE_FOR),
-          bindexpr_(node.bindexpr_), except_(node.except_) { }
+        : BlockNodeTmpl<BaseNode, RoleType, MessageType, VisitorType>(node),
+          bindexpr_(node.bindexpr_ ? node.bindexpr_->clone() : nullptr),
+          except_(node.except_ ? node.except_->clone() : nullptr) { }
 
     /// \brief ForNode destructor.
     ~ForNodeTmpl() override
@@ -56,8 +57,10 @@ class ForNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visito
     /// \param[in] bind_expr to replace with.
     void set_bindexpr(RngExpr *bindexpr)
     {
+        this->check_mutable();
         delete bindexpr_;
         bindexpr_ = bindexpr;
+        this->touch();
     }
 
     /// \returns binding expression of the for-loop.
@@ -71,8 +74,10 @@ class ForNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visito
 
     void set_except(Expr *except)
     {
+        this->check_mutable();
         delete except_;
         except_ = except;
+        this->touch();
     }
 
     Expr *except() const
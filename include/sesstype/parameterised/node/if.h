@@ -33,7 +33,7 @@ class IfNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visitor
     /// \brief IfNode copy constructor.
     IfNodeTmpl(const IfNodeTmpl &node)
         : BlockNodeTmpl<BaseNode, RoleType, MessageType, VisitorType>(node),
-          cond_(node.cond_) { }
+          cond_(node.cond_ ? node.cond_->clone() : nullptr) { }
 
     /// \brief IfNode destructor.
     ~IfNodeTmpl() override
@@ -72,9 +72,29 @@ class IfNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visitor
     /// \param[in] cond for the if-block.
     void set_cond(MsgCond *cond)
     {
+        this->check_mutable();
+        delete cond_;
         cond_ = cond;
+        this->touch();
     }
 
+    /// \returns revision stamp of IfNode, including its condition.
+    unsigned long revision() const override
+    {
+        unsigned long revision = BaseNode::revision();
+        return cond_ != nullptr ? std::max(revision, cond_->revision()) : revision;
+    }
+
+  protected:
+    void freeze_parts() override
+    {
+        if (cond_ != nullptr) {
+            cond_->freeze();
+        }
+    }
+
+  public:
+
     void virtual accept(VisitorType &v) override;
 };
 
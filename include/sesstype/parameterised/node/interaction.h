@@ -50,10 +50,29 @@ class InteractionNode
     /// \param[in] cond for InteractionNode.
     void set_cond(MsgCond *cond)
     {
+        this->check_mutable();
         if (cond_ != nullptr) {
             delete cond_;
         }
         cond_ = cond;
+        this->touch();
+    }
+
+    /// \returns revision stamp of InteractionNode, including its condition.
+    unsigned long revision() const override
+    {
+        using Base = InteractionNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>;
+        unsigned long revision = Base::revision();
+        return cond_ != nullptr ? std::max(revision, cond_->revision()) : revision;
+    }
+
+    /// \brief Make InteractionNode, its MsgSig, Roles and condition immutable.
+    void freeze() override
+    {
+        InteractionNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::freeze();
+        if (cond_ != nullptr) {
+            cond_->freeze();
+        }
     }
 
     virtual void accept(util::NodeVisitor &v) override;
@@ -50,10 +50,18 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
         : BlockNodeTmpl<BaseNode, RoleType, MessageType, VisitorType>(node),
           selector_role_(node.selector_role_),
           selector_dimen_(node.selector_dimen_),
-          range_(),
-          var_(),
-          unordered_(false),
-          repeat_(false) { }
+          range_(node.range_ ? node.range_->clone() : nullptr),
+          var_(node.var_),
+          unordered_(node.unordered_),
+          repeat_(node.repeat_) { }
+
+    /// \brief OneofNode destructor.
+    ///
+    /// The selector Role is not owned by the OneofNode.
+    ~OneofNodeTmpl() override
+    {
+        delete range_;
+    }
 
     /// \brief clone a OneofNode.
     OneofNodeTmpl *clone() const override
@@ -64,7 +72,9 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
     /// \param[in] var to be used as existential variable name.
     void set_var(std::string var)
     {
+        this->check_mutable();
         var_ = var;
+        this->touch();
     }
 
     /// \returns existential variable.
@@ -76,7 +86,9 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
     /// \param[in] repeat boolean to indicate whether or not this is "repeat".
     void set_repeat(bool repeat)
     {
+        this->check_mutable();
         repeat_ = repeat;
+        this->touch();
     }
 
     /// \return true if this is a repeat-oneof.
@@ -88,7 +100,10 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
     /// \param[in] range without variable.
     void set_range(RngExpr *range)
     {
+        this->check_mutable();
+        delete range_;
         range_ = range;
+        this->touch();
     }
 
     /// \return range of selection.
@@ -101,8 +116,10 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
     /// \param[in] dimen of the Role parameters to use as selector index domain.
     void set_selector(RoleType *selector, unsigned int dimen)
     {
+        this->check_mutable();
         selector_role_ = selector;
         selector_dimen_ = dimen;
+        this->touch();
     }
 
     /// \returns selector Role.
@@ -120,7 +137,9 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
     /// \param[in] unordered flag.
     void set_unordered(bool unordered)
     {
+        this->check_mutable();
         unordered_ = unordered;
+        this->touch();
     }
 
     /// \returns true if allow unordered access.
@@ -129,6 +148,26 @@ class OneofNodeTmpl : public BlockNodeTmpl<BaseNode, RoleType, MessageType, Visi
         return unordered_;
     }
 
+    /// \returns revision stamp of OneofNode, including its selector Role.
+    unsigned long revision() const override
+    {
+        unsigned long revision = BaseNode::revision();
+        if (selector_role_ != nullptr) {
+            revision = std::max(revision, selector_role_->revision());
+        }
+        return revision;
+    }
+
+  protected:
+    void freeze_parts() override
+    {
+        if (selector_role_ != nullptr) {
+            selector_role_->freeze();
+        }
+    }
+
+  public:
+
     virtual void accept(VisitorType &v) override;
 };
 
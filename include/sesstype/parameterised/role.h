@@ -70,7 +70,22 @@ class Role : public sesstype::Role {
     /// \param[in] param Adds parameter as a new dimension to the Role.
     void add_param(Expr *param)
     {
+        check_mutable();
         param_.push_back(param);
+        touch();
+    }
+
+    /// \brief Replace the parameter at dimension idx.
+    /// \param[in] idx Dimension index of parameterised Role.
+    /// \param[in] param Expr to replace with (takes ownership).
+    /// \exception std::out_of_range if dimension idx does not exist.
+    void set_param(std::size_t idx, Expr *param)
+    {
+        check_mutable();
+        Expr *&current = param_.at(idx);
+        delete current;
+        current = param;
+        touch();
     }
 
     /// \param[in] idx Dimension index of parameterised Role.
@@ -40,6 +40,24 @@ class SessionTmpl : public sesstype::SessionTmpl<NodeType, RoleType> {
     SessionTmpl(std::string name)
         : sesstype::SessionTmpl<NodeType, RoleType>(name), groups_() { }
 
+    /// Session copy constructor, Roles, RoleGrps and body are deep copied.
+    SessionTmpl(const SessionTmpl &session)
+        : sesstype::SessionTmpl<NodeType, RoleType>(session), groups_()
+    {
+        for (auto grp_pair : session.groups_) {
+            add_group(grp_pair.second->clone());
+        }
+    }
+
+    /// Session copy constructor with a replacement body.
+    SessionTmpl(const SessionTmpl &session, NodeType *root)
+        : sesstype::SessionTmpl<NodeType, RoleType>(session, root), groups_()
+    {
+        for (auto grp_pair : session.groups_) {
+            add_group(grp_pair.second->clone());
+        }
+    }
+
     /// Session destructor.
     virtual ~SessionTmpl()
     {
@@ -65,8 +83,10 @@ class SessionTmpl : public sesstype::SessionTmpl<NodeType, RoleType> {
 
     /// Add a RoleGrp as a participant of the Session.
     /// \param[in] group to add to this Session.
+    /// \exception std::logic_error if Session is frozen.
     void add_group(RoleGrpType *group)
     {
+        this->check_mutable();
         groups_.insert(std::pair<std::string, RoleGrpType *>(group->name(), group));
     }
 
@@ -5,10 +5,19 @@
 #ifndef SESSTYPE__PARAMETERISED__UTIL_H__
 #define SESSTYPE__PARAMETERISED__UTIL_H__
 
+#include "sesstype/parameterised/util/comm_graph.h"
 #include "sesstype/parameterised/util/expr_apply.h"
+#include "sesstype/parameterised/util/expr_canon.h"
 #include "sesstype/parameterised/util/expr_eval.h"
 #include "sesstype/parameterised/util/expr_invert.h"
+#include "sesstype/parameterised/util/graph_export.h"
+#include "sesstype/parameterised/util/msg_count.h"
+#include "sesstype/parameterised/util/placement.h"
 #include "sesstype/parameterised/util/print.h"
 #include "sesstype/parameterised/util/project.h"
+#include "sesstype/parameterised/util/range_set.h"
+#include "sesstype/parameterised/util/role_layout.h"
+#include "sesstype/parameterised/util/specialise.h"
+#include "sesstype/parameterised/util/traversal.h"
 
 #endif//SESSTYPE__PARAMETERISED__UTIL_H__
@@ -0,0 +1,155 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__COMM_GRAPH_H__
+#define SESSTYPE__PARAMETERISED__UTIL__COMM_GRAPH_H__
+
+#ifdef __cplusplus
+#include <map>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/msg_count.h"
+#include "sesstype/parameterised/util/role_layout.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Rank-to-rank communication graph of a Session for known constants.
+ *
+ * Every instance of every Role is a rank: Roles are numbered in order of
+ * name, and the instances of a Role (e.g. W[1..N][1..M]) are numbered by
+ * its RoleLayout (row-major unless set_layout_order is used). An edge
+ * src -> dst is weighted by the number of messages and bytes sent from src
+ * to dst.
+ *
+ * The graph is built directly from the InteractionNodes of the Session and
+ * the ranges of their enclosing ForNodes, without unrolling the tree. Each
+ * index expression is compiled once, and the iteration space of each
+ * interaction is split between worker threads. Each worker merges its
+ * messages per (src, dst) as they are enumerated, so memory is bounded by
+ * the number of distinct edges, not messages. The graph is stored in
+ * compressed sparse row (CSR) form: the edges of rank r are
+ * [row_offsets()[r], row_offsets()[r+1]) of columns(), msgs() and bytes(),
+ * sorted by destination.
+ *
+ * Like MsgCount, all branches of a choice are included, recursion bodies
+ * are counted once, and a oneof is counted as if every index were
+ * selected. Interactions with an index outside of its Role are dropped.
+ * Nested protocols and allreduce are not included.
+ *
+ * Iterations of a ForNode whose loop variable equals its except() value
+ * (or lies in its except() range) are skipped. An InteractionNode with a
+ * cond() is only sent in iterations where the instance of the sender or
+ * receiver named by the condition is within its indices, e.g.
+ * <tt>if W[2..N]</tt>. Messages skipped this way are not counted in
+ * num_dropped().
+ */
+class CommGraph {
+    std::vector<std::string> roles_;
+    std::vector<RoleLayout> layouts_;
+    std::vector<unsigned long> role_offsets_;       // First rank per Role.
+    std::vector<unsigned long> row_offsets_;
+    std::vector<unsigned long> columns_;
+    std::vector<unsigned long> msgs_;
+    std::vector<unsigned long> bytes_;
+    unsigned long num_dropped_;
+    unsigned int num_threads_;
+    unsigned int layout_order_;
+
+  public:
+    CommGraph();
+
+    CommGraph(const CommGraph &) = delete;
+    CommGraph &operator=(const CommGraph &) = delete;
+
+    /// \param[in] num_threads maximum number of worker threads (0 for auto).
+    void set_num_threads(unsigned int num_threads)
+    {
+        num_threads_ = num_threads;
+    }
+
+    /// \param[in] order ST_LAYOUT_ROW_MAJOR or ST_LAYOUT_COL_MAJOR for the next build.
+    void set_layout_order(unsigned int order)
+    {
+        layout_order_ = order;
+    }
+
+    /// \brief Build the communication graph of session (replaces any previous graph).
+    /// \param[in] session global Session.
+    /// \param[in] constants values of the free variables of session.
+    /// \param[in] sizes of payload types.
+    /// \exception std::invalid_argument if a Role or loop bound, or an index,
+    ///            does not evaluate for the given constants, or if a
+    ///            condition names a Role outside of its interaction.
+    void build(const Session &session, const std::map<std::string, long> &constants,
+            const TypeSizeTable &sizes = TypeSizeTable());
+
+    unsigned long num_ranks() const
+    {
+        return row_offsets_.empty() ? 0 : row_offsets_.size() - 1;
+    }
+
+    unsigned long num_edges() const
+    {
+        return columns_.size();
+    }
+
+    /// \returns number of messages dropped because an index was out of range.
+    unsigned long num_dropped() const
+    {
+        return num_dropped_;
+    }
+
+    const std::vector<unsigned long> &row_offsets() const
+    {
+        return row_offsets_;
+    }
+
+    const std::vector<unsigned long> &columns() const
+    {
+        return columns_;
+    }
+
+    const std::vector<unsigned long> &msgs() const
+    {
+        return msgs_;
+    }
+
+    const std::vector<unsigned long> &bytes() const
+    {
+        return bytes_;
+    }
+
+    /// \returns layout of the instances of role.
+    /// \exception std::out_of_range if the Role does not exist.
+    const RoleLayout &layout(const std::string &role) const;
+
+    /// \returns index of edge src -> dst in columns(), or num_edges() if none.
+    unsigned long find_edge(unsigned long src, unsigned long dst) const;
+
+    /// \returns rank of an instance of a Role.
+    /// \exception std::out_of_range if the Role or index does not exist.
+    unsigned long rank(const std::string &role, const std::vector<long> &index = { }) const;
+
+    /// \returns name of the Role of rank.
+    /// \exception std::out_of_range if rank does not exist.
+    std::string role(unsigned long rank) const;
+
+    /// \returns index of rank in its Role.
+    /// \exception std::out_of_range if rank does not exist.
+    std::vector<long> index(unsigned long rank) const;
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__COMM_GRAPH_H__
@@ -0,0 +1,422 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__EXPR_CANON_H__
+#define SESSTYPE__PARAMETERISED__UTIL__EXPR_CANON_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <stack>
+#include <string>
+#include <utility>
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/util/expr_visitor.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Canonicalise an Expr into sorted polynomial form.
+ *
+ * Arithmetic (+, -, * and << by a constant) is normalised into a sum of
+ * monomials with integer coefficients over variables, so that (i+1)+1
+ * becomes i+2, i-i becomes 0 and 2*(i+N)-N becomes N+2*i. Subexpressions
+ * that are not polynomial (/, %, >>, log, ranges and sequences) are
+ * canonicalised recursively and treated as opaque atoms, except where
+ * they fold exactly (constant operands, or a divisor which divides every
+ * coefficient).
+ *
+ * The output is deterministic: terms are ordered by descending degree and
+ * then by factors (variables by name, then opaque atoms), with the
+ * constant term last. Two expressions which canonicalise to the same key()
+ * are equal for all values of their variables.
+ *
+ * Variables with a known value (e.g. ValueConstants) can be substituted
+ * while canonicalising, so all constant arithmetic is folded in one pass.
+ */
+class ExprCanon : public ExprVisitor {
+  public:
+    /// \brief Factor (atom key) and exponent.
+    typedef std::vector<std::pair<std::string, unsigned int>> Monomial;
+
+    /// \brief Sum of monomials with non-zero coefficients.
+    typedef std::map<Monomial, long> Poly;
+
+    /// \brief Products with more terms than this are kept unexpanded.
+    static const unsigned int max_terms = 64;
+
+  private:
+    std::stack<Poly> stack_;
+    std::map<std::string, Expr *> atoms_; // Atom key -> canonical Expr.
+    std::map<std::string, long> values_;
+
+  public:
+    ExprCanon() : stack_(), atoms_(), values_() { }
+
+    /// \brief ExprCanon constructor.
+    /// \param[in] values of variables to substitute.
+    ExprCanon(const std::map<std::string, long> &values)
+        : stack_(), atoms_(), values_(values) { }
+
+    ExprCanon(const ExprCanon &) = delete;
+    ExprCanon &operator=(const ExprCanon &) = delete;
+
+    ~ExprCanon()
+    {
+        for (auto &atom : atoms_) {
+            delete atom.second;
+        }
+    }
+
+    /// \returns canonical form of the last visited Expr (dynamically allocated).
+    Expr *canon()
+    {
+        return to_expr(stack_.top());
+    }
+
+    /// \returns unique textual key of the canonical form of the last visited Expr.
+    std::string key()
+    {
+        return poly_key(stack_.top());
+    }
+
+    /// \returns true if e0 and e1 have the same canonical form.
+    static bool is_identical(Expr *e0, Expr *e1)
+    {
+        ExprCanon c0, c1;
+        e0->accept(c0);
+        e1->accept(c1);
+        return c0.key() == c1.key();
+    }
+
+    virtual void visit(Expr *expr) override
+    {
+        atom("~expr" + std::to_string(expr->type()), expr->clone());
+    }
+
+    virtual void visit(VarExpr *expr) override
+    {
+        auto it = values_.find(expr->name());
+        if (it != values_.end()) {
+            stack_.push(constant(it->second));
+            return;
+        }
+        atom(expr->name(), expr->clone());
+    }
+
+    virtual void visit(ValExpr *expr) override
+    {
+        stack_.push(constant(expr->num()));
+    }
+
+    virtual void visit(AddExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        add(lhs, rhs, 1);
+        stack_.push(lhs);
+    }
+
+    virtual void visit(SubExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        add(lhs, rhs, -1);
+        stack_.push(lhs);
+    }
+
+    virtual void visit(MulExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        if (lhs.size() * rhs.size() > max_terms) {
+            opaque("mul", new MulExpr(to_expr(lhs), to_expr(rhs)), lhs, rhs);
+            return;
+        }
+        stack_.push(mul(lhs, rhs));
+    }
+
+    virtual void visit(DivExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        long c;
+        if (is_constant(rhs, c) && c != 0) {
+            long n;
+            if (is_constant(lhs, n)) {
+                stack_.push(constant(n / c));
+                return;
+            }
+            if (divides(c, lhs)) {
+                for (auto &term : lhs) {
+                    term.second /= c;
+                }
+                stack_.push(lhs);
+                return;
+            }
+        }
+        opaque("div", new DivExpr(to_expr(lhs), to_expr(rhs)), lhs, rhs);
+    }
+
+    virtual void visit(ModExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        long c;
+        if (is_constant(rhs, c) && c != 0) {
+            long n;
+            if (is_constant(lhs, n)) {
+                stack_.push(constant(n % c));
+                return;
+            }
+            if (divides(c, lhs)) {
+                stack_.push(Poly());
+                return;
+            }
+        }
+        opaque("mod", new ModExpr(to_expr(lhs), to_expr(rhs)), lhs, rhs);
+    }
+
+    virtual void visit(ShlExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        long c;
+        if (is_constant(rhs, c) && c >= 0 && c < 31) {
+            stack_.push(mul(lhs, constant(1L << c)));
+            return;
+        }
+        opaque("shl", new ShlExpr(to_expr(lhs), to_expr(rhs)), lhs, rhs);
+    }
+
+    virtual void visit(ShrExpr *expr) override
+    {
+        Poly lhs = operand(expr->lhs());
+        Poly rhs = operand(expr->rhs());
+        long c, n;
+        if (is_constant(rhs, c) && c >= 0 && c < 31) {
+            if (c == 0) {
+                stack_.push(lhs);
+                return;
+            }
+            if (is_constant(lhs, n)) {
+                stack_.push(constant(n >> c));
+                return;
+            }
+        }
+        opaque("shr", new ShrExpr(to_expr(lhs), to_expr(rhs)), lhs, rhs);
+    }
+
+    virtual void visit(SeqExpr *expr) override
+    {
+        std::string key = "~seq(";
+        for (auto it=expr->seq_begin(); it!=expr->seq_end(); it++) {
+            key += std::to_string(*it) + ",";
+        }
+        atom(key + ")", expr->clone());
+    }
+
+    virtual void visit(RngExpr *expr) override
+    {
+        Poly from = operand(expr->from());
+        Poly to = operand(expr->to());
+        opaque("rng:" + expr->bindvar(),
+                new RngExpr(expr->bindvar(), to_expr(from), to_expr(to)), from, to);
+    }
+
+    virtual void visit(LogExpr *expr) override
+    {
+        Poly value = operand(expr->value());
+        Poly base = operand(expr->base());
+        opaque("log", new LogExpr(to_expr(value), to_expr(base)), value, base);
+    }
+
+  private:
+    Poly operand(Expr *expr)
+    {
+        expr->accept(*this);
+        Poly poly = stack_.top();
+        stack_.pop();
+        return poly;
+    }
+
+    static Poly constant(long num)
+    {
+        Poly poly;
+        if (num != 0) {
+            poly[Monomial()] = num;
+        }
+        return poly;
+    }
+
+    static bool is_constant(const Poly &poly, long &num)
+    {
+        if (poly.empty()) {
+            num = 0;
+            return true;
+        }
+        if (poly.size() == 1 && poly.begin()->first.empty()) {
+            num = poly.begin()->second;
+            return true;
+        }
+        return false;
+    }
+
+    /// \returns true if c divides every coefficient of poly.
+    static bool divides(long c, const Poly &poly)
+    {
+        for (auto &term : poly) {
+            if (term.second % c != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief lhs += sign * rhs.
+    static void add(Poly &lhs, const Poly &rhs, long sign)
+    {
+        for (auto &term : rhs) {
+            long &coeff = lhs[term.first];
+            coeff += sign * term.second;
+            if (coeff == 0) {
+                lhs.erase(term.first);
+            }
+        }
+    }
+
+    static Poly mul(const Poly &lhs, const Poly &rhs)
+    {
+        Poly product;
+        for (auto &l : lhs) {
+            for (auto &r : rhs) {
+                Monomial mono;
+                auto li = l.first.begin(), ri = r.first.begin();
+                while (li != l.first.end() || ri != r.first.end()) {
+                    if (ri == r.first.end() || (li != l.first.end() && li->first < ri->first)) {
+                        mono.push_back(*li++);
+                    } else if (li == l.first.end() || ri->first < li->first) {
+                        mono.push_back(*ri++);
+                    } else {
+                        mono.push_back({ li->first, li->second + ri->second });
+                        li++;
+                        ri++;
+                    }
+                }
+                add(product, Poly { { mono, l.second * r.second } }, 1);
+            }
+        }
+        return product;
+    }
+
+    /// \brief Push atom with key (takes ownership of expr).
+    void atom(const std::string &key, Expr *expr)
+    {
+        auto it = atoms_.find(key);
+        if (it == atoms_.end()) {
+            atoms_[key] = expr;
+        } else {
+            delete expr;
+        }
+        Poly poly;
+        poly[Monomial { { key, 1 } }] = 1;
+        stack_.push(poly);
+    }
+
+    /// \brief Push an opaque atom built from canonical operands.
+    void opaque(const std::string &op, Expr *expr, const Poly &lhs, const Poly &rhs)
+    {
+        // Opaque keys start with ~ so they sort after variable names.
+        atom("~" + op + "(" + poly_key(lhs) + "," + poly_key(rhs) + ")", expr);
+    }
+
+    static unsigned int degree(const Monomial &mono)
+    {
+        unsigned int deg = 0;
+        for (auto &factor : mono) {
+            deg += factor.second;
+        }
+        return deg;
+    }
+
+    /// \returns terms of poly in output order.
+    static std::vector<Poly::const_iterator> ordered(const Poly &poly)
+    {
+        std::vector<Poly::const_iterator> terms;
+        for (auto it=poly.begin(); it!=poly.end(); it++) {
+            terms.push_back(it);
+        }
+        std::stable_sort(terms.begin(), terms.end(),
+                [](Poly::const_iterator a, Poly::const_iterator b) {
+                    return degree(a->first) > degree(b->first);
+                });
+        return terms;
+    }
+
+    static std::string poly_key(const Poly &poly)
+    {
+        std::string key;
+        for (auto it : ordered(poly)) {
+            key += (it->second < 0 ? "" : "+") + std::to_string(it->second);
+            for (auto &factor : it->first) {
+                key += "*" + factor.first;
+                if (factor.second > 1) {
+                    key += "^" + std::to_string(factor.second);
+                }
+            }
+        }
+        return key.empty() ? "0" : key;
+    }
+
+    Expr *monomial_expr(const Monomial &mono)
+    {
+        Expr *expr = nullptr;
+        for (auto &factor : mono) {
+            for (unsigned int i=0; i<factor.second; i++) {
+                Expr *f = atoms_.at(factor.first)->clone();
+                expr = expr == nullptr ? f : new MulExpr(expr, f);
+            }
+        }
+        return expr;
+    }
+
+    Expr *to_expr(const Poly &poly)
+    {
+        Expr *expr = nullptr;
+        for (auto it : ordered(poly)) {
+            long coeff = it->second;
+            Expr *term;
+            if (it->first.empty()) {
+                term = new ValExpr(expr == nullptr ? coeff : std::labs(coeff));
+            } else {
+                term = monomial_expr(it->first);
+                long factor = expr == nullptr ? coeff : std::labs(coeff);
+                if (factor != 1) {
+                    term = new MulExpr(new ValExpr(factor), term);
+                }
+            }
+            if (expr == nullptr) {
+                expr = term;
+            } else if (coeff < 0) {
+                expr = new SubExpr(expr, term);
+            } else {
+                expr = new AddExpr(expr, term);
+            }
+        }
+        return expr == nullptr ? new ValExpr(0) : expr;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__EXPR_CANON_H__
@@ -18,6 +18,8 @@
 #include "sesstype/parameterised/expr/seq.h"
 #include "sesstype/parameterised/expr/rng.h"
 #include "sesstype/parameterised/expr/log.h"
+#include "sesstype/parameterised/util/expr_apply.h"
+#include "sesstype/parameterised/util/expr_canon.h"
 #include "sesstype/parameterised/util/expr_visitor.h"
 
 #ifdef __cplusplus
@@ -31,21 +33,57 @@ namespace util {
  * \brief Given f(x) = y, calculate its mathematical reverse f^-1(y) = x.
  *
  * The general approach is find which binary branch has variable and peel off
- * the other branch until var is reached.
+ * the other branch until var is reached. Where var occurs in both branches
+ * (e.g. 2*x-x) the expression is canonicalised first (see ExprCanon), so
+ * composed affine maps are inverted. The result is canonicalised.
+ *
+ * If the range of var is known, g(x) % m is also invertible when g is
+ * increasing and spans less than m over the range, as for ring neighbours
+ * (x+1) % N with x:0..N-1: the unique g(x) is
+ * g(lo) + (y - g(lo)) mod m, where v mod m = ((v % m) + m) % m.
+ *
+ * Shifts and divisions lose low bits, so the inverse of x >> a (or x / a)
+ * is the smallest x which maps to y.
  */
 class ExprInvert : public ExprVisitor {
     bool error_;
     Expr *reversed_;
     std::string var_;
+    Expr *from_; // Range of var, if known.
+    Expr *to_;
 
   public:
     ExprInvert(std::string var) : error_(false),
                                   reversed_(new VarExpr(var)),
-                                  var_(var) { }
+                                  var_(var),
+                                  from_(nullptr),
+                                  to_(nullptr) { }
+
+    /// \brief ExprInvert constructor with the range of var.
+    /// \param[in] bindexpr binding var to its range.
+    ExprInvert(RngExpr *bindexpr) : error_(false),
+                                    reversed_(new VarExpr(bindexpr->bindvar())),
+                                    var_(bindexpr->bindvar()),
+                                    from_(bindexpr->from()->clone()),
+                                    to_(bindexpr->to()->clone()) { }
+
+    ExprInvert(const ExprInvert &) = delete;
+    ExprInvert &operator=(const ExprInvert &) = delete;
+
+    ~ExprInvert()
+    {
+        delete from_;
+        delete to_;
+    }
 
+    /// \returns inverted expression, or nullptr if not invertible.
     Expr *invert()
     {
         if (is_valid()) {
+            ExprCanon canon;
+            reversed_->accept(canon);
+            delete reversed_;
+            reversed_ = canon.canon();
             return reversed_;
         }
         return nullptr;
@@ -62,6 +100,8 @@ class ExprInvert : public ExprVisitor {
             return (vare->name() == var_);
         } else if (auto bine = dynamic_cast<BinExpr *>(expr)) {
             return ( has_var(bine->lhs()) || has_var(bine->rhs()) );
+        } else if (auto loge = dynamic_cast<LogExpr *>(expr)) {
+            return has_var(loge->value());
         }
         return false;
     }
@@ -81,6 +121,11 @@ class ExprInvert : public ExprVisitor {
 
     virtual void visit(AddExpr *expr) override
     {
+        if (has_var(expr->lhs()) && has_var(expr->rhs())) {
+            visit_canonical(expr);
+            return;
+        }
+
         if (has_var(expr->lhs())) { // x + a = y --> x = y - a
             reversed_ = new SubExpr(reversed_, expr->rhs()->clone());
             expr->lhs()->accept(*this);
@@ -98,6 +143,11 @@ class ExprInvert : public ExprVisitor {
 
     virtual void visit(SubExpr *expr) override
     {
+        if (has_var(expr->lhs()) && has_var(expr->rhs())) {
+            visit_canonical(expr);
+            return;
+        }
+
         if (has_var(expr->lhs())) { // x - a = y --> x = y + a
             reversed_ = new AddExpr(reversed_, expr->rhs()->clone());
             expr->lhs()->accept(*this);
@@ -115,6 +165,11 @@ class ExprInvert : public ExprVisitor {
 
     virtual void visit(MulExpr *expr) override
     {
+        if (has_var(expr->lhs()) && has_var(expr->rhs())) {
+            visit_canonical(expr);
+            return;
+        }
+
         if (has_var(expr->lhs())) { // x * a = y --> x = y / a
             reversed_ = new DivExpr(reversed_, expr->rhs()->clone());
             expr->lhs()->accept(*this);
@@ -123,7 +178,7 @@ class ExprInvert : public ExprVisitor {
 
         if (has_var(expr->rhs())) { // a * x = y --> x = y / a
             reversed_ = new DivExpr(reversed_, expr->lhs()->clone());
-            expr->lhs()->accept(*this);
+            expr->rhs()->accept(*this);
             return;
         }
 
@@ -149,8 +204,47 @@ class ExprInvert : public ExprVisitor {
 
     virtual void visit(ModExpr *expr) override
     {
-        // Cannot reverse %
-        error_ = true;
+        if (from_ == nullptr || !has_var(expr->lhs()) || has_var(expr->rhs())) {
+            error_ = true; // Cannot reverse % without range of var.
+            return;
+        }
+
+        // Image g(from)..g(to) of the range of var.
+        RngExpr bindexpr(var_, from_->clone(), to_->clone());
+        ExprApply applier(&bindexpr);
+        expr->lhs()->accept(applier);
+        auto image = static_cast<RngExpr *>(applier.apply());
+        if (image == nullptr) {
+            error_ = true;
+            return;
+        }
+        // Slope g(x+1)-g(x) must be a positive constant (g increasing and
+        // affine), and g(to)-g(from) less than m.
+        RngExpr step(var_, new AddExpr(new VarExpr(var_), new ValExpr(1)), new VarExpr(var_));
+        ExprApply step_applier(&step);
+        expr->lhs()->accept(step_applier);
+        auto steps = static_cast<RngExpr *>(step_applier.apply());
+        long slope = 0, gap = 0;
+        bool in_period = steps != nullptr
+            && is_constant(SubExpr(steps->from()->clone(), steps->to()->clone()), slope) && slope > 0
+            && is_constant(SubExpr(new SubExpr(image->to()->clone(), image->from()->clone()),
+                        expr->rhs()->clone()), gap) && gap < 0;
+        delete steps;
+        if (!in_period) {
+            delete image;
+            error_ = true; // Not provably within one period.
+            return;
+        }
+
+        // g % m = y --> g = g(from) + ((y - g(from)) % m + m) % m
+        Expr *lo = image->from()->clone();
+        Expr *m = expr->rhs();
+        reversed_ = new AddExpr(lo->clone(),
+                new ModExpr(
+                    new AddExpr(new ModExpr(new SubExpr(reversed_, lo), m->clone()), m->clone()),
+                    m->clone()));
+        delete image;
+        expr->lhs()->accept(*this);
     }
 
     virtual void visit(ShlExpr *expr) override
@@ -172,13 +266,13 @@ class ExprInvert : public ExprVisitor {
 
     virtual void visit(ShrExpr *expr) override
     {
-        if (has_var(expr->lhs())) { // x << a = x / 2^a = y --> x = y * (2^a)
-            reversed_ = new DivExpr(reversed_, new ShlExpr(new ValExpr(1), expr->rhs()->clone()));
+        if (has_var(expr->lhs())) { // x >> a = x / 2^a = y --> x = y << a
+            reversed_ = new ShlExpr(reversed_, expr->rhs()->clone());
             expr->lhs()->accept(*this);
             return;
         }
 
-        if (has_var(expr->rhs())) { // a << x = a / 2^x = y --> log(a / y, 2)
+        if (has_var(expr->rhs())) { // a >> x = a / 2^x = y --> log(a / y, 2)
             reversed_ = new LogExpr(new DivExpr(expr->lhs()->clone(), reversed_), new ValExpr(2));
             expr->rhs()->accept(*this);
             return;
@@ -199,9 +293,44 @@ class ExprInvert : public ExprVisitor {
 
     virtual void visit(LogExpr *expr) override
     {
+        auto base = dynamic_cast<ValExpr *>(expr->base());
+        if (base == nullptr || base->num() != 2 || !has_var(expr->value())) {
+            error_ = true;
+            return;
+        }
+        // log(x, 2) = y --> x = 1 << y
         reversed_ = new ShlExpr(new ValExpr(1), reversed_);
         expr->value()->accept(*this);
     }
+
+  private:
+    /// \brief Invert canonical form of expr, where var is in both branches.
+    void visit_canonical(BinExpr *expr)
+    {
+        ExprCanon canon;
+        expr->accept(canon);
+        Expr *canonical = canon.canon();
+        auto bin = dynamic_cast<BinExpr *>(canonical);
+        if (!has_var(canonical) || (bin != nullptr && has_var(bin->lhs()) && has_var(bin->rhs()))) {
+            error_ = true; // Not affine in var.
+        } else {
+            canonical->accept(*this);
+        }
+        delete canonical;
+    }
+
+    static bool is_constant(BinExpr &&expr, long &val)
+    {
+        ExprCanon canon;
+        expr.accept(canon);
+        Expr *canonical = canon.canon();
+        auto val_expr = dynamic_cast<ValExpr *>(canonical);
+        if (val_expr != nullptr) {
+            val = val_expr->num();
+        }
+        delete canonical;
+        return val_expr != nullptr;
+    }
 };
 #endif // __cplusplus
 
@@ -0,0 +1,75 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__GRAPH_EXPORT_H__
+#define SESSTYPE__PARAMETERISED__UTIL__GRAPH_EXPORT_H__
+
+#ifdef __cplusplus
+#include <sstream>
+#include <string>
+#endif
+
+#include "sesstype/util/graph_export.h"
+#include "sesstype/parameterised/nodes.h"
+#include "sesstype/parameterised/role.h"
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/expr_print.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Communication graph of a parameterised Session.
+ *
+ * With aggregate set, every parameterised Role is a single node named
+ * after the Role with one <tt>[*]</tt> per dimension, so that e.g. all
+ * messages between Worker[i] and Worker[i+1] form a single summary edge
+ * regardless of the number of ranks. Otherwise nodes are named after the
+ * Role with its index expressions, e.g. <tt>Worker[(i+1)]</tt>.
+ *
+ * As in sesstype::util::CommGraph, edges carry static occurrences: ForNode
+ * trip counts are not applied. For the messages exchanged between concrete
+ * ranks with loops unrolled, see CommGraph (comm_graph.h).
+ */
+inline sesstype::util::CommGraph comm_graph(const Session &session, bool aggregate=true)
+{
+    auto role_key = [aggregate](sesstype::Role *base) -> std::string {
+        auto *role = dynamic_cast<Role *>(base);
+        if (role == nullptr || role->num_dimens() == 0) {
+            return base->name();
+        }
+        if (aggregate) {
+            std::string key = role->name();
+            for (unsigned int i=0; i<role->num_dimens(); i++) {
+                key += "[*]";
+            }
+            return key;
+        }
+        std::stringstream ss;
+        ExprPrintVisitor printer(ss);
+        ss << role->name();
+        for (unsigned int i=0; i<role->num_dimens(); i++) {
+            ss << '[';
+            (*role)[i]->accept(printer);
+            ss << ']';
+        }
+        return ss.str();
+    };
+
+    sesstype::util::CommGraph graph;
+    for (auto it=session.role_begin(); it!=session.role_end(); it++) {
+        graph.add_role(role_key(it->second));
+    }
+    graph.add_tree<Node, BlockNode, InteractionNode>(session.root(), role_key);
+    return graph;
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__GRAPH_EXPORT_H__
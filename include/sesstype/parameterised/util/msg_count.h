@@ -0,0 +1,505 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__MSG_COUNT_H__
+#define SESSTYPE__PARAMETERISED__UTIL__MSG_COUNT_H__
+
+#ifdef __cplusplus
+#include <array>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/expr.h"
+#include "sesstype/parameterised/msg.h"
+#include "sesstype/parameterised/node.h"
+#include "sesstype/parameterised/nodes.h"
+#include "sesstype/parameterised/role.h"
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/expr_apply.h"
+#include "sesstype/parameterised/util/expr_canon.h"
+#include "sesstype/parameterised/util/traversal.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Size in bytes of payload types, by MsgPayload::type().
+ *
+ * Common C scalar types are predefined; types which are not in the table
+ * have default_size() (0 unless set).
+ */
+class TypeSizeTable {
+    std::map<std::string, long> sizes_;
+    long default_size_;
+
+  public:
+    TypeSizeTable()
+        : sizes_({ { "bool", 1 }, { "char", 1 }, { "short", 2 }, { "int", 4 },
+                   { "float", 4 }, { "long", 8 }, { "double", 8 } }),
+          default_size_(0) { }
+
+    void set_size(const std::string &type, long size)
+    {
+        sizes_[type] = size;
+    }
+
+    bool has_size(const std::string &type) const
+    {
+        return sizes_.find(type) != sizes_.end();
+    }
+
+    /// \returns size of type, or default_size() if type is unknown.
+    long size(const std::string &type) const
+    {
+        auto it = sizes_.find(type);
+        return it != sizes_.end() ? it->second : default_size_;
+    }
+
+    void set_default_size(long size)
+    {
+        default_size_ = size;
+    }
+
+    long default_size() const
+    {
+        return default_size_;
+    }
+};
+
+/**
+ * \brief Closed-form message and byte counts per Role of a Session.
+ *
+ * Counts are symbolic Exprs over the free variables of the Session (e.g.
+ * the constant N), computed without unrolling for-loops: the counts of a
+ * loop body are summed over the loop range in closed form, using Newton's
+ * forward differences when the body depends on the loop variable. Counts
+ * are kept as a polynomial with integer coefficients over a common integer
+ * denominator, so nested triangular loops such as foreach (i:1..N)
+ * foreach (j:i..N) foreach (k:j..N) are exact for bodies up to degree
+ * max_degree in each loop variable; a count is divided by its denominator
+ * only when it is returned.
+ *
+ * Each receiver of an interaction counts as one message; a Role parameter
+ * which is a range (e.g. W[1..N]) multiplies the count by its size. The
+ * size of a message is the sum of its payload sizes from a TypeSizeTable,
+ * multiplied by any array dimensions of the payload.
+ *
+ * Control flow which cannot be counted statically is over-approximated and
+ * makes is_exact() false: all branches of a choice are summed, recursion
+ * bodies, oneof and if blocks are counted once, and the excepted index of a
+ * for-loop is not subtracted. Nested protocols and allreduce are not counted.
+ */
+class MsgCount {
+  public:
+    /// \brief Largest degree of a loop body in its loop variable.
+    static const unsigned int max_degree = 4;
+
+  private:
+    enum Measure { SENT, RECEIVED, SENT_BYTES, RECEIVED_BYTES, NUM_MEASURES };
+
+    /// Count num / den, where num is a polynomial with integer coefficients.
+    struct Count {
+        Expr *num;
+        long den;
+    };
+    typedef std::map<std::string, std::array<Count, NUM_MEASURES>> Frame;
+
+    TypeSizeTable sizes_;
+    std::vector<Frame> frames_; // Counts of the enclosing loop bodies.
+    std::set<std::string> unknown_types_;
+    bool exact_;
+    bool error_;
+
+  public:
+    /// \brief MsgCount constructor.
+    /// \param[in] sizes of payload types.
+    MsgCount(const TypeSizeTable &sizes = TypeSizeTable())
+        : sizes_(sizes), frames_(1), unknown_types_(), exact_(true), error_(false) { }
+
+    MsgCount(const MsgCount &) = delete;
+    MsgCount &operator=(const MsgCount &) = delete;
+
+    ~MsgCount()
+    {
+        for (auto &frame : frames_) {
+            clear(frame);
+        }
+    }
+
+    /// \brief Count messages of session (adds to previous counts).
+    void analyse(const Session &session)
+    {
+        if (session.root() != nullptr) {
+            walk(session.root(), *this);
+        }
+    }
+
+    /// \returns false if a loop body could not be summed in closed form.
+    bool is_valid() const
+    {
+        return !error_;
+    }
+
+    /// \returns false if any count is an over-approximation.
+    bool is_exact() const
+    {
+        return exact_;
+    }
+
+    /// \returns names of Roles which send or receive messages.
+    std::vector<std::string> roles() const
+    {
+        std::vector<std::string> names;
+        for (auto &entry : frames_.front()) {
+            names.push_back(entry.first);
+        }
+        return names;
+    }
+
+    /// \returns payload types which were not in the TypeSizeTable.
+    const std::set<std::string> &unknown_types() const
+    {
+        return unknown_types_;
+    }
+
+    /// \returns number of messages sent by role (dynamically allocated).
+    Expr *sent(const std::string &role) const
+    {
+        return result(role, SENT);
+    }
+
+    /// \returns number of messages received by role (dynamically allocated).
+    Expr *received(const std::string &role) const
+    {
+        return result(role, RECEIVED);
+    }
+
+    /// \returns number of bytes sent by role (dynamically allocated).
+    Expr *sent_bytes(const std::string &role) const
+    {
+        return result(role, SENT_BYTES);
+    }
+
+    /// \returns number of bytes received by role (dynamically allocated).
+    Expr *received_bytes(const std::string &role) const
+    {
+        return result(role, RECEIVED_BYTES);
+    }
+
+    /// \brief Evaluate a count for given values of its variables.
+    /// \returns false if expr does not evaluate to a constant.
+    static bool evaluate(Expr *expr, const std::map<std::string, long> &values, long &result)
+    {
+        ExprCanon canon(values);
+        expr->accept(canon);
+        Expr *folded = canon.canon();
+        auto val = dynamic_cast<ValExpr *>(folded);
+        if (val != nullptr) {
+            result = val->num();
+        }
+        delete folded;
+        return val != nullptr;
+    }
+
+    bool enter(Node *node)
+    {
+        switch (node->type()) {
+            case ST_NODE_SENDRECV:
+                if (auto interaction = dynamic_cast<InteractionNode *>(node)) {
+                    count(interaction);
+                }
+                return false;
+            case ST_NODE_FOR:
+                if (auto for_node = dynamic_cast<ForNode *>(node)) {
+                    if (for_node->except() != nullptr) {
+                        exact_ = false;
+                    }
+                }
+                frames_.push_back(Frame());
+                return true;
+            case ST_NODE_CHOICE:
+            case ST_NODE_RECUR:
+            case ST_NODE_ONEOF:
+            case ST_NODE_IF:
+            case ST_NODE_INTERRUPTIBLE:
+                exact_ = false;
+                return true;
+            case ST_NODE_NESTED:
+            case ST_NODE_ALLREDUCE:
+                exact_ = false;
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    void leave(Node *node)
+    {
+        if (node->type() != ST_NODE_FOR) {
+            return;
+        }
+        Frame body = frames_.back();
+        frames_.pop_back();
+        auto for_node = dynamic_cast<ForNode *>(node);
+        RngExpr *bindexpr = for_node != nullptr ? for_node->bindexpr() : nullptr;
+        for (auto &entry : body) {
+            for (unsigned int m=0; m<NUM_MEASURES; m++) {
+                const Count &body_count = entry.second[m];
+                if (body_count.num == nullptr) {
+                    continue;
+                }
+                long scale = 1;
+                Expr *total = bindexpr != nullptr ? series(body_count.num, bindexpr, scale) : nullptr;
+                if (total == nullptr) {
+                    error_ = true;
+                    total = body_count.num->clone();
+                    scale = 1;
+                }
+                add(entry.first, Measure(m), total, body_count.den * scale);
+            }
+        }
+        clear(body);
+    }
+
+  private:
+    static void clear(Frame &frame)
+    {
+        for (auto &entry : frame) {
+            for (auto &count : entry.second) {
+                delete count.num;
+            }
+        }
+        frame.clear();
+    }
+
+    Expr *result(const std::string &role, Measure measure) const
+    {
+        auto it = frames_.front().find(role);
+        if (it == frames_.front().end() || it->second[measure].num == nullptr) {
+            return new ValExpr(0);
+        }
+        const Count &count = it->second[measure];
+        if (count.den == 1) {
+            return count.num->clone();
+        }
+        return canonical(new DivExpr(count.num->clone(), new ValExpr(count.den)));
+    }
+
+    static long gcd(long a, long b)
+    {
+        while (b != 0) {
+            long r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+
+    /// \returns canonical form of expr (takes ownership of expr).
+    static Expr *canonical(Expr *expr)
+    {
+        ExprCanon canon;
+        expr->accept(canon);
+        delete expr;
+        return canon.canon();
+    }
+
+    /// \brief Add count / den (takes ownership of count) to role in the
+    /// innermost frame.
+    void add(const std::string &role, Measure measure, Expr *count, long den = 1)
+    {
+        auto it = frames_.back().find(role);
+        if (it == frames_.back().end()) {
+            it = frames_.back().insert({ role, { { } } }).first;
+        }
+        Count &total = it->second[measure];
+        if (total.num == nullptr) {
+            total = Count { canonical(count), den };
+            return;
+        }
+        long lcm = total.den / gcd(total.den, den) * den;
+        total.num = canonical(new AddExpr(new MulExpr(total.num, new ValExpr(lcm / total.den)),
+                                          new MulExpr(count, new ValExpr(lcm / den))));
+        total.den = lcm;
+    }
+
+    /// \returns number of indices of a parameter (1 unless it is a range).
+    static Expr *cardinality(Expr *param)
+    {
+        if (auto rng = dynamic_cast<RngExpr *>(param)) {
+            return new AddExpr(new SubExpr(rng->to()->clone(), rng->from()->clone()), new ValExpr(1));
+        }
+        return new ValExpr(1);
+    }
+
+    /// \returns number of Role instances denoted by role.
+    static Expr *instances(Role *role)
+    {
+        Expr *count = new ValExpr(1);
+        for (unsigned int i=0; i<role->num_dimens(); i++) {
+            count = new MulExpr(count, cardinality((*role)[i]));
+        }
+        return count;
+    }
+
+    /// \returns number of bytes in msg.
+    Expr *msg_size(MsgSig *msg)
+    {
+        Expr *size = new ValExpr(0);
+        for (auto it=msg->payload_begin(); it!=msg->payload_end(); it++) {
+            if (!sizes_.has_size((*it)->type())) {
+                unknown_types_.insert((*it)->type());
+            }
+            Expr *payload_size = new ValExpr(sizes_.size((*it)->type()));
+            if (auto payload = dynamic_cast<MsgPayload *>(*it)) {
+                for (unsigned int i=0; i<payload->num_dimens(); i++) {
+                    Expr *dimen = (*payload)[i];
+                    payload_size = new MulExpr(payload_size,
+                            dynamic_cast<RngExpr *>(dimen) != nullptr ? cardinality(dimen) : dimen->clone());
+                }
+            }
+            size = new AddExpr(size, payload_size);
+        }
+        return canonical(size);
+    }
+
+    void count(InteractionNode *interaction)
+    {
+        if (interaction->cond() != nullptr) {
+            exact_ = false;
+        }
+        Expr *sndr_count = interaction->sndr() != nullptr ? instances(interaction->sndr()) : new ValExpr(1);
+        Expr *size = interaction->msg() != nullptr ? msg_size(interaction->msg()) : new ValExpr(0);
+        for (auto it=interaction->rcvr_begin(); it!=interaction->rcvr_end(); it++) {
+            Expr *msgs = canonical(new MulExpr(sndr_count->clone(), instances(*it)));
+            Expr *bytes = canonical(new MulExpr(msgs->clone(), size->clone()));
+            if (interaction->sndr() != nullptr) {
+                add(interaction->sndr()->name(), SENT, msgs->clone());
+                add(interaction->sndr()->name(), SENT_BYTES, bytes->clone());
+            }
+            add((*it)->name(), RECEIVED, msgs);
+            add((*it)->name(), RECEIVED_BYTES, bytes);
+        }
+        delete sndr_count;
+        delete size;
+    }
+
+    static bool occurs(Expr *expr, const std::string &var)
+    {
+        if (auto vare = dynamic_cast<VarExpr *>(expr)) {
+            return vare->name() == var;
+        } else if (auto bine = dynamic_cast<BinExpr *>(expr)) {
+            return occurs(bine->lhs(), var) || occurs(bine->rhs(), var);
+        } else if (auto rnge = dynamic_cast<RngExpr *>(expr)) {
+            return occurs(rnge->from(), var) || occurs(rnge->to(), var);
+        } else if (auto loge = dynamic_cast<LogExpr *>(expr)) {
+            return occurs(loge->value(), var) || occurs(loge->base(), var);
+        }
+        return false;
+    }
+
+    /// \returns expr with var replaced by value, or nullptr.
+    static Expr *substitute(Expr *expr, const std::string &var, Expr *value)
+    {
+        RngExpr bindexpr(var, value->clone(), value->clone());
+        ExprApply apply(&bindexpr);
+        expr->accept(apply);
+        auto applied = dynamic_cast<RngExpr *>(apply.apply());
+        if (applied == nullptr) {
+            return nullptr;
+        }
+        Expr *result = applied->from()->clone();
+        delete applied;
+        return canonical(result);
+    }
+
+    /// \returns falling factorial n (n-1) ... (n-k+1).
+    static Expr *falling(Expr *n, unsigned int k)
+    {
+        Expr *product = n->clone();
+        for (unsigned int i=1; i<k; i++) {
+            product = new MulExpr(product, new SubExpr(n->clone(), new ValExpr(i)));
+        }
+        return product;
+    }
+
+    /// \brief Sum f over the range of bindexpr.
+    ///
+    /// sum_{k=0}^{n-1} f(from+k) = sum_{j=0}^{d} C(n, j+1) * D^j f(from),
+    /// where n = to-from+1 and D^j is the j-th forward difference in the
+    /// loop variable, which is zero for j > d = degree of f. The binomials
+    /// are taken over the common denominator (d+1)!, so the sum stays a
+    /// polynomial with integer coefficients.
+    /// \param[out] scale the sum is the result divided by scale.
+    /// \returns closed form of the sum times scale, or nullptr.
+    static Expr *series(Expr *f, RngExpr *bindexpr, long &scale)
+    {
+        const std::string var = bindexpr->bindvar();
+        Expr *n = canonical(new AddExpr(
+                    new SubExpr(bindexpr->to()->clone(), bindexpr->from()->clone()), new ValExpr(1)));
+        AddExpr next(new VarExpr(var), new ValExpr(1));
+
+        std::vector<Expr *> terms; // falling(n, j+1) * D^j f(from)
+        bool error = false;
+        Expr *delta = f->clone();
+        for (unsigned int j=0; delta!=nullptr; j++) {
+            Expr *at_from = substitute(delta, var, bindexpr->from());
+            if (at_from == nullptr || j > max_degree) {
+                delete at_from;
+                error = true;
+                break;
+            }
+            terms.push_back(new MulExpr(falling(n, j + 1), at_from));
+            if (!occurs(delta, var)) {
+                break;
+            }
+            Expr *shifted = substitute(delta, var, &next);
+            Expr *next_delta = nullptr;
+            if (shifted != nullptr) {
+                next_delta = canonical(new SubExpr(shifted, delta->clone()));
+            } else {
+                error = true;
+            }
+            delete delta;
+            delta = next_delta;
+        }
+        delete delta;
+        delete n;
+
+        // (j+1)! for each term, scale = (d+1)!.
+        std::vector<long> factorials;
+        scale = 1;
+        for (unsigned int j=0; j<terms.size(); j++) {
+            scale *= j + 1;
+            factorials.push_back(scale);
+        }
+        Expr *sum = nullptr;
+        for (unsigned int j=0; j<terms.size(); j++) {
+            if (error) {
+                delete terms[j];
+                continue;
+            }
+            Expr *term = new MulExpr(terms[j], new ValExpr(scale / factorials[j]));
+            sum = sum == nullptr ? term : new AddExpr(sum, term);
+        }
+        if (error || sum == nullptr) {
+            delete sum;
+            scale = 1;
+            return nullptr;
+        }
+        return canonical(sum);
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__MSG_COUNT_H__
@@ -0,0 +1,95 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__PLACEMENT_H__
+#define SESSTYPE__PARAMETERISED__UTIL__PLACEMENT_H__
+
+#ifdef __cplusplus
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/util/comm_graph.h"
+
+#define ST_PLACE_BYTES 0 ///< Weigh edges by bytes.
+#define ST_PLACE_MSGS  1 ///< Weigh edges by number of messages.
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Placement of the ranks of a CommGraph onto a machine hierarchy.
+ *
+ * The machine is a tree given by the arity of each level from the top,
+ * e.g. { 4, 2, 8 } for 4 nodes of 2 sockets of 8 cores, and every leaf is
+ * a slot for one rank. Slots are numbered depth-first, so the domain of a
+ * slot at a level is the slot divided by the number of slots below it.
+ *
+ * Ranks are placed by recursive bisection of the undirected communication
+ * graph: each level is split between its children, every bisection is
+ * seeded by greedy graph growing from a peripheral rank and refined by
+ * Fiduccia-Mattheyses passes, so the traffic between nodes is minimised
+ * first and then the traffic between sockets within each node. Parts are
+ * filled in proportion to their capacity.
+ */
+class Placement {
+    std::vector<unsigned int> hierarchy_;
+    std::vector<unsigned long> spans_; // Slots below one domain of each level.
+    std::vector<unsigned long> slots_;
+    unsigned int weight_;
+
+  public:
+    /// \brief Placement constructor.
+    /// \param[in] hierarchy arity of each level, from the top.
+    /// \exception std::invalid_argument if an arity is zero.
+    explicit Placement(const std::vector<unsigned int> &hierarchy);
+
+    /// \param[in] weight ST_PLACE_BYTES or ST_PLACE_MSGS.
+    void set_weight(unsigned int weight)
+    {
+        weight_ = weight;
+    }
+
+    unsigned int num_levels() const
+    {
+        return hierarchy_.size();
+    }
+
+    /// \returns number of slots of the machine.
+    unsigned long capacity() const
+    {
+        return spans_.empty() ? 1 : spans_[0] * hierarchy_[0];
+    }
+
+    /// \brief Place the ranks of graph.
+    /// \exception std::invalid_argument if there are more ranks than slots.
+    void place(const CommGraph &graph);
+
+    /// \brief Use a given placement (e.g. to compare with place()).
+    /// \exception std::invalid_argument if a slot is out of range or used twice.
+    void set_slots(const std::vector<unsigned long> &slots);
+
+    /// \returns slot of each rank.
+    const std::vector<unsigned long> &slots() const
+    {
+        return slots_;
+    }
+
+    /// \returns domain of rank at level (e.g. its node at level 0).
+    unsigned long domain(unsigned long rank, unsigned int level) const
+    {
+        return slots_.at(rank) / spans_.at(level);
+    }
+
+    /// \returns weight of the edges of graph between different domains of level.
+    unsigned long traffic(const CommGraph &graph, unsigned int level) const;
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__PLACEMENT_H__
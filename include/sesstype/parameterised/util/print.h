@@ -15,6 +15,7 @@
 #include "sesstype/parameterised/util/node_visitor.h"
 #include "sesstype/parameterised/util/role_visitor.h"
 #include "sesstype/parameterised/util/expr_visitor.h"
+#include "sesstype/util/output_buffer.h"
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -25,9 +26,12 @@ namespace util {
 #ifdef __cplusplus
 /**
  * \brief Protocol and Expression printer.
+ *
+ * Output is formatted into an OutputBuffer and written to the stream in bulk
+ * when the outermost visit returns.
  */
 class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor {
-    std::ostream &os_;
+    sesstype::util::OutputBuffer os_;
     std::string indent_str_;
     unsigned int indent_lvl_;
     unsigned int line_count_;
@@ -55,9 +59,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
         os_ << line_count_++ << "\t ";
         if (indent_lvl_ > 0) {
             os_ << '|';
-            for (unsigned int i=0; i<indent_lvl_; i++) {
-                os_ << indent_str_;
-            }
+            os_.repeat(indent_str_, indent_lvl_);
         }
     }
 
@@ -84,6 +86,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(Node *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "generic {}";
         addr(node);
@@ -92,6 +95,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(InteractionNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "interaction";
         addr(node);
@@ -121,6 +125,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(BlockNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         if (node->num_children() > 0) {
             prefix();
             os_ << "root";
@@ -138,6 +143,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(RecurNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "recur";
         addr(node);
@@ -149,6 +155,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ContinueNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "cont";
         addr(node);
@@ -157,6 +164,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ChoiceNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "choice";
         addr(node);
@@ -169,6 +177,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ParNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "par";
         addr(node);
@@ -180,6 +189,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(NestedNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "nested";
         addr(node);
@@ -205,6 +215,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(InterruptibleNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "interruptible";
         addr(node);
@@ -226,6 +237,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ForNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "for";
         addr(node);
@@ -238,6 +250,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(OneofNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "oneof";
         addr(node);
@@ -252,6 +265,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(IfNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "if";
         addr(node);
@@ -264,6 +278,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(AllReduceNode *node)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         prefix();
         os_ << "allreduce";
         addr(node);
@@ -273,8 +288,9 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(Role *role)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << role->name();
-        for (int i=0; i<role->num_dimens(); i++) {
+        for (unsigned int i=0; i<role->num_dimens(); i++) {
             os_ << "[";
             (*role)[i]->accept(*this);
             os_ << "]";
@@ -284,6 +300,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(RoleGrp *role)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << role->name();
         os_ << "{ members#: " << role->num_members() << ", membs: ";
         for (auto it=role->member_begin(); it!=role->member_end(); it++) {
@@ -296,23 +313,27 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(Expr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         // Empty.
     }
 
     virtual void visit(VarExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "var(" << expr->name() << ")";
         addr(expr);
     }
 
     virtual void visit(ValExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "val(" << expr->num() << ")";
         addr(expr);
     }
 
     virtual void visit(AddExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "+(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -323,6 +344,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(SubExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "-(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -333,6 +355,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(MulExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "*(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -343,6 +366,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(DivExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "/(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -353,6 +377,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ModExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "%(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -363,6 +388,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ShlExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "<<(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -373,6 +399,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(ShrExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << ">>(";
         expr->lhs()->accept(*this);
         os_ << " , ";
@@ -383,6 +410,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(SeqExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "seq: ";
         for (unsigned int i=0; i<expr->num_values(); i++) {
             if (i != 0) os_ << ",";
@@ -393,6 +421,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(RngExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "rng(" << expr->bindvar() << ",";
         expr->from()->accept(*this);
         os_ << ",";
@@ -403,6 +432,7 @@ class PrintVisitor : public NodeVisitor, public RoleVisitor, public ExprVisitor
 
     virtual void visit(LogExpr *expr)
     {
+        sesstype::util::OutputBuffer::Scope scope(os_);
         os_ << "log(";
         expr->value()->accept(*this);
         os_ << ", ";
@@ -11,7 +11,7 @@
 #include "sesstype/parameterised/role_grp.h"
 #include "sesstype/parameterised/util/node_visitor.h"
 #include "sesstype/parameterised/util/expr_apply.h"
-#include "sesstype/parameterised/util/expr_eval.h"
+#include "sesstype/parameterised/util/expr_canon.h"
 #include "sesstype/parameterised/util/expr_invert.h"
 
 #ifdef __cplusplus
@@ -109,12 +109,12 @@ class ProjectionVisitor : public NodeVisitor {
                                     util::ExprApply applier(b_rng);
                                     e->accept(applier);
                                     Expr *apply_b_e = applier.apply();
-                                    util::ExprEval evaluator;
-                                    apply_b_e->accept(evaluator);
-                                    Expr *apply_b_e_simplified = evaluator.eval();
+                                    util::ExprCanon canon;
+                                    apply_b_e->accept(canon);
+                                    Expr *apply_b_e_simplified = canon.canon();
                                     delete apply_b_e;
 
-                                    util::ExprInvert inv(bindvar);
+                                    util::ExprInvert inv(b_rng);
                                     e->accept(inv);
                                     Expr *inv_e = inv.invert();
 
@@ -244,6 +244,9 @@ class ProjectionVisitor : public NodeVisitor {
     virtual void visit(ContinueNode *node) override
     {
         auto *projected_node = new ContinueNode(node->label());
+        if (node->is_bound()) {
+            projected_node->bind(node->scope());
+        }
 
         dynamic_cast<BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor> *>(stack_.top())->append_child(projected_node);
     }
@@ -0,0 +1,315 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__RANGE_SET_H__
+#define SESSTYPE__PARAMETERISED__UTIL__RANGE_SET_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/expr.h"
+#include "sesstype/parameterised/expr/rng.h"
+#include "sesstype/parameterised/expr/seq.h"
+#include "sesstype/parameterised/expr/val.h"
+#include "sesstype/parameterised/util/expr_canon.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Finite set of integer indices (e.g. the domain of a Role parameter).
+ *
+ * The set is kept in normal form: a sorted list of disjoint, non-adjacent
+ * closed intervals, so two RangeSets are equal exactly when their interval
+ * lists are equal. Union, intersection and difference are linear merges of
+ * the interval lists, so cost is proportional to the number of maximal runs
+ * in the set. A strided range (see strided()) has one run per element, and
+ * is limited to MAX_STRIDED elements.
+ *
+ * A RangeSet can be built from a RngExpr, SeqExpr or ValExpr whose bounds
+ * are constant once known constants are substituted (see ExprCanon);
+ * otherwise it is not valid.
+ */
+class RangeSet {
+  public:
+    /// \brief Closed interval [lo, hi].
+    struct Interval {
+        long lo;
+        long hi;
+
+        bool operator==(const Interval &other) const
+        {
+            return lo == other.lo && hi == other.hi;
+        }
+    };
+
+    typedef std::vector<Interval> IntervalContainer;
+
+    /// Largest number of elements of a strided set.
+    static const unsigned long MAX_STRIDED = 1UL << 16;
+
+  private:
+    IntervalContainer intervals_;
+    bool error_;
+
+  public:
+    /// \brief RangeSet constructor for the empty set.
+    RangeSet() : intervals_(), error_(false) { }
+
+    /// \brief RangeSet constructor for the indices of an Expr.
+    /// \param[in] expr RngExpr, SeqExpr or ValExpr.
+    /// \param[in] constants values of variables in expr.
+    RangeSet(Expr *expr, const std::map<std::string, long> &constants = { })
+        : intervals_(), error_(false)
+    {
+        if (auto rng = dynamic_cast<RngExpr *>(expr)) {
+            long lo, hi;
+            if (eval(rng->from(), constants, lo) && eval(rng->to(), constants, hi)) {
+                add(lo, hi);
+                return;
+            }
+        } else if (auto seq = dynamic_cast<SeqExpr *>(expr)) {
+            for (auto it=seq->seq_begin(); it!=seq->seq_end(); it++) {
+                add(*it, *it);
+            }
+            normalise();
+            return;
+        } else {
+            long val;
+            if (eval(expr, constants, val)) {
+                add(val, val);
+                return;
+            }
+        }
+        error_ = true;
+    }
+
+    /// \returns set of lo, lo+1, ..., hi (empty if hi < lo).
+    static RangeSet range(long lo, long hi)
+    {
+        RangeSet set;
+        set.add(lo, hi);
+        return set;
+    }
+
+    /// \returns set of lo, lo+stride, ... up to hi.
+    ///
+    /// Unless stride is 1, every element is an interval of its own, so the
+    /// set takes memory and time linear in its number of elements.
+    /// \exception std::invalid_argument if stride is not positive.
+    /// \exception std::length_error if stride is not 1 and the set has more
+    ///            than MAX_STRIDED elements.
+    static RangeSet strided(long lo, long hi, long stride)
+    {
+        if (stride <= 0) {
+            throw std::invalid_argument("RangeSet stride must be positive");
+        }
+        if (stride == 1 || hi < lo) {
+            return range(lo, hi);
+        }
+        unsigned long width = static_cast<unsigned long>(hi) - static_cast<unsigned long>(lo);
+        unsigned long n = width / stride + 1;
+        if (n > MAX_STRIDED) {
+            throw std::length_error("RangeSet strided set is too large");
+        }
+        RangeSet set;
+        set.intervals_.reserve(n);
+        for (unsigned long i=0; i<n; i++) {
+            long idx = static_cast<long>(static_cast<unsigned long>(lo) + i * stride);
+            set.intervals_.push_back(Interval { idx, idx });
+        }
+        return set;
+    }
+
+    /// \returns false if the RangeSet could not be built from an Expr.
+    bool is_valid() const
+    {
+        return !error_;
+    }
+
+    bool empty() const
+    {
+        return intervals_.empty();
+    }
+
+    /// \returns number of indices in the set.
+    unsigned long size() const
+    {
+        unsigned long n = 0;
+        for (auto &interval : intervals_) {
+            n += interval.hi - interval.lo + 1;
+        }
+        return n;
+    }
+
+    /// \returns true if idx is in the set.
+    bool contains(long idx) const
+    {
+        auto it = std::upper_bound(intervals_.begin(), intervals_.end(), idx,
+                [](long i, const Interval &interval) { return i < interval.lo; });
+        return it != intervals_.begin() && idx <= (it - 1)->hi;
+    }
+
+    /// \returns true if every index of this set is in other.
+    bool is_subset(const RangeSet &other) const
+    {
+        return (*this - other).empty();
+    }
+
+    unsigned int num_intervals() const
+    {
+        return intervals_.size();
+    }
+
+    IntervalContainer::const_iterator interval_begin() const
+    {
+        return intervals_.begin();
+    }
+
+    IntervalContainer::const_iterator interval_end() const
+    {
+        return intervals_.end();
+    }
+
+    /// \returns union of this and other.
+    RangeSet operator|(const RangeSet &other) const
+    {
+        RangeSet set;
+        set.intervals_.reserve(intervals_.size() + other.intervals_.size());
+        std::merge(intervals_.begin(), intervals_.end(),
+                other.intervals_.begin(), other.intervals_.end(),
+                std::back_inserter(set.intervals_),
+                [](const Interval &a, const Interval &b) { return a.lo < b.lo; });
+        set.normalise();
+        return set;
+    }
+
+    /// \returns intersection of this and other.
+    RangeSet operator&(const RangeSet &other) const
+    {
+        RangeSet set;
+        auto a = intervals_.begin(), b = other.intervals_.begin();
+        while (a != intervals_.end() && b != other.intervals_.end()) {
+            long lo = std::max(a->lo, b->lo);
+            long hi = std::min(a->hi, b->hi);
+            if (lo <= hi) {
+                set.intervals_.push_back(Interval { lo, hi });
+            }
+            if (a->hi < b->hi) {
+                a++;
+            } else {
+                b++;
+            }
+        }
+        return set;
+    }
+
+    /// \returns indices of this which are not in other.
+    RangeSet operator-(const RangeSet &other) const
+    {
+        RangeSet set;
+        auto b = other.intervals_.begin();
+        for (auto &interval : intervals_) {
+            long lo = interval.lo;
+            while (b != other.intervals_.end() && b->hi < lo) {
+                b++;
+            }
+            for (auto c=b; c!=other.intervals_.end() && c->lo <= interval.hi; c++) {
+                if (c->lo > lo) {
+                    set.intervals_.push_back(Interval { lo, c->lo - 1 });
+                }
+                lo = c->hi + 1;
+            }
+            if (lo <= interval.hi) {
+                set.intervals_.push_back(Interval { lo, interval.hi });
+            }
+        }
+        return set;
+    }
+
+    bool operator==(const RangeSet &other) const
+    {
+        return intervals_ == other.intervals_;
+    }
+
+    bool operator!=(const RangeSet &other) const
+    {
+        return !(*this == other);
+    }
+
+    /// \brief Express the set as Exprs (dynamically allocated).
+    ///
+    /// Intervals of two or more indices become a RngExpr with bindvar, and
+    /// each run of single indices becomes one SeqExpr, in ascending order.
+    std::vector<Expr *> to_exprs(const std::string &bindvar = "") const
+    {
+        std::vector<Expr *> exprs;
+        SeqExpr *seq = nullptr;
+        for (auto &interval : intervals_) {
+            if (interval.lo == interval.hi) {
+                if (seq == nullptr) {
+                    seq = new SeqExpr();
+                    exprs.push_back(seq);
+                }
+                seq->append_value(interval.lo);
+            } else {
+                seq = nullptr;
+                exprs.push_back(new RngExpr(bindvar, new ValExpr(interval.lo), new ValExpr(interval.hi)));
+            }
+        }
+        return exprs;
+    }
+
+  private:
+    void add(long lo, long hi)
+    {
+        if (lo <= hi) {
+            intervals_.push_back(Interval { lo, hi });
+        }
+    }
+
+    /// \brief Sort and merge overlapping or adjacent intervals.
+    void normalise()
+    {
+        std::sort(intervals_.begin(), intervals_.end(),
+                [](const Interval &a, const Interval &b) { return a.lo < b.lo; });
+        IntervalContainer merged;
+        for (auto &interval : intervals_) {
+            if (!merged.empty() && interval.lo <= merged.back().hi + 1) {
+                merged.back().hi = std::max(merged.back().hi, interval.hi);
+            } else {
+                merged.push_back(interval);
+            }
+        }
+        intervals_.swap(merged);
+    }
+
+    static bool eval(Expr *expr, const std::map<std::string, long> &constants, long &val)
+    {
+        ExprCanon canon(constants);
+        expr->accept(canon);
+        Expr *result = canon.canon();
+        auto val_expr = dynamic_cast<ValExpr *>(result);
+        if (val_expr != nullptr) {
+            val = val_expr->num();
+        }
+        delete result;
+        return val_expr != nullptr;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__RANGE_SET_H__
@@ -0,0 +1,341 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__ROLE_LAYOUT_H__
+#define SESSTYPE__PARAMETERISED__UTIL__ROLE_LAYOUT_H__
+
+#ifdef __cplusplus
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/expr.h"
+#include "sesstype/parameterised/expr/rng.h"
+#include "sesstype/parameterised/expr/val.h"
+#include "sesstype/parameterised/role.h"
+#include "sesstype/parameterised/util/expr_canon.h"
+
+#define ST_LAYOUT_ROW_MAJOR 0 ///< Last dimension varies fastest.
+#define ST_LAYOUT_COL_MAJOR 1 ///< First dimension varies fastest.
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Mapping between the indices of a multi-dimensional Role and ranks.
+ *
+ * The instances of a Role such as W[1..N][1..M] form a Cartesian grid, and
+ * each instance has a rank 0 .. size()-1 in the layout. The order of the
+ * dimensions in the rank is row-major, column-major or a custom
+ * permutation, and conversion in either direction costs one multiply or
+ * divide per dimension. Dimensions may be periodic, for neighbour queries
+ * of stencil patterns which wrap around.
+ */
+class RoleLayout {
+    std::string name_;
+    std::vector<long> from_;
+    std::vector<unsigned long> extents_;
+    std::vector<unsigned long> strides_;
+    std::vector<unsigned int> order_; // Dimensions from slowest to fastest.
+    std::vector<bool> periodic_;
+    unsigned long size_;
+
+  public:
+    /// \brief RoleLayout constructor for a Role without dimensions.
+    RoleLayout() : name_(), from_(), extents_(), strides_(), order_(), periodic_(), size_(1) { }
+
+    /// \brief RoleLayout constructor for given dimensions.
+    /// \param[in] name of Role.
+    /// \param[in] from first index of each dimension.
+    /// \param[in] extents number of indices of each dimension.
+    /// \param[in] order ST_LAYOUT_ROW_MAJOR or ST_LAYOUT_COL_MAJOR.
+    /// \exception std::invalid_argument if from and extents differ in size.
+    RoleLayout(const std::string &name, const std::vector<long> &from,
+            const std::vector<unsigned long> &extents, unsigned int order = ST_LAYOUT_ROW_MAJOR)
+        : name_(name), from_(from), extents_(extents), strides_(), order_(),
+          periodic_(extents.size(), false), size_(1)
+    {
+        if (from.size() != extents.size()) {
+            throw std::invalid_argument("RoleLayout dimensions mismatch");
+        }
+        set_order(order);
+    }
+
+    /// \brief RoleLayout constructor for the declaration of a Role.
+    ///
+    /// Each parameter of role is a range (W[1..N]) or a single index, with
+    /// bounds which are constant once constants are substituted.
+    /// \param[in] role declaration.
+    /// \param[in] constants values of variables in the parameters of role.
+    /// \param[in] order ST_LAYOUT_ROW_MAJOR or ST_LAYOUT_COL_MAJOR.
+    /// \exception std::invalid_argument if a bound is not constant.
+    RoleLayout(Role *role, const std::map<std::string, long> &constants = { },
+            unsigned int order = ST_LAYOUT_ROW_MAJOR)
+        : name_(role->name()), from_(), extents_(), strides_(), order_(),
+          periodic_(role->num_dimens(), false), size_(1)
+    {
+        for (unsigned int i=0; i<role->num_dimens(); i++) {
+            long lo, hi;
+            if (auto rng = dynamic_cast<RngExpr *>((*role)[i])) {
+                lo = constant(rng->from(), constants);
+                hi = constant(rng->to(), constants);
+            } else {
+                lo = hi = constant((*role)[i], constants);
+            }
+            from_.push_back(lo);
+            extents_.push_back(hi < lo ? 0 : hi - lo + 1);
+        }
+        set_order(order);
+    }
+
+    /// \brief Set a custom order of dimensions.
+    /// \param[in] order permutation of dimensions, from slowest to fastest varying.
+    /// \exception std::invalid_argument if order is not a permutation.
+    void set_order(const std::vector<unsigned int> &order)
+    {
+        std::vector<bool> seen(extents_.size(), false);
+        if (order.size() != extents_.size()) {
+            throw std::invalid_argument("RoleLayout order is not a permutation");
+        }
+        for (auto d : order) {
+            if (d >= extents_.size() || seen[d]) {
+                throw std::invalid_argument("RoleLayout order is not a permutation");
+            }
+            seen[d] = true;
+        }
+        order_ = order;
+        strides_.assign(extents_.size(), 0);
+        size_ = 1;
+        for (unsigned int k=order_.size(); k>0; k--) {
+            strides_[order_[k - 1]] = size_;
+            size_ *= extents_[order_[k - 1]];
+        }
+    }
+
+    /// \param[in] order ST_LAYOUT_ROW_MAJOR or ST_LAYOUT_COL_MAJOR.
+    void set_order(unsigned int order)
+    {
+        std::vector<unsigned int> dimens;
+        for (unsigned int d=0; d<extents_.size(); d++) {
+            dimens.push_back(order == ST_LAYOUT_COL_MAJOR ? extents_.size() - 1 - d : d);
+        }
+        set_order(dimens);
+    }
+
+    /// \returns dimensions from slowest to fastest varying.
+    const std::vector<unsigned int> &order() const
+    {
+        return order_;
+    }
+
+    void set_periodic(unsigned int dimen, bool periodic)
+    {
+        periodic_.at(dimen) = periodic;
+    }
+
+    bool is_periodic(unsigned int dimen) const
+    {
+        return periodic_.at(dimen);
+    }
+
+    std::string name() const
+    {
+        return name_;
+    }
+
+    unsigned int num_dimens() const
+    {
+        return extents_.size();
+    }
+
+    /// \returns number of instances (ranks) of the Role.
+    unsigned long size() const
+    {
+        return size_;
+    }
+
+    long from(unsigned int dimen) const
+    {
+        return from_.at(dimen);
+    }
+
+    unsigned long extent(unsigned int dimen) const
+    {
+        return extents_.at(dimen);
+    }
+
+    unsigned long stride(unsigned int dimen) const
+    {
+        return strides_.at(dimen);
+    }
+
+    /// \brief Rank of index without exceptions.
+    /// \param[in] index array of num_dimens() indices.
+    /// \param[out] rank of index.
+    /// \returns false if index is outside the Role.
+    bool find_rank(const long *index, unsigned long &rank) const
+    {
+        rank = 0;
+        for (unsigned int d=0; d<extents_.size(); d++) {
+            if (index[d] < from_[d] || static_cast<unsigned long>(index[d] - from_[d]) >= extents_[d]) {
+                return false;
+            }
+            rank += (index[d] - from_[d]) * strides_[d];
+        }
+        return true;
+    }
+
+    /// \returns rank of index.
+    /// \exception std::out_of_range if index is outside the Role.
+    unsigned long rank(const std::vector<long> &index) const
+    {
+        unsigned long rank;
+        if (index.size() != extents_.size() || !find_rank(index.data(), rank)) {
+            throw std::out_of_range("Index out of range for Role " + name_);
+        }
+        return rank;
+    }
+
+    /// \returns index of rank.
+    /// \exception std::out_of_range if rank is not less than size().
+    std::vector<long> index(unsigned long rank) const
+    {
+        if (rank >= size_) {
+            throw std::out_of_range("Rank out of range for Role " + name_);
+        }
+        std::vector<long> index(extents_.size());
+        for (unsigned int d=0; d<extents_.size(); d++) {
+            index[d] = from_[d] + (rank / strides_[d]) % extents_[d];
+        }
+        return index;
+    }
+
+    /// \brief Rank of the neighbour of rank at displacement in each dimension.
+    /// \param[out] neighbour rank.
+    /// \returns false if the neighbour is outside a non-periodic dimension.
+    bool neighbour(unsigned long rank, const std::vector<long> &displacement,
+            unsigned long &neighbour) const
+    {
+        if (displacement.size() != extents_.size() || rank >= size_) {
+            return false;
+        }
+        neighbour = 0;
+        for (unsigned int d=0; d<extents_.size(); d++) {
+            long extent = extents_[d];
+            long i = static_cast<long>((rank / strides_[d]) % extents_[d]) + displacement[d];
+            if (i < 0 || i >= extent) {
+                if (!periodic_[d]) {
+                    return false;
+                }
+                i = ((i % extent) + extent) % extent;
+            }
+            neighbour += i * strides_[d];
+        }
+        return true;
+    }
+
+    /// \returns ranks of the neighbours of rank for each displacement of stencil.
+    std::vector<unsigned long> neighbours(unsigned long rank,
+            const std::vector<std::vector<long>> &stencil) const
+    {
+        std::vector<unsigned long> ranks;
+        for (auto &displacement : stencil) {
+            unsigned long neighbour_rank;
+            if (neighbour(rank, displacement, neighbour_rank)) {
+                ranks.push_back(neighbour_rank);
+            }
+        }
+        return ranks;
+    }
+
+    /// \returns displacements of a stencil of radius 1 in num_dimens dimensions.
+    /// \param[in] diagonal false for the 2*num_dimens face neighbours
+    ///            (von Neumann), true for all 3^num_dimens-1 neighbours (Moore).
+    static std::vector<std::vector<long>> stencil(unsigned int num_dimens, bool diagonal = false)
+    {
+        std::vector<std::vector<long>> stencil;
+        if (!diagonal) {
+            for (unsigned int d=0; d<num_dimens; d++) {
+                for (long step : { -1L, 1L }) {
+                    std::vector<long> displacement(num_dimens, 0);
+                    displacement[d] = step;
+                    stencil.push_back(displacement);
+                }
+            }
+            return stencil;
+        }
+        std::vector<long> displacement(num_dimens, -1);
+        while (true) {
+            bool centre = true;
+            for (auto x : displacement) {
+                centre &= x == 0;
+            }
+            if (!centre) {
+                stencil.push_back(displacement);
+            }
+            unsigned int d = num_dimens;
+            while (d > 0 && displacement[d - 1] == 1) {
+                displacement[--d] = -1;
+            }
+            if (d == 0) {
+                break;
+            }
+            displacement[d - 1]++;
+        }
+        return stencil;
+    }
+
+    /// \brief Write Cartesian topology description.
+    ///
+    /// One line: the Role name, then <tt>dims=</tt>, <tt>periods=</tt> and
+    /// <tt>from=</tt> per dimension and <tt>order=</tt> with dimensions
+    /// from slowest to fastest, e.g.
+    /// <tt>W dims=4,8 periods=0,1 from=1,1 order=0,1</tt>
+    void write_cart(std::ostream &os) const
+    {
+        os << name_;
+        write_list(os, " dims=", extents_);
+        std::vector<int> periods(periodic_.begin(), periodic_.end());
+        write_list(os, " periods=", periods);
+        write_list(os, " from=", from_);
+        write_list(os, " order=", order_);
+        os << '\n';
+    }
+
+  private:
+    template <class T>
+    static void write_list(std::ostream &os, const char *key, const std::vector<T> &values)
+    {
+        os << key;
+        for (unsigned int i=0; i<values.size(); i++) {
+            os << (i > 0 ? "," : "") << values[i];
+        }
+    }
+
+    static long constant(Expr *expr, const std::map<std::string, long> &constants)
+    {
+        ExprCanon canon(constants);
+        expr->accept(canon);
+        Expr *result = canon.canon();
+        auto val = dynamic_cast<ValExpr *>(result);
+        long value = val != nullptr ? val->num() : 0;
+        delete result;
+        if (val == nullptr) {
+            throw std::invalid_argument("Role bound is not constant");
+        }
+        return value;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__ROLE_LAYOUT_H__
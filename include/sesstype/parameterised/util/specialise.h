@@ -0,0 +1,247 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__SPECIALISE_H__
+#define SESSTYPE__PARAMETERISED__UTIL__SPECIALISE_H__
+
+#ifdef __cplusplus
+#include <map>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/parameterised/const.h"
+#include "sesstype/parameterised/module.h"
+#include "sesstype/parameterised/msg.h"
+#include "sesstype/parameterised/node.h"
+#include "sesstype/parameterised/nodes.h"
+#include "sesstype/parameterised/role.h"
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/expr_canon.h"
+#include "sesstype/parameterised/util/traversal.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Specialise a Session for known constant values.
+ *
+ * Every Expr in the Session (Role and RoleGrp parameters, message
+ * conditions, payload parameters, for-loop and oneof ranges) is rewritten
+ * with the constants substituted and canonicalised (see ExprCanon), so all
+ * constant arithmetic is done once. Variables bound by a for-loop or oneof
+ * shadow constants of the same name inside its body.
+ *
+ * The selector Role of a OneofNode and the message of an AllReduceNode are
+ * not owned by their node (they are shared with copies), and are left
+ * unchanged.
+ */
+class Specialise {
+    std::map<std::string, long> constants_;
+    std::vector<std::string> bound_; // Variables bound in enclosing nodes.
+
+  public:
+    /// \brief Specialise constructor.
+    /// \param[in] constants values to substitute by name.
+    Specialise(const std::map<std::string, long> &constants)
+        : constants_(constants), bound_() { }
+
+    /// \returns values of all ValueConstants of module.
+    template <class ModuleType>
+    static std::map<std::string, long> value_constants(const ModuleType &module)
+    {
+        std::map<std::string, long> constants;
+        for (auto it=module.const_begin(); it!=module.const_end(); it++) {
+            if (auto val = dynamic_cast<ValueConstant *>(it->second)) {
+                constants[val->name()] = val->value();
+            }
+        }
+        return constants;
+    }
+
+    /// \returns specialised copy of session (dynamically allocated).
+    Session *session(const Session &session)
+    {
+        Session *specialised = new Session(session);
+        for (auto it=specialised->role_begin(); it!=specialised->role_end(); it++) {
+            role(it->second);
+        }
+        for (auto it=specialised->rolegrp_begin(); it!=specialised->rolegrp_end(); it++) {
+            role(it->second);
+        }
+        if (specialised->root() != nullptr) {
+            walk(specialised->root(), *this);
+        }
+        return specialised;
+    }
+
+    /// \returns specialised copy of expr (dynamically allocated).
+    Expr *expr(Expr *expr) const
+    {
+        if (bound_.empty()) {
+            ExprCanon canon(constants_);
+            expr->accept(canon);
+            return canon.canon();
+        }
+        std::map<std::string, long> constants(constants_);
+        for (auto &var : bound_) {
+            constants.erase(var);
+        }
+        ExprCanon canon(constants);
+        expr->accept(canon);
+        return canon.canon();
+    }
+
+    /// \brief Specialise parameters of role in place.
+    void role(Role *role) const
+    {
+        if (role == nullptr) {
+            return;
+        }
+        for (unsigned int i=0; i<role->num_dimens(); i++) {
+            role->set_param(i, expr((*role)[i]));
+        }
+    }
+
+    /// \brief Specialise payload parameters of msg in place.
+    void msg(MsgSig *msg) const
+    {
+        if (msg == nullptr) {
+            return;
+        }
+        for (auto it=msg->payload_begin(); it!=msg->payload_end(); it++) {
+            if (auto payload = dynamic_cast<MsgPayload *>(*it)) {
+                for (unsigned int i=0; i<payload->num_dimens(); i++) {
+                    payload->set_param(i, expr((*payload)[i]));
+                }
+            }
+        }
+    }
+
+    bool enter(Node *node)
+    {
+        switch (node->type()) {
+            case ST_NODE_SENDRECV:
+                if (auto interaction = dynamic_cast<InteractionNode *>(node)) {
+                    role(interaction->sndr());
+                    for (auto it=interaction->rcvr_begin(); it!=interaction->rcvr_end(); it++) {
+                        role(*it);
+                    }
+                    role(interaction->cond());
+                    msg(interaction->msg());
+                }
+                return false;
+            case ST_NODE_CHOICE:
+                if (auto choice = dynamic_cast<ChoiceNode *>(node)) {
+                    role(choice->at());
+                }
+                return true;
+            case ST_NODE_FOR:
+            {
+                std::string bindvar;
+                if (auto for_node = dynamic_cast<ForNode *>(node)) {
+                    if (for_node->except() != nullptr) {
+                        for_node->set_except(expr(for_node->except()));
+                    }
+                    if (RngExpr *bindexpr = for_node->bindexpr()) {
+                        bindvar = bindexpr->bindvar();
+                        for_node->set_bindexpr(static_cast<RngExpr *>(expr(bindexpr)));
+                    }
+                }
+                bound_.push_back(bindvar);
+                return true;
+            }
+            case ST_NODE_ONEOF:
+            {
+                std::string var;
+                if (auto oneof = dynamic_cast<OneofNode *>(node)) {
+                    if (oneof->range() != nullptr) {
+                        oneof->set_range(static_cast<RngExpr *>(expr(oneof->range())));
+                    }
+                    var = oneof->var();
+                }
+                bound_.push_back(var);
+                return true;
+            }
+            case ST_NODE_IF:
+                if (auto if_node = dynamic_cast<IfNode *>(node)) {
+                    role(if_node->cond());
+                }
+                return true;
+            case ST_NODE_NESTED:
+                if (auto nested = dynamic_cast<NestedNode *>(node)) {
+                    for (auto it=nested->rolearg_begin(); it!=nested->rolearg_end(); it++) {
+                        role(*it);
+                    }
+                    for (auto it=nested->arg_begin(); it!=nested->arg_end(); it++) {
+                        msg(*it);
+                    }
+                }
+                return false;
+            case ST_NODE_INTERRUPTIBLE:
+                if (auto interruptible = dynamic_cast<InterruptibleNode *>(node)) {
+                    for (auto it=interruptible->interrupt_begin(); it!=interruptible->interrupt_end(); it++) {
+                        role(it->first);
+                        msg(it->second);
+                    }
+                    for (auto it=interruptible->throw_begin(); it!=interruptible->throw_end(); it++) {
+                        role(it->first);
+                        msg(it->second);
+                    }
+                    for (auto it=interruptible->catch_begin(); it!=interruptible->catch_end(); it++) {
+                        role(it->first);
+                        msg(it->second);
+                    }
+                }
+                return true;
+            default:
+                return true;
+        }
+    }
+
+    void leave(Node *node)
+    {
+        if (node->type() == ST_NODE_FOR || node->type() == ST_NODE_ONEOF) {
+            bound_.pop_back();
+        }
+    }
+};
+
+/// \returns copy of session with the ValueConstants of module substituted.
+inline Session *specialise(const Session &session, const Module &module)
+{
+    Specialise specialiser(Specialise::value_constants(module));
+    return specialiser.session(session);
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// \brief Specialise a session for known constant values.
+///
+/// Every expression in the session is rewritten with the value constants
+/// substituted and folded into canonical form (see st_expr_eval).
+/// \param[in] tree to specialise.
+/// \param[in] num_consts number of constants.
+/// \param[in] consts array of constants (only value constants are used).
+/// \returns specialised copy of tree, allocated dynamically.
+st_param_tree *st_param_tree_specialise(st_param_tree *const tree,
+        unsigned int num_consts, st_const **consts);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__SPECIALISE_H__
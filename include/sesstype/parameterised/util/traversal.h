@@ -0,0 +1,44 @@
+#ifndef SESSTYPE__PARAMETERISED__UTIL__TRAVERSAL_H__
+#define SESSTYPE__PARAMETERISED__UTIL__TRAVERSAL_H__
+
+#include "sesstype/util/traversal.h"
+#include "sesstype/parameterised/node.h"
+#include "sesstype/parameterised/node/block.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace parameterised {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+using PreOrderIterator = sesstype::util::PreOrderIteratorTmpl<Node, BlockNode>;
+using PostOrderIterator = sesstype::util::PostOrderIteratorTmpl<Node, BlockNode>;
+
+/// \returns range of Nodes of tree at root in pre-order.
+inline sesstype::util::TraversalRange<PreOrderIterator> preorder(Node *root)
+{
+    return sesstype::util::TraversalRange<PreOrderIterator>(PreOrderIterator(root));
+}
+
+/// \returns range of Nodes of tree at root in post-order.
+inline sesstype::util::TraversalRange<PostOrderIterator> postorder(Node *root)
+{
+    return sesstype::util::TraversalRange<PostOrderIterator>(PostOrderIterator(root));
+}
+
+/// \brief Iterative tree walk, see sesstype::util::walk_tmpl.
+template <class Walker>
+void walk(Node *root, Walker &walker)
+{
+    sesstype::util::walk_tmpl<Node, BlockNode, Walker>(root, walker);
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__PARAMETERISED__UTIL__TRAVERSAL_H__
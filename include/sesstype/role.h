@@ -11,6 +11,7 @@
 #endif
 
 #include "sesstype/util/clonable.h"
+#include "sesstype/util/stamped.h"
 #include "sesstype/util/visitor_tmpl.h"
 #include "sesstype/util/role_visitor.h"
 
@@ -28,7 +29,7 @@ namespace sesstype {
 /**
  * \brief Role (participant) of a protocol or session.
  */
-class Role : public util::Clonable {
+class Role : public util::Clonable, public util::Stamped {
     std::string name_;
 
   public:
@@ -59,7 +60,9 @@ class Role : public util::Clonable {
     /// \param[in] name Sets role name to name.
     void set_name(std::string name)
     {
+        check_mutable();
         name_ = name;
+        touch();
     }
 
     /// \brief Check if this Role matches another Role.
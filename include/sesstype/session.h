@@ -9,6 +9,7 @@
 #ifdef __cplusplus
 #include <string>
 #include <iterator>
+#include <stdexcept>
 #include <unordered_map>
 #endif
 
@@ -30,6 +31,12 @@ namespace sesstype {
  * The Session class is a container for
  *  - root Node representing the body of Session
  *  - Metadata about the Session, including Roles in the Session
+ *
+ * Once frozen (see SessionTmpl::freeze) a Session, its Roles and its body
+ * (Nodes with the Roles and MsgSigs they own) are immutable, and any number
+ * of threads may read, project or print it concurrently without locking.
+ * Parameterised Exprs (e.g. RngExpr::set_from) are not frozen and must not
+ * be modified once the Session is shared.
  */
 template <class BaseNode, class RoleType>
 class SessionTmpl {
@@ -38,18 +45,44 @@ class SessionTmpl {
     RoleType *me_; // Localised role (only used in endpoint session)
     BaseNode *root_;
     std::unordered_map<std::string, RoleType *> roles_;
+    bool frozen_;
 
   public:
     using RoleContainer = std::unordered_map<std::string, RoleType *>;
 
     /// Session constructor with "default" as Session name.
     SessionTmpl()
-        : name_("default"), type_(ST_TYPE_GLOBAL), me_(), root_(0), roles_() { }
+        : name_("default"), type_(ST_TYPE_GLOBAL), me_(), root_(0), roles_(),
+          frozen_(false) { }
 
     /// Session constructor.
     /// \param[in] name Session name.
     SessionTmpl(std::string name)
-        : name_(name), type_(ST_TYPE_GLOBAL), me_(), root_(0), roles_() { }
+        : name_(name), type_(ST_TYPE_GLOBAL), me_(), root_(0), roles_(),
+          frozen_(false) { }
+
+    /// Session copy constructor, Roles and body are deep copied.
+    /// The copy of a frozen Session is not frozen.
+    SessionTmpl(const SessionTmpl &session)
+        : SessionTmpl(session, session.root_ == NULL ? NULL
+                : dynamic_cast<BaseNode *>(session.root_->clone())) { }
+
+    /// Session copy constructor with a replacement body.
+    /// \param[in] session to copy name, type and (deep copy of) Roles from.
+    /// \param[in] root Node of Session body (owned by the new Session).
+    SessionTmpl(const SessionTmpl &session, BaseNode *root)
+        : name_(session.name_), type_(session.type_), me_(session.me_),
+          root_(root), roles_(), frozen_(false)
+    {
+        for (auto role_pair : session.roles_) {
+            add_role(role_pair.second->clone());
+        }
+        if (me_ != NULL && has_role(me_->name())) {
+            me_ = roles_.at(me_->name());
+        }
+    }
+
+    SessionTmpl &operator=(const SessionTmpl &) = delete;
 
     /// Session destructor.
     virtual ~SessionTmpl()
@@ -71,8 +104,10 @@ class SessionTmpl {
     }
 
     /// \param[in] root Node of Session body.
+    /// \exception std::logic_error if Session is frozen.
     void set_root(BaseNode *root)
     {
+        check_mutable();
         if (root_ != NULL) {
             delete root_;
         }
@@ -92,8 +127,10 @@ class SessionTmpl {
     }
 
     /// \param[in] role Sets endpoint role to endpoint.
+    /// \exception std::logic_error if Session is frozen.
     void set_endpoint(RoleType *endpoint)
     {
+        check_mutable();
         me_ = endpoint;
         type_ = ST_TYPE_LOCAL;
     }
@@ -114,8 +151,10 @@ class SessionTmpl {
 
     /// Add a Role as a participant of the Session.
     /// \param[in] role to add to this Session.
+    /// \exception std::logic_error if Session is frozen.
     void add_role(RoleType *role)
     {
+        check_mutable();
         roles_.insert(std::pair<std::string, RoleType *>(role->name(), role));
     }
 
@@ -158,6 +197,42 @@ class SessionTmpl {
     {
         return roles_.end();
     }
+
+    /// \brief Make Session, its Roles and its body immutable for shared
+    ///        reading (Exprs excluded, see SessionTmpl).
+    ///
+    /// ContinueNodes should be bound (see util::RecurBinder) before the
+    /// Session is frozen, as binding modifies the tree. Freezing a frozen
+    /// Session has no effect.
+    /// \returns this Session, safe to read from any number of threads.
+    const SessionTmpl *freeze()
+    {
+        if (!frozen_) {
+            if (root_ != NULL) {
+                root_->freeze();
+            }
+            for (auto role_pair : roles_) {
+                role_pair.second->freeze();
+            }
+            frozen_ = true;
+        }
+        return this;
+    }
+
+    /// \returns true if Session is frozen.
+    bool is_frozen() const
+    {
+        return frozen_;
+    }
+
+  protected:
+    /// \exception std::logic_error if Session is frozen.
+    void check_mutable() const
+    {
+        if (frozen_) {
+            throw std::logic_error("Session is frozen");
+        }
+    }
 };
 
 using Session = SessionTmpl<Node, Role>;
@@ -191,6 +266,12 @@ st_tree *st_tree_set_root(st_tree *tree, st_node *root);
 /// \returns pointer to root (body of session).
 st_node *st_tree_get_root(st_tree *tree);
 
+/// \brief Bind ContinueNodes and freeze tree for concurrent read access.
+/// \param[in,out] tree pointer to session object.
+/// \returns pointer to frozen session object, or NULL if a ContinueNode
+///          cannot be bound (tree is left unfrozen).
+const st_tree *st_tree_freeze(st_tree *tree);
+
 /// \param[in,out] session object to destroy.
 void st_tree_free(st_tree *tree);
 
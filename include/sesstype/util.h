@@ -5,7 +5,21 @@
 #ifndef SESSTYPE__UTIL_H__
 #define SESSTYPE__UTIL_H__
 
+#include "sesstype/util/bind_recur.h"
+#include "sesstype/util/cfsm.h"
+#include "sesstype/util/channel_bounds.h"
+#include "sesstype/util/explore.h"
+#include "sesstype/util/export.h"
+#include "sesstype/util/graph_export.h"
+#include "sesstype/util/monitor.h"
+#include "sesstype/util/msg_aggregate.h"
+#include "sesstype/util/output_buffer.h"
+#include "sesstype/util/parallel.h"
 #include "sesstype/util/print.h"
 #include "sesstype/util/project.h"
+#include "sesstype/util/text_reader.h"
+#include "sesstype/util/incremental_project.h"
+#include "sesstype/util/trace_check.h"
+#include "sesstype/util/traversal.h"
 
 #endif//SESSTYPE__UTIL_H__
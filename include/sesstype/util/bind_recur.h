@@ -0,0 +1,205 @@
+#ifndef SESSTYPE__UTIL__BIND_RECUR_H__
+#define SESSTYPE__UTIL__BIND_RECUR_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <vector>
+#endif
+
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/node/continue.h"
+#include "sesstype/node/par.h"
+#include "sesstype/node/nested.h"
+#include "sesstype/node/interruptible.h"
+#include "sesstype/util/node_visitor.h"
+#include "sesstype/util/traversal.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Stack of enclosing RecurNode for resolving bound ContinueNode.
+ *
+ * Analyses push each RecurNode on entry and pop it on exit, and can then
+ * find the target of a bound ContinueNode in constant time.
+ */
+template <class RecurType, class ContinueType>
+class RecurScopeTmpl {
+    std::vector<RecurType *> scopes_;
+    std::vector<unsigned long> stamps_; // Largest revision up to each scope.
+
+  public:
+    RecurScopeTmpl() : scopes_(), stamps_() { }
+
+    /// \param[in] recur RecurNode entered.
+    void push(RecurType *recur)
+    {
+        scopes_.push_back(recur);
+        stamps_.push_back(stamps_.empty() ? recur->revision() : std::max(stamps_.back(), recur->revision()));
+    }
+
+    /// \brief Leave the innermost RecurNode.
+    void pop()
+    {
+        scopes_.pop_back();
+        stamps_.pop_back();
+    }
+
+    /// \returns largest revision of the enclosing RecurNodes (0 if none).
+    unsigned long stamp() const
+    {
+        return stamps_.empty() ? 0 : stamps_.back();
+    }
+
+    /// \returns number of enclosing RecurNode.
+    unsigned int depth() const
+    {
+        return scopes_.size();
+    }
+
+    /// \returns RecurNode at scope (0 is the innermost RecurNode).
+    RecurType *at(unsigned int scope) const
+    {
+        return scopes_[scopes_.size() - 1 - scope];
+    }
+
+    /// \returns RecurNode targeted by cont, or nullptr if not found.
+    RecurType *target(ContinueType *cont) const
+    {
+        int idx = find(cont);
+        return idx >= 0 ? scopes_[idx] : nullptr;
+    }
+
+    /// \returns position of the RecurNode targeted by cont, counted from the
+    ///          outermost RecurNode, or -1 if not found.
+    int find(ContinueType *cont) const
+    {
+        if (cont->is_bound() && static_cast<unsigned int>(cont->scope()) < scopes_.size()) {
+            int idx = static_cast<int>(scopes_.size()) - 1 - cont->scope();
+            if (cont->is_bound_to(scopes_[idx], stamp())) {
+                return idx;
+            }
+        }
+        // Unbound or stale ContinueNode: fall back to label lookup.
+        for (int idx=static_cast<int>(scopes_.size())-1; idx>=0; idx--) {
+            if (scopes_[idx]->label() == cont->label()) {
+                return idx;
+            }
+        }
+        return -1;
+    }
+};
+
+using RecurScope = RecurScopeTmpl<RecurNode, ContinueNode>;
+
+/**
+ * \brief Bind each ContinueNode to its enclosing RecurNode.
+ *
+ * ContinueNode with a label that does not match any enclosing RecurNode are
+ * left unbound and the binding is marked as invalid.
+ */
+class RecurBinder : public NodeVisitor {
+    RecurScope scopes_;
+    bool error_;
+
+  public:
+    RecurBinder() : scopes_(), error_(false) { }
+
+    /// \returns true if every ContinueNode visited was bound.
+    bool is_valid() const
+    {
+        return !error_;
+    }
+
+    /// \brief Walker interface for the iterative util::walk.
+    bool enter(Node *node)
+    {
+        if (node->type() == ST_NODE_RECUR) {
+            scopes_.push(dynamic_cast<RecurNode *>(node));
+        } else if (node->type() == ST_NODE_CONTINUE) {
+            bind(dynamic_cast<ContinueNode *>(node));
+        }
+        return node->type() != ST_NODE_NESTED;
+    }
+
+    /// \brief Walker interface for the iterative util::walk.
+    void leave(Node *node)
+    {
+        if (node->type() == ST_NODE_RECUR) {
+            scopes_.pop();
+        }
+    }
+
+    void visit(Node *node) override
+    {
+        walk(node, *this);
+    }
+
+    void visit(BlockNode *node) override
+    {
+        walk(node, *this);
+    }
+
+    void visit(InteractionNode *node) override
+    {
+        // Nothing.
+    }
+
+    void visit(ChoiceNode *node) override
+    {
+        walk(node, *this);
+    }
+
+    void visit(RecurNode *node) override
+    {
+        walk(node, *this);
+    }
+
+    void visit(ContinueNode *node) override
+    {
+        bind(node);
+    }
+
+    void visit(ParNode *node) override
+    {
+        walk(node, *this);
+    }
+
+    void visit(NestedNode *node) override
+    {
+        // Nothing.
+    }
+
+    void visit(InterruptibleNode *node) override
+    {
+        walk(node, *this);
+    }
+
+  private:
+    void bind(ContinueNode *node)
+    {
+        for (unsigned int scope=0; scope<scopes_.depth(); scope++) {
+            RecurNode *recur = scopes_.at(scope);
+            if (recur->label() == node->label()) {
+                node->bind(scope, recur, scopes_.stamp());
+                return;
+            }
+        }
+        error_ = true;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__BIND_RECUR_H__
@@ -0,0 +1,490 @@
+#ifndef SESSTYPE__UTIL__CFSM_H__
+#define SESSTYPE__UTIL__CFSM_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#endif
+
+#include "sesstype/role.h"
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/node/continue.h"
+#include "sesstype/node/par.h"
+#include "sesstype/node/nested.h"
+#include "sesstype/node/interruptible.h"
+#include "sesstype/util/bind_recur.h"
+#include "sesstype/util/node_visitor.h"
+#include "sesstype/util/project.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#define ST_CFSM_SEND 0
+#define ST_CFSM_RECV 1
+
+#ifdef __cplusplus
+/**
+ * \brief Communicating finite-state machine (CFSM) of an endpoint.
+ *
+ * States are dense integers starting from the initial state 0. Transitions
+ * are stored contiguously per state (compressed sparse rows) and sorted by
+ * action, where an action is an interned (direction, peer, label) triple.
+ * The automaton is deterministic: there is at most one transition per action
+ * from any state.
+ */
+class CFSM {
+  public:
+    /// \brief Communication action of a transition.
+    struct Action {
+        unsigned int dir;   ///< ST_CFSM_SEND or ST_CFSM_RECV.
+        unsigned int peer;  ///< Peer id (see CFSM::peer).
+        unsigned int label; ///< Label id (see CFSM::label).
+    };
+
+    /// \brief Transition to target state on action.
+    struct Transition {
+        unsigned int action;
+        unsigned int target;
+    };
+
+    using TransitionContainer = std::vector<Transition>;
+
+  private:
+    std::vector<std::string> peers_;
+    std::vector<std::string> labels_;
+    std::vector<Action> actions_;
+    std::vector<unsigned int> offsets_;
+    std::vector<Transition> transitions_;
+    std::vector<unsigned char> final_;
+
+  public:
+    /// \brief CFSM constructor with a single final state and no transitions.
+    CFSM() : peers_(), labels_(), actions_(), offsets_({ 0, 0 }),
+             transitions_(), final_({ 1 }) { }
+
+    /// \returns the initial state.
+    unsigned int initial() const
+    {
+        return 0;
+    }
+
+    /// \returns number of states.
+    unsigned int num_states() const
+    {
+        return final_.size();
+    }
+
+    /// \returns total number of transitions.
+    unsigned int num_transitions() const
+    {
+        return transitions_.size();
+    }
+
+    /// \returns true if state is a final (terminated) state.
+    bool is_final(unsigned int state) const
+    {
+        return final_.at(state) != 0;
+    }
+
+    /// \returns number of interned peers.
+    unsigned int num_peers() const
+    {
+        return peers_.size();
+    }
+
+    /// \returns name of peer Role with id.
+    std::string peer(unsigned int id) const
+    {
+        return peers_.at(id);
+    }
+
+    /// \returns id of peer Role named name, or -1 if not a peer.
+    int find_peer(std::string name) const
+    {
+        auto it = std::find(peers_.begin(), peers_.end(), name);
+        return (it == peers_.end() ? -1 : it - peers_.begin());
+    }
+
+    /// \returns number of interned labels.
+    unsigned int num_labels() const
+    {
+        return labels_.size();
+    }
+
+    /// \returns message label with id.
+    std::string label(unsigned int id) const
+    {
+        return labels_.at(id);
+    }
+
+    /// \returns id of message label, or -1 if not used.
+    int find_label(std::string label) const
+    {
+        auto it = std::find(labels_.begin(), labels_.end(), label);
+        return (it == labels_.end() ? -1 : it - labels_.begin());
+    }
+
+    /// \returns number of interned actions.
+    unsigned int num_actions() const
+    {
+        return actions_.size();
+    }
+
+    /// \returns action with id.
+    const Action &action(unsigned int id) const
+    {
+        return actions_.at(id);
+    }
+
+    /// \returns id of action (dir, peer, label), or -1 if not used.
+    int find_action(unsigned int dir, std::string peer, std::string label) const
+    {
+        int peer_id = find_peer(peer);
+        int label_id = find_label(label);
+        for (unsigned int id=0; id<actions_.size(); id++) {
+            if (actions_[id].dir == dir &&
+                    static_cast<int>(actions_[id].peer) == peer_id &&
+                    static_cast<int>(actions_[id].label) == label_id) {
+                return id;
+            }
+        }
+        return -1;
+    }
+
+    /// \returns target state of action from state, or -1 if not enabled.
+    int next(unsigned int state, unsigned int action) const
+    {
+        auto begin = transitions_.begin() + offsets_.at(state);
+        auto end = transitions_.begin() + offsets_.at(state + 1);
+        auto it = std::lower_bound(begin, end, action,
+                [](const Transition &t, unsigned int a) -> bool { return t.action < a; });
+        if (it != end && it->action == action) {
+            return it->target;
+        }
+        return -1;
+    }
+
+    /// \returns number of transitions from state.
+    unsigned int num_transitions(unsigned int state) const
+    {
+        return offsets_.at(state + 1) - offsets_.at(state);
+    }
+
+    /// \brief Start iterator for transitions from state.
+    TransitionContainer::const_iterator transition_begin(unsigned int state) const
+    {
+        return transitions_.begin() + offsets_.at(state);
+    }
+
+    /// \brief End iterator for transitions from state.
+    TransitionContainer::const_iterator transition_end(unsigned int state) const
+    {
+        return transitions_.begin() + offsets_.at(state + 1);
+    }
+
+    friend class CFSMBuilder;
+};
+
+/**
+ * \brief Compile a projected (local) Node tree into a CFSM.
+ *
+ * A local InteractionNode with a <tt>from</tt> Role is a receive, one with
+ * <tt>to</tt> Roles is a send to each of the Roles in turn. ChoiceNode
+ * branches, RecurNode/ContinueNode loops and interleaved ParNode branches
+ * are compiled into a nondeterministic automaton which is then determinised.
+ * ContinueNode are resolved by their bound scope where available (see
+ * RecurBinder), otherwise by label.
+ *
+ * NestedNode, and ContinueNode escaping a ParNode branch, are not supported
+ * and make the result invalid. InterruptibleNode are compiled as their
+ * body (interrupts are ignored).
+ */
+class CFSMBuilder : public NodeVisitor {
+    struct Edge {
+        int action; // -1 for an epsilon transition.
+        unsigned int target;
+    };
+
+    CFSM *fsm_;
+    std::vector<std::vector<Edge>> nfa_;
+    RecurScope scopes_;
+    std::vector<unsigned int> recur_states_; // State of each RecurNode in scopes_.
+    std::map<std::pair<unsigned int, std::pair<unsigned int, unsigned int>>, unsigned int> action_ids_;
+    unsigned int par_floor_;
+    unsigned int final_;
+    unsigned int cur_;
+    bool error_;
+
+  public:
+    CFSMBuilder() : fsm_(new CFSM()), nfa_(), scopes_(), recur_states_(), action_ids_(),
+                    par_floor_(0), final_(0), cur_(0), error_(false)
+    {
+        final_ = new_state();
+        cur_ = final_;
+    }
+
+    ~CFSMBuilder()
+    {
+        delete fsm_;
+    }
+
+    CFSMBuilder(const CFSMBuilder &) = delete;
+    CFSMBuilder &operator=(const CFSMBuilder &) = delete;
+
+    /// \brief Project a global tree for endpoint and compile it.
+    /// \param[in] global root Node of the global tree.
+    /// \param[in] endpoint Role to project for.
+    /// \returns dynamically allocated CFSM, or nullptr if not valid.
+    static CFSM *compile(Node *global, Role *endpoint)
+    {
+        ProjectionVisitor projector(endpoint);
+        global->accept(projector);
+        auto *local = projector.get_root();
+        CFSMBuilder builder;
+        local->accept(builder);
+        delete local;
+        return builder.build();
+    }
+
+    /// \returns true if the visited tree could be compiled.
+    bool is_valid() const
+    {
+        return !error_;
+    }
+
+    /// \brief Determinise and lay out the CFSM of the visited tree.
+    /// \returns dynamically allocated CFSM, or nullptr if not valid.
+    CFSM *build()
+    {
+        if (error_) {
+            return nullptr;
+        }
+        CFSM *fsm = fsm_;
+        fsm_ = nullptr;
+
+        std::map<std::vector<unsigned int>, unsigned int> ids;
+        std::vector<std::vector<unsigned int>> dstates;
+        std::vector<unsigned int> start = closure({ cur_ });
+        ids.insert({ start, 0 });
+        dstates.push_back(start);
+
+        fsm->offsets_.assign(1, 0);
+        fsm->final_.clear();
+        fsm->transitions_.clear();
+        for (unsigned int d=0; d<dstates.size(); d++) {
+            std::map<unsigned int, std::vector<unsigned int>> moves;
+            bool is_final = false;
+            for (auto s : dstates[d]) {
+                is_final |= (s == final_);
+                for (auto &e : nfa_[s]) {
+                    if (e.action >= 0) {
+                        moves[e.action].push_back(e.target);
+                    }
+                }
+            }
+            for (auto &move : moves) {
+                std::vector<unsigned int> target = closure(move.second);
+                auto it = ids.find(target);
+                if (it == ids.end()) {
+                    it = ids.insert({ target, dstates.size() }).first;
+                    dstates.push_back(target);
+                }
+                fsm->transitions_.push_back(CFSM::Transition { move.first, it->second });
+            }
+            fsm->offsets_.push_back(fsm->transitions_.size());
+            fsm->final_.push_back(is_final ? 1 : 0);
+        }
+        return fsm;
+    }
+
+    void visit(Node *node) override
+    {
+        // Nothing.
+    }
+
+    void visit(BlockNode *node) override
+    {
+        for (unsigned int i=node->num_children(); i>0; i--) {
+            node->child(i - 1)->accept(*this);
+        }
+    }
+
+    void visit(InteractionNode *node) override
+    {
+        if (node->sndr() && node->num_rcvrs() > 0) {
+            error_ = true; // Not a projected Node.
+            return;
+        }
+        if (node->sndr()) {
+            unsigned int s = new_state();
+            add_edge(s, intern(ST_CFSM_RECV, node->sndr()->name(), node->msg()->label()), cur_);
+            cur_ = s;
+            return;
+        }
+        for (unsigned int i=node->num_rcvrs(); i>0; i--) {
+            unsigned int s = new_state();
+            add_edge(s, intern(ST_CFSM_SEND, node->rcvr(i - 1)->name(), node->msg()->label()), cur_);
+            cur_ = s;
+        }
+    }
+
+    void visit(ChoiceNode *node) override
+    {
+        unsigned int next = cur_;
+        unsigned int choice = new_state();
+        for (auto it=node->child_begin(); it!=node->child_end(); it++) {
+            cur_ = next;
+            (*it)->accept(*this);
+            add_edge(choice, -1, cur_);
+        }
+        cur_ = choice;
+    }
+
+    void visit(RecurNode *node) override
+    {
+        unsigned int recur = new_state();
+        scopes_.push(node);
+        recur_states_.push_back(recur);
+        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
+        scopes_.pop();
+        recur_states_.pop_back();
+        add_edge(recur, -1, cur_);
+        cur_ = recur;
+    }
+
+    void visit(ContinueNode *node) override
+    {
+        int idx = scopes_.find(node);
+        if (idx < static_cast<int>(par_floor_)) {
+            error_ = true; // Unbound, or escaping a parallel branch.
+            return;
+        }
+        cur_ = recur_states_[idx];
+    }
+
+    void visit(ParNode *node) override
+    {
+        unsigned int next = cur_;
+        unsigned int floor = par_floor_;
+        par_floor_ = scopes_.depth();
+
+        std::vector<unsigned int> entries, finals;
+        for (auto it=node->child_begin(); it!=node->child_end(); it++) {
+            cur_ = new_state();
+            finals.push_back(cur_);
+            (*it)->accept(*this);
+            entries.push_back(cur_);
+        }
+        par_floor_ = floor;
+
+        // Interleaving (product) of the branches.
+        std::map<std::vector<unsigned int>, unsigned int> ids;
+        std::vector<std::vector<unsigned int>> pending { entries };
+        ids.insert({ entries, new_state() });
+        while (!pending.empty()) {
+            std::vector<unsigned int> states = pending.back();
+            pending.pop_back();
+            unsigned int from = ids[states];
+            if (states == finals) {
+                add_edge(from, -1, next);
+            }
+            for (unsigned int b=0; b<states.size(); b++) {
+                for (unsigned int e=0; e<nfa_[states[b]].size(); e++) {
+                    Edge edge = nfa_[states[b]][e];
+                    std::vector<unsigned int> target = states;
+                    target[b] = edge.target;
+                    auto found = ids.find(target);
+                    if (found == ids.end()) {
+                        found = ids.insert({ target, new_state() }).first;
+                        pending.push_back(target);
+                    }
+                    add_edge(from, edge.action, found->second);
+                }
+            }
+        }
+        cur_ = ids[entries];
+    }
+
+    void visit(NestedNode *node) override
+    {
+        error_ = true;
+    }
+
+    void visit(InterruptibleNode *node) override
+    {
+        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
+    }
+
+  private:
+    unsigned int new_state()
+    {
+        nfa_.push_back(std::vector<Edge>());
+        return nfa_.size() - 1;
+    }
+
+    void add_edge(unsigned int from, int action, unsigned int to)
+    {
+        nfa_[from].push_back(Edge { action, to });
+    }
+
+    unsigned int intern(unsigned int dir, std::string peer, std::string label)
+    {
+        int peer_id = fsm_->find_peer(peer);
+        if (peer_id < 0) {
+            fsm_->peers_.push_back(peer);
+            peer_id = fsm_->peers_.size() - 1;
+        }
+        int label_id = fsm_->find_label(label);
+        if (label_id < 0) {
+            fsm_->labels_.push_back(label);
+            label_id = fsm_->labels_.size() - 1;
+        }
+        auto key = std::make_pair(dir, std::make_pair(peer_id, label_id));
+        auto it = action_ids_.find(key);
+        if (it == action_ids_.end()) {
+            fsm_->actions_.push_back(CFSM::Action { dir,
+                    static_cast<unsigned int>(peer_id),
+                    static_cast<unsigned int>(label_id) });
+            it = action_ids_.insert({ key, fsm_->actions_.size() - 1 }).first;
+        }
+        return it->second;
+    }
+
+    /// Epsilon-closure of a set of NFA states, as a sorted vector.
+    std::vector<unsigned int> closure(std::vector<unsigned int> states)
+    {
+        std::vector<unsigned char> seen(nfa_.size(), 0);
+        std::vector<unsigned int> result;
+        while (!states.empty()) {
+            unsigned int s = states.back();
+            states.pop_back();
+            if (seen[s]) continue;
+            seen[s] = 1;
+            result.push_back(s);
+            for (auto &e : nfa_[s]) {
+                if (e.action < 0 && !seen[e.target]) {
+                    states.push_back(e.target);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__CFSM_H__
@@ -0,0 +1,202 @@
+#ifndef SESSTYPE__UTIL__CHANNEL_BOUNDS_H__
+#define SESSTYPE__UTIL__CHANNEL_BOUNDS_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/session.h"
+#include "sesstype/util/cfsm.h"
+#include "sesstype/util/explore.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Maximum number of in-flight messages on each channel of a Session.
+ *
+ * Every Role is projected and compiled into a CFSM (so ParNode branches are
+ * interleaved and RecurNode bodies repeated), and the reachable states of
+ * the communicating CFSMs are explored (see Explorer, without partial-order
+ * reduction) with every channel bounded. The bound starts at 1 and is
+ * doubled while a send is blocked by it. Once no send is blocked, the
+ * exploration covers every behaviour of the unbounded system, and the
+ * largest occupancy of each channel is its exact bound. A queue which is
+ * still blocked at max_bound() is reported as unbounded: its senders can run
+ * ahead of its receiver by at least max_bound() messages (e.g. a send in a
+ * loop which is never matched by a synchronising message back). Within such
+ * a queue, a label is reported as unbounded only if its largest occupancy
+ * still grew with the last doubling of the bound; a label which stopped
+ * growing (e.g. a message sent once before the loop) is reported as bounded.
+ *
+ * While a send is blocked, the behaviours after it are not explored, so the
+ * occupancy of every other channel may be too small as well. If any channel
+ * is still blocked at max_bound() (or the state limit is reached), every
+ * bound is only a lower bound: is_exact() and Channel::exact are false for
+ * all channels, not only for the unbounded ones.
+ */
+class ChannelBounds {
+  public:
+    /// \brief Bound of messages with one label on one channel.
+    struct Channel {
+        std::string sender;
+        std::string receiver;
+        std::string label;
+        unsigned int bound;  ///< Largest number of such messages in flight.
+        bool bounded;        ///< false if the label still grew with the last bound.
+        bool exact;          ///< false if bound is only a lower bound.
+    };
+
+  private:
+    Explorer explorer_;
+    std::vector<Channel> channels_;
+    std::vector<unsigned int> queue_bounds_; // Per (sender, receiver), all labels.
+    std::vector<bool> queue_bounded_;
+    unsigned int max_bound_;
+    bool complete_;
+    bool exact_;
+
+  public:
+    /// \brief ChannelBounds constructor.
+    /// \param[in] session global Session, every Role is projected.
+    /// \exception std::invalid_argument if a Role cannot be compiled.
+    explicit ChannelBounds(const Session *session)
+        : explorer_(session), channels_(), queue_bounds_(), queue_bounded_(),
+          max_bound_(64), complete_(true), exact_(true)
+    {
+        explorer_.set_reduction(false);
+    }
+
+    ChannelBounds(const ChannelBounds &) = delete;
+    ChannelBounds &operator=(const ChannelBounds &) = delete;
+
+    /// \param[in] max_bound largest channel bound explored.
+    void set_max_bound(unsigned int max_bound)
+    {
+        max_bound_ = std::max(1u, max_bound);
+    }
+
+    unsigned int max_bound() const
+    {
+        return max_bound_;
+    }
+
+    /// \param[in] max_states maximum number of global states per exploration.
+    void set_max_states(unsigned long max_states)
+    {
+        explorer_.set_max_states(max_states);
+    }
+
+    /// \param[in] num_threads number of worker threads (0 for auto).
+    void set_num_threads(unsigned int num_threads)
+    {
+        explorer_.set_num_threads(num_threads);
+    }
+
+    /// \brief Compute the bounds.
+    /// \returns true if every (sender, receiver) queue is bounded.
+    bool run()
+    {
+        unsigned int n = explorer_.num_roles();
+        Explorer::Report report;
+        std::vector<unsigned int> last_count; // max_count at the previous bound.
+        for (unsigned int bound=1; ; bound=std::min(2 * bound, max_bound_)) {
+            explorer_.set_channel_bound(bound);
+            last_count.swap(report.max_count);
+            report = explorer_.run();
+            if (!report.saturated || bound == max_bound_) {
+                break;
+            }
+        }
+        complete_ = report.complete;
+        exact_ = report.complete && !report.saturated;
+
+        // Every label each Role can send to each peer.
+        std::vector<bool> sent(n * n * explorer_.num_labels(), false);
+        for (unsigned int r=0; r<n; r++) {
+            const CFSM *fsm = explorer_.fsm(r);
+            for (unsigned int a=0; a<fsm->num_actions(); a++) {
+                const CFSM::Action &action = fsm->action(a);
+                if (action.dir != ST_CFSM_SEND) {
+                    continue;
+                }
+                for (unsigned int p=0; p<n; p++) {
+                    if (explorer_.role(p) != fsm->peer(action.peer)) {
+                        continue;
+                    }
+                    for (unsigned int l=0; l<explorer_.num_labels(); l++) {
+                        if (explorer_.label(l) == fsm->label(action.label)) {
+                            sent[(r * n + p) * explorer_.num_labels() + l] = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        channels_.clear();
+        bool bounded = true;
+        for (unsigned int c=0; c<n*n; c++) {
+            for (unsigned int l=0; l<explorer_.num_labels(); l++) {
+                unsigned int k = c * explorer_.num_labels() + l;
+                if (!sent[k]) {
+                    continue;
+                }
+                bool grew = last_count.empty() || report.max_count[k] > last_count[k];
+                bool label_bounded = !(report.blocked[c] && grew);
+                channels_.push_back(Channel { explorer_.role(c / n), explorer_.role(c % n),
+                        explorer_.label(l), report.max_count[k], label_bounded, exact_ });
+            }
+            bounded &= !report.blocked[c];
+        }
+        queue_bounds_ = report.max_length;
+        queue_bounded_ = report.blocked;
+        queue_bounded_.flip();
+        return bounded;
+    }
+
+    /// \returns false if an exploration reached the state limit, so bounds
+    ///          may be too small.
+    bool is_complete() const
+    {
+        return complete_;
+    }
+
+    /// \returns false if a channel is unbounded or an exploration was
+    ///          incomplete, so every bound is only a lower bound.
+    bool is_exact() const
+    {
+        return exact_;
+    }
+
+    /// \returns bound of each (sender, receiver, label) channel used by a send.
+    const std::vector<Channel> &channels() const
+    {
+        return channels_;
+    }
+
+    /// \returns bound of the FIFO queue from sender to receiver (all labels),
+    ///          or -1 if it is unbounded (a lower bound unless is_exact()).
+    long queue_bound(const std::string &sender, const std::string &receiver) const
+    {
+        unsigned int n = explorer_.num_roles();
+        for (unsigned int c=0; c<queue_bounds_.size(); c++) {
+            if (explorer_.role(c / n) == sender && explorer_.role(c % n) == receiver) {
+                return queue_bounded_[c] ? static_cast<long>(queue_bounds_[c]) : -1;
+            }
+        }
+        return 0;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__CHANNEL_BOUNDS_H__
@@ -0,0 +1,566 @@
+#ifndef SESSTYPE__UTIL__EXPLORE_H__
+#define SESSTYPE__UTIL__EXPLORE_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#endif
+
+#include "sesstype/session.h"
+#include "sesstype/util/cfsm.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Parallel state-space explorer of communicating endpoints.
+ *
+ * The explored system is the product of one CFSM per Role, communicating
+ * through a bounded FIFO channel for every ordered pair of Roles. Reachable
+ * global states are discovered by a pool of workers with work-stealing
+ * queues and recorded in a lock-free hashed visited-set of 64-bit state
+ * fingerprints (hash compaction, so a fingerprint collision may in
+ * principle hide a state).
+ *
+ * Terminal global states are classified as
+ *  - deadlock, if some Role is not in a final state, or
+ *  - orphan message, if every Role is final but a channel is not empty,
+ * and reported with a witness trace from the initial state. A state without
+ * successors in which some send is blocked by the channel bound is not
+ * terminal (it may proceed with a larger bound): it is reported as
+ * saturated with its own witness, and never as a deadlock.
+ *
+ * Partial-order reduction: when all transitions of one Role are enabled,
+ * they are independent of every other Role's transitions, and only that
+ * Role is expanded (an ample set). This preserves all terminal states.
+ *
+ * The largest occupancy of every channel seen in a visited state is
+ * reported, in total and per message label, with the channels on which a
+ * send was blocked by the bound. The reduction may skip the states of
+ * largest occupancy, so it can be disabled with set_reduction(false).
+ */
+class Explorer {
+  public:
+    /// \brief A step of a witness trace: Role index and its CFSM action id.
+    struct Step {
+        unsigned int role;
+        unsigned int action;
+    };
+
+    /// \brief Result of an exploration.
+    struct Report {
+        unsigned long num_states;        ///< Number of global states visited.
+        bool complete;                   ///< false if max_states was reached.
+        bool saturated;                  ///< true if a send found its channel full.
+        std::vector<Step> saturated_trace; ///< Witness of a state stuck only on full channels.
+        bool deadlock;                   ///< true if a non-final state is stuck without a full channel.
+        std::vector<Step> deadlock_trace;
+        bool orphan;
+        std::vector<Step> orphan_trace;
+        std::vector<unsigned int> max_length; ///< Per channel (from * num_roles + to).
+        std::vector<unsigned int> max_count;  ///< Per channel and label (channel * num_labels + label).
+        std::vector<bool> blocked;            ///< Per channel, true if a send found it full.
+    };
+
+  private:
+    /// Action of a Role resolved against the Role indices and global labels.
+    struct Move {
+        unsigned int dir;
+        int peer;
+        unsigned int label;
+    };
+
+    /// Lock-free open-addressing set of fingerprints with parent links.
+    class VisitedSet {
+        struct Slot {
+            std::atomic<std::uint64_t> key;
+            std::uint64_t parent;
+            Step step;
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        std::uint64_t mask_;
+
+      public:
+        explicit VisitedSet(unsigned long capacity) : slots_(), mask_(1)
+        {
+            while (mask_ < 2 * capacity) {
+                mask_ <<= 1;
+            }
+            slots_.reset(new Slot[mask_]());
+            mask_--;
+        }
+
+        /// \returns true if key was inserted, false if already present.
+        bool insert(std::uint64_t key, std::uint64_t parent, Step step)
+        {
+            for (std::uint64_t probe=0; probe<=mask_; probe++) {
+                Slot &slot = slots_[(key + probe) & mask_];
+                std::uint64_t cur = slot.key.load(std::memory_order_acquire);
+                if (cur == 0 && slot.key.compare_exchange_strong(cur, key,
+                            std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    slot.parent = parent;
+                    slot.step = step;
+                    return true;
+                }
+                if (cur == key) {
+                    return false;
+                }
+            }
+            throw std::length_error("Visited set is full");
+        }
+
+        /// \returns Slot of key, or nullptr if not present.
+        const Slot *find(std::uint64_t key) const
+        {
+            for (std::uint64_t probe=0; probe<=mask_; probe++) {
+                const Slot &slot = slots_[(key + probe) & mask_];
+                std::uint64_t cur = slot.key.load(std::memory_order_acquire);
+                if (cur == key) {
+                    return &slot;
+                }
+                if (cur == 0) {
+                    return nullptr;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    /// Global state: Role states, then per channel its length and labels.
+    using State = std::vector<std::uint32_t>;
+
+    struct Item {
+        State state;
+        std::uint64_t fp;
+    };
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Item> items;
+    };
+
+    std::vector<std::string> roles_;
+    std::vector<const CFSM *> fsms_;
+    std::vector<std::unique_ptr<CFSM>> owned_;
+    std::vector<std::vector<Move>> moves_;
+    std::vector<std::string> labels_;
+    unsigned int num_threads_;
+    unsigned int bound_;
+    unsigned long max_states_;
+    bool reduction_;
+
+  public:
+    /// \brief Explorer constructor from CFSMs of the Roles.
+    /// \param[in] roles names of the Roles, matching the CFSM peer names.
+    /// \param[in] fsms CFSM of each Role (not owned).
+    Explorer(std::vector<std::string> roles, std::vector<const CFSM *> fsms)
+        : roles_(roles), fsms_(fsms), owned_(), moves_(), labels_(),
+          num_threads_(0), bound_(4), max_states_(1 << 18), reduction_(true)
+    {
+        init();
+    }
+
+    /// \brief Explorer constructor from a global Session.
+    /// \param[in] session global Session, every Role is projected.
+    /// \exception std::invalid_argument if a Role cannot be compiled.
+    explicit Explorer(const Session *session)
+        : roles_(), fsms_(), owned_(), moves_(), labels_(),
+          num_threads_(0), bound_(4), max_states_(1 << 18), reduction_(true)
+    {
+        for (auto it=session->role_begin(); it!=session->role_end(); it++) {
+            roles_.push_back(it->first);
+        }
+        std::sort(roles_.begin(), roles_.end());
+        for (auto &name : roles_) {
+            CFSM *fsm = (session->root() == nullptr ? new CFSM()
+                    : CFSMBuilder::compile(session->root(), session->role(name)));
+            if (fsm == nullptr) {
+                throw std::invalid_argument("Cannot compile Role " + name);
+            }
+            owned_.emplace_back(fsm);
+            fsms_.push_back(fsm);
+        }
+        init();
+    }
+
+    Explorer(const Explorer &) = delete;
+    Explorer &operator=(const Explorer &) = delete;
+
+    /// \returns number of Roles.
+    unsigned int num_roles() const
+    {
+        return roles_.size();
+    }
+
+    /// \returns name of Role with index.
+    std::string role(unsigned int idx) const
+    {
+        return roles_.at(idx);
+    }
+
+    /// \returns CFSM of Role with index.
+    const CFSM *fsm(unsigned int idx) const
+    {
+        return fsms_.at(idx);
+    }
+
+    /// \returns number of message labels used by the Roles.
+    unsigned int num_labels() const
+    {
+        return labels_.size();
+    }
+
+    /// \returns message label with index (see Report::max_count).
+    std::string label(unsigned int idx) const
+    {
+        return labels_.at(idx);
+    }
+
+    /// \param[in] num_threads number of worker threads (0 for auto).
+    void set_num_threads(unsigned int num_threads)
+    {
+        num_threads_ = num_threads;
+    }
+
+    /// \param[in] bound capacity of each channel.
+    void set_channel_bound(unsigned int bound)
+    {
+        bound_ = bound;
+    }
+
+    /// \param[in] max_states maximum number of global states to visit.
+    void set_max_states(unsigned long max_states)
+    {
+        max_states_ = max_states;
+    }
+
+    /// \param[in] reduction false to expand every Role in every state, e.g.
+    ///            so that the reported channel occupancy is exact.
+    void set_reduction(bool reduction)
+    {
+        reduction_ = reduction;
+    }
+
+    /// \brief Explore the reachable global states.
+    /// \returns Report of the exploration.
+    Report run()
+    {
+        unsigned int n = roles_.size();
+        Report report { 0, true, false, {}, false, {}, false, {},
+            std::vector<unsigned int>(n * n, 0),
+            std::vector<unsigned int>(n * n * labels_.size(), 0),
+            std::vector<bool>(n * n, false) };
+        std::mutex occupancy_mutex;
+        VisitedSet visited(max_states_);
+        std::atomic<unsigned long> num_states(1);
+        std::atomic<long> pending(1);
+        std::atomic<bool> complete(true), saturated(false);
+        std::mutex report_mutex;
+        std::uint64_t deadlock_fp = 0, orphan_fp = 0, saturated_fp = 0;
+
+        unsigned int num_threads = num_threads_;
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        std::vector<WorkQueue> queues(num_threads);
+
+        State init(roles_.size() + roles_.size() * roles_.size(), 0);
+        for (unsigned int r=0; r<roles_.size(); r++) {
+            init[r] = fsms_[r]->initial();
+        }
+        std::uint64_t init_fp = fingerprint(init);
+        visited.insert(init_fp, 0, Step { 0, 0 });
+        queues[0].items.push_back(Item { init, init_fp });
+
+        auto worker = [&](unsigned int tid) {
+            std::vector<std::pair<State, Step>> succs;
+            std::vector<unsigned int> max_length(n * n, 0), max_count(n * n * labels_.size(), 0);
+            std::vector<char> blocked(n * n, 0);
+            if (tid == 0) {
+                occupancy(init, max_length, max_count);
+            }
+            while (pending.load(std::memory_order_acquire) > 0) {
+                Item item;
+                if (!pop(queues, tid, item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                succs.clear();
+                bool full = expand(item.state, succs, blocked);
+                if (succs.empty()) {
+                    int kind = classify(item.state, full);
+                    if (kind != 0) {
+                        std::lock_guard<std::mutex> lock(report_mutex);
+                        if (kind == 1 && deadlock_fp == 0) deadlock_fp = item.fp;
+                        if (kind == 2 && orphan_fp == 0) orphan_fp = item.fp;
+                        if (kind == 3 && saturated_fp == 0) saturated_fp = item.fp;
+                    }
+                }
+                for (auto &succ : succs) {
+                    std::uint64_t fp = fingerprint(succ.first);
+                    if (visited.find(fp) != nullptr) {
+                        continue;
+                    }
+                    if (num_states.load(std::memory_order_relaxed) >= max_states_) {
+                        complete = false;
+                        continue;
+                    }
+                    if (visited.insert(fp, item.fp, succ.second)) {
+                        occupancy(succ.first, max_length, max_count);
+                        num_states++;
+                        pending++;
+                        std::lock_guard<std::mutex> lock(queues[tid].mutex);
+                        queues[tid].items.push_back(Item { std::move(succ.first), fp });
+                    }
+                }
+                pending--;
+            }
+
+            std::lock_guard<std::mutex> lock(occupancy_mutex);
+            for (unsigned int c=0; c<n*n; c++) {
+                report.max_length[c] = std::max(report.max_length[c], max_length[c]);
+                if (blocked[c]) {
+                    report.blocked[c] = true;
+                    saturated = true;
+                }
+            }
+            for (unsigned int k=0; k<max_count.size(); k++) {
+                report.max_count[k] = std::max(report.max_count[k], max_count[k]);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int t=1; t<num_threads; t++) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        report.num_states = num_states;
+        report.complete = complete;
+        report.saturated = saturated;
+        if (deadlock_fp != 0) {
+            report.deadlock = true;
+            report.deadlock_trace = witness(visited, deadlock_fp, init_fp);
+        }
+        if (orphan_fp != 0) {
+            report.orphan = true;
+            report.orphan_trace = witness(visited, orphan_fp, init_fp);
+        }
+        if (saturated_fp != 0) {
+            report.saturated_trace = witness(visited, saturated_fp, init_fp);
+        }
+        return report;
+    }
+
+  private:
+    void init()
+    {
+        std::unordered_map<std::string, unsigned int> role_idx, labels;
+        for (unsigned int r=0; r<roles_.size(); r++) {
+            role_idx.insert({ roles_[r], r });
+        }
+        for (auto *fsm : fsms_) {
+            std::vector<Move> moves;
+            for (unsigned int a=0; a<fsm->num_actions(); a++) {
+                auto peer = role_idx.find(fsm->peer(fsm->action(a).peer));
+                auto label = labels.insert({ fsm->label(fsm->action(a).label), labels.size() }).first;
+                if (label->second == labels_.size()) {
+                    labels_.push_back(label->first);
+                }
+                moves.push_back(Move { fsm->action(a).dir,
+                        (peer == role_idx.end() ? -1 : static_cast<int>(peer->second)),
+                        label->second });
+            }
+            moves_.push_back(moves);
+        }
+    }
+
+    static std::uint64_t fingerprint(const State &state)
+    {
+        std::uint64_t h = 0xcbf29ce484222325ULL;
+        for (auto word : state) {
+            h = (h ^ word) * 0x100000001b3ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return (h == 0 ? 1 : h);
+    }
+
+    /// Offsets of the length word of each channel (from * n + to).
+    void channel_offsets(const State &state, std::vector<unsigned int> &offsets) const
+    {
+        unsigned int n = roles_.size();
+        offsets.resize(n * n);
+        unsigned int pos = n;
+        for (unsigned int c=0; c<n*n; c++) {
+            offsets[c] = pos;
+            pos += 1 + state[pos];
+        }
+    }
+
+    /// Raise the occupancy of each channel and label to that of state.
+    void occupancy(const State &state, std::vector<unsigned int> &max_length,
+                   std::vector<unsigned int> &max_count) const
+    {
+        unsigned int n = roles_.size(), num_labels = labels_.size();
+        std::vector<unsigned int> count(num_labels);
+        unsigned int pos = n;
+        for (unsigned int c=0; c<n*n; c++) {
+            unsigned int len = state[pos];
+            max_length[c] = std::max(max_length[c], len);
+            if (len > 0) {
+                std::fill(count.begin(), count.end(), 0);
+                for (unsigned int i=0; i<len; i++) {
+                    unsigned int label = state[pos + 1 + i];
+                    count[label]++;
+                    max_count[c * num_labels + label] = std::max(max_count[c * num_labels + label], count[label]);
+                }
+            }
+            pos += 1 + len;
+        }
+    }
+
+    /// Successors of state, restricted to an ample set where possible.
+    /// \returns true if a send of state was blocked by the channel bound
+    ///          (only reliable if there are no successors).
+    bool expand(const State &state, std::vector<std::pair<State, Step>> &succs, std::vector<char> &blocked) const
+    {
+        bool full = false;
+        unsigned int n = roles_.size();
+        std::vector<unsigned int> offsets;
+        channel_offsets(state, offsets);
+
+        int ample = -1;
+        for (unsigned int r=0; r<n && ample<0 && reduction_; r++) {
+            const CFSM *fsm = fsms_[r];
+            bool all = fsm->num_transitions(state[r]) > 0;
+            for (auto it=fsm->transition_begin(state[r]); all && it!=fsm->transition_end(state[r]); it++) {
+                all = enabled(state, offsets, r, moves_[r][it->action], blocked, full);
+            }
+            if (all) {
+                ample = r;
+            }
+        }
+
+        for (unsigned int r=0; r<n; r++) {
+            if (ample >= 0 && static_cast<unsigned int>(ample) != r) continue;
+            const CFSM *fsm = fsms_[r];
+            for (auto it=fsm->transition_begin(state[r]); it!=fsm->transition_end(state[r]); it++) {
+                const Move &move = moves_[r][it->action];
+                if (!enabled(state, offsets, r, move, blocked, full)) continue;
+                State next(state);
+                next[r] = it->target;
+                if (move.dir == ST_CFSM_SEND) {
+                    unsigned int off = offsets[r * n + move.peer];
+                    next.insert(next.begin() + off + 1 + next[off], move.label);
+                    next[off]++;
+                } else {
+                    unsigned int off = offsets[move.peer * n + r];
+                    next.erase(next.begin() + off + 1);
+                    next[off]--;
+                }
+                succs.push_back({ std::move(next), Step { r, it->action } });
+            }
+        }
+        return full;
+    }
+
+    bool enabled(const State &state, const std::vector<unsigned int> &offsets,
+                 unsigned int role, const Move &move, std::vector<char> &blocked, bool &full) const
+    {
+        unsigned int n = roles_.size();
+        if (move.peer < 0) {
+            return false;
+        }
+        if (move.dir == ST_CFSM_SEND) {
+            if (state[offsets[role * n + move.peer]] >= bound_) {
+                blocked[role * n + move.peer] = 1;
+                full = true;
+                return false;
+            }
+            return true;
+        }
+        unsigned int off = offsets[move.peer * n + role];
+        return state[off] > 0 && state[off + 1] == move.label;
+    }
+
+    /// \param[in] full true if a send of state is blocked by the channel bound.
+    /// \returns 0 if terminated, 1 if deadlock, 2 if orphan messages, 3 if
+    ///          only stuck because of the channel bound.
+    int classify(const State &state, bool full) const
+    {
+        if (full) {
+            return 3;
+        }
+        unsigned int n = roles_.size();
+        for (unsigned int r=0; r<n; r++) {
+            if (!fsms_[r]->is_final(state[r])) {
+                return 1;
+            }
+        }
+        return (state.size() > n + n * n ? 2 : 0);
+    }
+
+    static bool pop(std::vector<WorkQueue> &queues, unsigned int tid, Item &item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[tid].mutex);
+            if (!queues[tid].items.empty()) {
+                item = std::move(queues[tid].items.front());
+                queues[tid].items.pop_front();
+                return true;
+            }
+        }
+        // Steal from the back of another worker's queue.
+        for (unsigned int i=1; i<queues.size(); i++) {
+            WorkQueue &victim = queues[(tid + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty()) {
+                item = std::move(victim.items.back());
+                victim.items.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Step> witness(const VisitedSet &visited, std::uint64_t fp, std::uint64_t init_fp) const
+    {
+        std::vector<Step> trace;
+        while (fp != init_fp && trace.size() < max_states_) {
+            auto *slot = visited.find(fp);
+            if (slot == nullptr) {
+                break;
+            }
+            trace.push_back(slot->step);
+            fp = slot->parent;
+        }
+        std::reverse(trace.begin(), trace.end());
+        return trace;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__EXPLORE_H__
@@ -0,0 +1,637 @@
+#ifndef SESSTYPE__UTIL__EXPORT_H__
+#define SESSTYPE__UTIL__EXPORT_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/module.h"
+#include "sesstype/msg.h"
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/continue.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/node/interruptible.h"
+#include "sesstype/node/nested.h"
+#include "sesstype/node/par.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/session.h"
+#include "sesstype/util/output_buffer.h"
+#include "sesstype/util/traversal.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Streaming JSON exporter.
+ *
+ * Writes a Node tree, Session or Module as a single JSON value into an
+ * OutputBuffer. The tree is traversed iteratively (see util::walk), so
+ * neither the size nor the depth of the tree is limited by the call stack.
+ *
+ * Nodes are objects with a "node" member naming their kind, e.g.
+ *
+ *     {"node":"interaction","from":"A","to":["B"],
+ *      "msg":{"label":"L","payloads":[{"type":"int","name":"x"}]}}
+ *
+ * and block-like Nodes (block, recur, choice, par, interruptible) have an
+ * array of "children".
+ */
+class JsonExport {
+    OutputBuffer &buf_;
+    std::vector<bool> first_; // First element of each open children array?
+    bool error_;
+
+  public:
+    explicit JsonExport(OutputBuffer &buf) : buf_(buf), first_(), error_(false) { }
+
+    /// \returns true if every Node written was of a known kind.
+    bool is_valid() const
+    {
+        return !error_ && buf_.is_valid();
+    }
+
+    /// \brief Write Node tree at root (null for an empty tree).
+    void write(Node *root)
+    {
+        OutputBuffer::Scope scope(buf_);
+        if (root == nullptr) {
+            buf_ << "null";
+            return;
+        }
+        walk(root, *this);
+    }
+
+    void write(const Session &session)
+    {
+        OutputBuffer::Scope scope(buf_);
+        buf_ << "{\"name\":";
+        buf_.json_string(session.name());
+        buf_ << ",\"type\":" << (session.type() == ST_TYPE_LOCAL ? "\"local\"" : "\"global\"");
+        if (session.endpoint() != nullptr) {
+            buf_ << ",\"endpoint\":";
+            buf_.json_string(session.endpoint()->name());
+        }
+        buf_ << ",\"roles\":[";
+        std::vector<std::string> roles = role_names(session);
+        for (unsigned int i=0; i<roles.size(); i++) {
+            if (i > 0) buf_ << ',';
+            buf_.json_string(roles[i]);
+        }
+        buf_ << "],\"root\":";
+        write(session.root());
+        buf_ << '}';
+    }
+
+    void write(const Module &module)
+    {
+        OutputBuffer::Scope scope(buf_);
+        buf_ << "{\"name\":";
+        buf_.json_string(module.name());
+        buf_ << ",\"imports\":[";
+        bool first = true;
+        for (auto it=module.import_begin(); it!=module.import_end(); it++) {
+            if (it->second.second /*alias*/) continue;
+            if (!first) buf_ << ',';
+            first = false;
+            buf_ << "{\"name\":";
+            buf_.json_string(it->second.first->name());
+            buf_ << ",\"from\":";
+            buf_.json_string(it->second.first->from());
+            buf_ << ",\"as\":";
+            buf_.json_string(it->second.first->as());
+            buf_ << '}';
+        }
+        buf_ << "],\"sessions\":[";
+        std::vector<std::string> names = session_names(module);
+        for (unsigned int i=0; i<names.size(); i++) {
+            if (i > 0) buf_ << ',';
+            write(*module.session(names[i]));
+        }
+        buf_ << "]}";
+    }
+
+    /// \brief Walker interface for util::walk.
+    bool enter(Node *node)
+    {
+        if (!first_.empty()) {
+            if (!first_.back()) buf_ << ',';
+            first_.back() = false;
+        }
+        switch (node->type()) {
+            case ST_NODE_ROOT:
+                buf_ << "{\"node\":\"block\"";
+                break;
+            case ST_NODE_SENDRECV:
+                interaction(static_cast<InteractionNode *>(node));
+                return false;
+            case ST_NODE_RECUR:
+                buf_ << "{\"node\":\"recur\",\"label\":";
+                buf_.json_string(static_cast<RecurNode *>(node)->label());
+                break;
+            case ST_NODE_CONTINUE:
+                buf_ << "{\"node\":\"continue\",\"label\":";
+                buf_.json_string(static_cast<ContinueNode *>(node)->label());
+                buf_ << '}';
+                return false;
+            case ST_NODE_CHOICE:
+                buf_ << "{\"node\":\"choice\",\"at\":";
+                role(static_cast<ChoiceNode *>(node)->at());
+                break;
+            case ST_NODE_PARALLEL:
+                buf_ << "{\"node\":\"par\"";
+                break;
+            case ST_NODE_NESTED:
+                nested(static_cast<NestedNode *>(node));
+                return false;
+            case ST_NODE_INTERRUPTIBLE:
+                interruptible(static_cast<InterruptibleNode *>(node));
+                break;
+            default:
+                error_ = true;
+                buf_ << "{\"node\":\"unknown\",\"type\":" << node->type() << '}';
+                return false;
+        }
+        buf_ << ",\"children\":[";
+        first_.push_back(true);
+        return true;
+    }
+
+    /// \brief Walker interface for util::walk.
+    void leave(Node *node)
+    {
+        if (is_block_kind(node->type())) {
+            first_.pop_back();
+            buf_ << "]}";
+        }
+    }
+
+  private:
+    void role(Role *role)
+    {
+        if (role == nullptr) {
+            buf_ << "null";
+        } else {
+            buf_.json_string(role->name());
+        }
+    }
+
+    void msg(MsgSig *msg)
+    {
+        if (msg == nullptr) {
+            buf_ << "null";
+            return;
+        }
+        buf_ << "{\"label\":";
+        buf_.json_string(msg->label());
+        buf_ << ",\"payloads\":[";
+        for (auto it=msg->payload_begin(); it!=msg->payload_end(); it++) {
+            if (it != msg->payload_begin()) buf_ << ',';
+            buf_ << "{\"type\":";
+            buf_.json_string((*it)->type());
+            buf_ << ",\"name\":";
+            buf_.json_string((*it)->name());
+            buf_ << '}';
+        }
+        buf_ << "]}";
+    }
+
+    void interaction(InteractionNode *node)
+    {
+        buf_ << "{\"node\":\"interaction\",\"from\":";
+        role(node->sndr());
+        buf_ << ",\"to\":[";
+        for (auto it=node->rcvr_begin(); it!=node->rcvr_end(); it++) {
+            if (it != node->rcvr_begin()) buf_ << ',';
+            role(*it);
+        }
+        buf_ << "],\"msg\":";
+        msg(node->msg());
+        buf_ << '}';
+    }
+
+    void nested(NestedNode *node)
+    {
+        buf_ << "{\"node\":\"nested\",\"name\":";
+        buf_.json_string(node->name());
+        buf_ << ",\"scope\":";
+        buf_.json_string(node->scope());
+        buf_ << ",\"args\":[";
+        for (auto it=node->arg_begin(); it!=node->arg_end(); it++) {
+            if (it != node->arg_begin()) buf_ << ',';
+            msg(*it);
+        }
+        buf_ << "],\"roles\":[";
+        for (auto it=node->rolearg_begin(); it!=node->rolearg_end(); it++) {
+            if (it != node->rolearg_begin()) buf_ << ',';
+            role(*it);
+        }
+        buf_ << "]}";
+    }
+
+    void handlers(const char *name,
+                  InterruptibleNode::InterruptType::const_iterator begin,
+                  InterruptibleNode::InterruptType::const_iterator end)
+    {
+        buf_ << ",\"" << name << "\":[";
+        for (auto it=begin; it!=end; it++) {
+            if (it != begin) buf_ << ',';
+            buf_ << "{\"role\":";
+            role(it->first);
+            buf_ << ",\"msg\":";
+            msg(it->second);
+            buf_ << '}';
+        }
+        buf_ << ']';
+    }
+
+    void interruptible(InterruptibleNode *node)
+    {
+        buf_ << "{\"node\":\"interruptible\",\"scope\":";
+        buf_.json_string(node->scope());
+        handlers("interrupts", node->interrupt_begin(), node->interrupt_end());
+        handlers("throws", node->throw_begin(), node->throw_end());
+        handlers("catches", node->catch_begin(), node->catch_end());
+    }
+
+  public:
+    /// \returns true if Nodes of type have children to export.
+    static bool is_block_kind(unsigned int type)
+    {
+        return type == ST_NODE_ROOT || type == ST_NODE_RECUR || type == ST_NODE_CHOICE
+            || type == ST_NODE_PARALLEL || type == ST_NODE_INTERRUPTIBLE;
+    }
+
+    /// \returns names of Roles in session, sorted.
+    static std::vector<std::string> role_names(const Session &session)
+    {
+        std::vector<std::string> names;
+        for (auto it=session.role_begin(); it!=session.role_end(); it++) {
+            names.push_back(it->first);
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    /// \returns names of Sessions in module, sorted.
+    static std::vector<std::string> session_names(const Module &module)
+    {
+        std::vector<std::string> names;
+        for (auto it=module.session_begin(); it!=module.session_end(); it++) {
+            names.push_back(it->first);
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+};
+
+/**
+ * \brief Streaming exporter of the canonical text format.
+ *
+ * The text format is a compact Scribble-like rendering with one statement
+ * per line, which util::TextReader reads back into an identical tree:
+ *
+ *     module Name;
+ *     import Name from Module as Alias;
+ *     global protocol Name(role A, role B) {
+ *       L(int x, string) from A to B, C;
+ *       rec T {
+ *         choice at A {
+ *           { ... }
+ *           { ... }
+ *         }
+ *         continue T;
+ *       }
+ *       par { { ... } { ... } }
+ *       do Name@scope<L(int)>(A, B);
+ *       interruptible scope { ... } with { interrupt A: L(); throw B: M(); catch C: N(); }
+ *     }
+ *
+ * The body of a protocol is a single statement, normally a block. Every
+ * child of choice and par is a statement, so branches are written as
+ * blocks. Names which are not plain identifiers or are keywords are
+ * written as double-quoted strings. Roles and Sessions are written sorted
+ * by name so that the output is deterministic.
+ */
+class TextExport {
+    OutputBuffer &buf_;
+    std::string indent_;
+    unsigned int depth_;
+    bool inline_; // Next statement continues the current line?
+    bool error_;
+
+  public:
+    /// \brief TextExport constructor.
+    /// \param[in] buf to write to.
+    /// \param[in] indent width in spaces of each nesting level.
+    explicit TextExport(OutputBuffer &buf, unsigned int indent=2)
+        : buf_(buf), indent_(indent, ' '), depth_(0), inline_(false),
+          error_(false) { }
+
+    /// \returns true if every Node written was of a known kind.
+    bool is_valid() const
+    {
+        return !error_ && buf_.is_valid();
+    }
+
+    /// \brief Write Node tree at root as a statement.
+    void write(Node *root)
+    {
+        OutputBuffer::Scope scope(buf_);
+        if (root != nullptr) {
+            walk(root, *this);
+        }
+    }
+
+    void write(const Session &session)
+    {
+        OutputBuffer::Scope scope(buf_);
+        prefix();
+        buf_ << (session.type() == ST_TYPE_LOCAL ? "local" : "global") << " protocol ";
+        name(session.name());
+        if (session.endpoint() != nullptr) {
+            buf_ << " at ";
+            name(session.endpoint()->name());
+        }
+        buf_ << '(';
+        std::vector<std::string> roles = JsonExport::role_names(session);
+        for (unsigned int i=0; i<roles.size(); i++) {
+            if (i > 0) buf_ << ", ";
+            buf_ << "role ";
+            name(roles[i]);
+        }
+        buf_ << ')';
+        if (session.root() == nullptr) {
+            buf_ << ";\n";
+            return;
+        }
+        buf_ << ' ';
+        inline_ = true;
+        write(session.root());
+    }
+
+    void write(const Module &module)
+    {
+        OutputBuffer::Scope scope(buf_);
+        buf_ << "module ";
+        name(module.name());
+        buf_ << ";\n";
+        std::vector<Import *> imports;
+        for (auto it=module.import_begin(); it!=module.import_end(); it++) {
+            if (!it->second.second /*alias*/) imports.push_back(it->second.first);
+        }
+        std::sort(imports.begin(), imports.end(), [](Import *a, Import *b) {
+            return a->name() < b->name();
+        });
+        for (Import *import : imports) {
+            buf_ << "import ";
+            name(import->name());
+            if (import->from() != "") {
+                buf_ << " from ";
+                name(import->from());
+            }
+            if (import->as() != "") {
+                buf_ << " as ";
+                name(import->as());
+            }
+            buf_ << ";\n";
+        }
+        for (auto &session_name : JsonExport::session_names(module)) {
+            write(*module.session(session_name));
+        }
+    }
+
+    /// \brief Walker interface for util::walk.
+    bool enter(Node *node)
+    {
+        prefix();
+        switch (node->type()) {
+            case ST_NODE_ROOT:
+                buf_ << "{\n";
+                break;
+            case ST_NODE_SENDRECV:
+                interaction(static_cast<InteractionNode *>(node));
+                return false;
+            case ST_NODE_RECUR:
+                buf_ << "rec ";
+                name(static_cast<RecurNode *>(node)->label());
+                buf_ << " {\n";
+                break;
+            case ST_NODE_CONTINUE:
+                buf_ << "continue ";
+                name(static_cast<ContinueNode *>(node)->label());
+                buf_ << ";\n";
+                return false;
+            case ST_NODE_CHOICE:
+                buf_ << "choice ";
+                if (static_cast<ChoiceNode *>(node)->at() != nullptr) {
+                    buf_ << "at ";
+                    name(static_cast<ChoiceNode *>(node)->at()->name());
+                    buf_ << ' ';
+                }
+                buf_ << "{\n";
+                break;
+            case ST_NODE_PARALLEL:
+                buf_ << "par {\n";
+                break;
+            case ST_NODE_NESTED:
+                nested(static_cast<NestedNode *>(node));
+                return false;
+            case ST_NODE_INTERRUPTIBLE:
+                buf_ << "interruptible ";
+                if (static_cast<InterruptibleNode *>(node)->scope() != "") {
+                    name(static_cast<InterruptibleNode *>(node)->scope());
+                    buf_ << ' ';
+                }
+                buf_ << "{\n";
+                break;
+            default:
+                error_ = true;
+                buf_ << "{\n}\n";
+                return false;
+        }
+        depth_++;
+        return true;
+    }
+
+    /// \brief Walker interface for util::walk.
+    void leave(Node *node)
+    {
+        if (!JsonExport::is_block_kind(node->type())) {
+            return;
+        }
+        depth_--;
+        prefix();
+        buf_ << '}';
+        if (node->type() == ST_NODE_INTERRUPTIBLE) {
+            auto *interruptible = static_cast<InterruptibleNode *>(node);
+            if (interruptible->num_interrupts() + interruptible->num_throws()
+                    + interruptible->num_catches() > 0) {
+                buf_ << " with {";
+                handlers("interrupt", interruptible->interrupt_begin(), interruptible->interrupt_end());
+                handlers("throw", interruptible->throw_begin(), interruptible->throw_end());
+                handlers("catch", interruptible->catch_begin(), interruptible->catch_end());
+                buf_ << " }";
+            }
+        }
+        buf_ << '\n';
+    }
+
+    /// \returns true if s is written as is, false if it must be quoted.
+    static bool is_plain_name(const std::string &s)
+    {
+        static const char *const keywords[] = {
+            "module", "import", "from", "as", "global", "local", "protocol",
+            "at", "role", "to", "rec", "continue", "choice", "par", "do",
+            "interruptible", "with", "interrupt", "throw", "catch",
+        };
+        if (s.empty() || !(std::isalpha(static_cast<unsigned char>(s[0])) || s[0] == '_')) {
+            return false;
+        }
+        for (char c : s) {
+            if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.')) {
+                return false;
+            }
+        }
+        for (const char *keyword : keywords) {
+            if (s == keyword) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    void prefix()
+    {
+        if (inline_) {
+            inline_ = false;
+            return;
+        }
+        buf_.repeat(indent_, depth_);
+    }
+
+    void name(const std::string &s)
+    {
+        if (is_plain_name(s)) {
+            buf_ << s;
+        } else {
+            buf_.json_string(s);
+        }
+    }
+
+    void msg(MsgSig *msg)
+    {
+        if (msg == nullptr) {
+            buf_ << "\"\"()";
+            return;
+        }
+        name(msg->label());
+        buf_ << '(';
+        for (auto it=msg->payload_begin(); it!=msg->payload_end(); it++) {
+            if (it != msg->payload_begin()) buf_ << ", ";
+            name((*it)->type());
+            if ((*it)->name() != "") {
+                buf_ << ' ';
+                name((*it)->name());
+            }
+        }
+        buf_ << ')';
+    }
+
+    void interaction(InteractionNode *node)
+    {
+        msg(node->msg());
+        if (node->sndr() != nullptr) {
+            buf_ << " from ";
+            name(node->sndr()->name());
+        }
+        for (auto it=node->rcvr_begin(); it!=node->rcvr_end(); it++) {
+            buf_ << (it == node->rcvr_begin() ? " to " : ", ");
+            name((*it)->name());
+        }
+        buf_ << ";\n";
+    }
+
+    void nested(NestedNode *node)
+    {
+        buf_ << "do ";
+        name(node->name());
+        if (node->scope() != "") {
+            buf_ << '@';
+            name(node->scope());
+        }
+        if (node->num_args() > 0) {
+            buf_ << '<';
+            for (auto it=node->arg_begin(); it!=node->arg_end(); it++) {
+                if (it != node->arg_begin()) buf_ << ", ";
+                msg(*it);
+            }
+            buf_ << '>';
+        }
+        buf_ << '(';
+        for (auto it=node->rolearg_begin(); it!=node->rolearg_end(); it++) {
+            if (it != node->rolearg_begin()) buf_ << ", ";
+            name((*it)->name());
+        }
+        buf_ << ");\n";
+    }
+
+    void handlers(const char *kind,
+                  InterruptibleNode::InterruptType::const_iterator begin,
+                  InterruptibleNode::InterruptType::const_iterator end)
+    {
+        for (auto it=begin; it!=end; it++) {
+            buf_ << ' ' << kind << ' ';
+            name(it->first->name());
+            buf_ << ": ";
+            msg(it->second);
+            buf_ << ';';
+        }
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// \brief Write tree as JSON.
+/// \param[in] tree to export.
+/// \param[in] out stdio stream to write to.
+/// \returns 0 on success, -1 on write error or unknown node kinds.
+int st_tree_export_json(st_tree *const tree, FILE *out);
+
+/// \brief Write tree in the canonical text format.
+/// \param[in] tree to export.
+/// \param[in] out stdio stream to write to.
+/// \returns 0 on success, -1 on write error or unknown node kinds.
+int st_tree_export_text(st_tree *const tree, FILE *out);
+
+/// \brief Write module (imports and all trees) as JSON.
+int st_module_export_json(st_module *const module, FILE *out);
+
+/// \brief Write module (imports and all trees) in the canonical text format.
+int st_module_export_text(st_module *const module, FILE *out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__EXPORT_H__
@@ -0,0 +1,335 @@
+#ifndef SESSTYPE__UTIL__GRAPH_EXPORT_H__
+#define SESSTYPE__UTIL__GRAPH_EXPORT_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#endif
+
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/session.h"
+#include "sesstype/util/cfsm.h"
+#include "sesstype/util/output_buffer.h"
+#include "sesstype/util/traversal.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Communication graph of a global Session.
+ *
+ * Nodes are Roles and there is an edge from sender to receiver for every
+ * pair of Roles which communicate, labelled with the message labels sent
+ * along it and how many times each occurs in the Session body. These are
+ * static occurrences of interactions in the tree, not numbers of messages
+ * at run time: a message in a RecurNode or ForNode body occurs once however
+ * many times the loop repeats (see parameterised::util::MsgCount for loop
+ * aware message counts). Edges are accumulated in hash maps while the tree
+ * is walked once; sorting is only done when the graph is written.
+ */
+class CommGraph {
+  public:
+    /// \brief Edge from sender to receiver with label occurrences.
+    struct Edge {
+        std::string from;
+        std::string to;
+        std::map<std::string, unsigned long> labels; ///< Occurrences per label.
+        unsigned long occurrences; ///< Total occurrences of interactions.
+    };
+
+  private:
+    std::vector<std::string> roles_;
+    std::unordered_map<std::string, unsigned int> role_ids_;
+    std::vector<Edge> edges_;
+    std::unordered_map<std::string, unsigned int> edge_ids_;
+    unsigned int max_labels_;
+
+  public:
+    CommGraph() : roles_(), role_ids_(), edges_(), edge_ids_(), max_labels_(8) { }
+
+    /// \param[in] max_labels number of labels written per edge before the
+    ///            rest are summarised (0 for no limit).
+    void set_max_labels(unsigned int max_labels)
+    {
+        max_labels_ = max_labels;
+    }
+
+    /// \brief Add a Role (node) to the graph.
+    void add_role(const std::string &role)
+    {
+        if (role_ids_.insert({ role, roles_.size() }).second) {
+            roles_.push_back(role);
+        }
+    }
+
+    /// \brief Add one occurrence of a message from sender to receiver.
+    void add(const std::string &from, const std::string &to, const std::string &label)
+    {
+        add_role(from);
+        add_role(to);
+        std::string key = from + '\0' + to;
+        auto it = edge_ids_.find(key);
+        if (it == edge_ids_.end()) {
+            it = edge_ids_.insert({ key, edges_.size() }).first;
+            edges_.push_back(Edge { from, to, { }, 0 });
+        }
+        Edge &edge = edges_[it->second];
+        edge.labels[label]++;
+        edge.occurrences++;
+    }
+
+    /// \brief Add all interactions in tree at root.
+    /// \param[in] root of tree.
+    /// \param[in] role_key maps a Role to the name of its graph node.
+    template <class BaseNode, class BlockType, class InteractionType, class RoleKey>
+    void add_tree(BaseNode *root, RoleKey role_key)
+    {
+        Builder<BaseNode, InteractionType, RoleKey> builder { *this, role_key };
+        walk_tmpl<BaseNode, BlockType>(root, builder);
+    }
+
+    unsigned int num_roles() const
+    {
+        return roles_.size();
+    }
+
+    unsigned int num_edges() const
+    {
+        return edges_.size();
+    }
+
+    /// \returns Edges sorted by sender and receiver.
+    std::vector<const Edge *> edges() const
+    {
+        std::vector<const Edge *> sorted;
+        for (auto &edge : edges_) {
+            sorted.push_back(&edge);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Edge *a, const Edge *b) {
+            return a->from < b->from || (a->from == b->from && a->to < b->to);
+        });
+        return sorted;
+    }
+
+    /// \returns Edge from sender to receiver, or nullptr.
+    const Edge *edge(const std::string &from, const std::string &to) const
+    {
+        auto it = edge_ids_.find(from + '\0' + to);
+        return it == edge_ids_.end() ? nullptr : &edges_[it->second];
+    }
+
+    /// \brief Write graph in Graphviz DOT format.
+    void write_dot(OutputBuffer &buf, const std::string &name) const
+    {
+        OutputBuffer::Scope scope(buf);
+        buf << "digraph ";
+        buf.json_string(name);
+        buf << " {\n";
+        std::vector<std::string> roles(roles_);
+        std::sort(roles.begin(), roles.end());
+        for (auto &role : roles) {
+            buf << "  ";
+            buf.json_string(role);
+            buf << ";\n";
+        }
+        for (const Edge *edge : edges()) {
+            buf << "  ";
+            buf.json_string(edge->from);
+            buf << " -> ";
+            buf.json_string(edge->to);
+            buf << " [label=";
+            buf.json_string(edge_label(*edge, "\n"));
+            buf << ", weight=" << edge->occurrences << "];\n";
+        }
+        buf << "}\n";
+    }
+
+    /// \brief Write graph in GraphML format.
+    void write_graphml(OutputBuffer &buf, const std::string &name) const
+    {
+        OutputBuffer::Scope scope(buf);
+        graphml_begin(buf, name,
+                "  <key id=\"occurrences\" for=\"edge\" attr.name=\"occurrences\""
+                " attr.type=\"long\"/>\n");
+        std::vector<std::string> roles(roles_);
+        std::sort(roles.begin(), roles.end());
+        for (auto &role : roles) {
+            buf << "    <node id=\"";
+            xml_string(buf, role);
+            buf << "\"/>\n";
+        }
+        for (const Edge *edge : edges()) {
+            buf << "    <edge source=\"";
+            xml_string(buf, edge->from);
+            buf << "\" target=\"";
+            xml_string(buf, edge->to);
+            buf << "\"><data key=\"label\">";
+            xml_string(buf, edge_label(*edge, ", "));
+            buf << "</data><data key=\"occurrences\">" << edge->occurrences << "</data></edge>\n";
+        }
+        graphml_end(buf);
+    }
+
+    /// \brief Append s with XML special characters escaped.
+    static void xml_string(OutputBuffer &buf, const std::string &s)
+    {
+        for (char c : s) {
+            switch (c) {
+                case '&': buf << "&amp;"; break;
+                case '<': buf << "&lt;"; break;
+                case '>': buf << "&gt;"; break;
+                case '"': buf << "&quot;"; break;
+                default: buf << c;
+            }
+        }
+    }
+
+    /// \brief Write GraphML header up to and including the graph element.
+    /// \param[in] keys additional key elements, which GraphML requires
+    ///            before the graph element.
+    static void graphml_begin(OutputBuffer &buf, const std::string &name,
+                              const std::string &keys = std::string())
+    {
+        buf << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+            << "  <key id=\"label\" for=\"edge\" attr.name=\"label\" attr.type=\"string\"/>\n"
+            << keys
+            << "  <graph id=\"";
+        xml_string(buf, name);
+        buf << "\" edgedefault=\"directed\">\n";
+    }
+
+    static void graphml_end(OutputBuffer &buf)
+    {
+        buf << "  </graph>\n</graphml>\n";
+    }
+
+  private:
+    template <class BaseNode, class InteractionType, class RoleKey>
+    struct Builder {
+        CommGraph &graph;
+        RoleKey role_key;
+
+        bool enter(BaseNode *node)
+        {
+            if (node->type() == ST_NODE_SENDRECV) {
+                auto *interaction = dynamic_cast<InteractionType *>(node);
+                if (interaction != nullptr && interaction->sndr() != nullptr
+                        && interaction->msg() != nullptr) {
+                    std::string from = role_key(interaction->sndr());
+                    for (auto it=interaction->rcvr_begin(); it!=interaction->rcvr_end(); it++) {
+                        graph.add(from, role_key(*it), interaction->msg()->label());
+                    }
+                }
+                return false;
+            }
+            return true;
+        }
+
+        void leave(BaseNode *node) { }
+    };
+
+    /// \returns label of edge, listing at most max_labels_ labels.
+    std::string edge_label(const Edge &edge, const char *separator) const
+    {
+        std::string label;
+        unsigned int n = 0;
+        for (auto &label_count : edge.labels) {
+            if (max_labels_ > 0 && n == max_labels_) {
+                label += separator;
+                label += "(+" + std::to_string(edge.labels.size() - n) + " more)";
+                break;
+            }
+            if (n++ > 0) {
+                label += separator;
+            }
+            label += label_count.first;
+            if (label_count.second > 1) {
+                label += " x" + std::to_string(label_count.second);
+            }
+        }
+        return label;
+    }
+};
+
+/// \returns communication graph of session (see CommGraph).
+inline CommGraph comm_graph(const Session &session)
+{
+    CommGraph graph;
+    for (auto it=session.role_begin(); it!=session.role_end(); it++) {
+        graph.add_role(it->first);
+    }
+    graph.add_tree<Node, BlockNode, InteractionNode>(session.root(),
+            [](Role *role) { return role->name(); });
+    return graph;
+}
+
+/**
+ * \brief Write a local automaton in Graphviz DOT format.
+ *
+ * States are s0, s1, ...; final states are drawn as double circles and
+ * transitions are labelled peer!label (send) or peer?label (receive).
+ */
+inline void write_dot(const CFSM &fsm, OutputBuffer &buf, const std::string &name)
+{
+    OutputBuffer::Scope scope(buf);
+    buf << "digraph ";
+    buf.json_string(name);
+    buf << " {\n  rankdir=LR;\n  node [shape=circle];\n  start [shape=point];\n";
+    for (unsigned int s=0; s<fsm.num_states(); s++) {
+        if (fsm.is_final(s)) {
+            buf << "  s" << s << " [shape=doublecircle];\n";
+        }
+    }
+    buf << "  start -> s" << fsm.initial() << ";\n";
+    for (unsigned int s=0; s<fsm.num_states(); s++) {
+        for (auto it=fsm.transition_begin(s); it!=fsm.transition_end(s); it++) {
+            const CFSM::Action &action = fsm.action(it->action);
+            buf << "  s" << s << " -> s" << it->target << " [label=";
+            buf.json_string(fsm.peer(action.peer) + (action.dir == ST_CFSM_SEND ? "!" : "?")
+                    + fsm.label(action.label));
+            buf << "];\n";
+        }
+    }
+    buf << "}\n";
+}
+
+/// \brief Write a local automaton in GraphML format (see write_dot).
+inline void write_graphml(const CFSM &fsm, OutputBuffer &buf, const std::string &name)
+{
+    OutputBuffer::Scope scope(buf);
+    CommGraph::graphml_begin(buf, name,
+            "  <key id=\"final\" for=\"node\" attr.name=\"final\" attr.type=\"boolean\"/>\n");
+    for (unsigned int s=0; s<fsm.num_states(); s++) {
+        buf << "    <node id=\"s" << s << "\"><data key=\"final\">"
+            << (fsm.is_final(s) ? "true" : "false") << "</data></node>\n";
+    }
+    for (unsigned int s=0; s<fsm.num_states(); s++) {
+        for (auto it=fsm.transition_begin(s); it!=fsm.transition_end(s); it++) {
+            const CFSM::Action &action = fsm.action(it->action);
+            buf << "    <edge source=\"s" << s << "\" target=\"s" << it->target
+                << "\"><data key=\"label\">";
+            CommGraph::xml_string(buf, fsm.peer(action.peer)
+                    + (action.dir == ST_CFSM_SEND ? "!" : "?") + fsm.label(action.label));
+            buf << "</data></edge>\n";
+        }
+    }
+    CommGraph::graphml_end(buf);
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__GRAPH_EXPORT_H__
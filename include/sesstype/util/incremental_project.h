@@ -0,0 +1,244 @@
+#ifndef SESSTYPE__UTIL__INCREMENTAL_PROJECT_H__
+#define SESSTYPE__UTIL__INCREMENTAL_PROJECT_H__
+
+#ifdef __cplusplus
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#endif
+
+#include "sesstype/role.h"
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/node/par.h"
+#include "sesstype/util/project.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Endpoint projection which is kept up to date with its global tree.
+ *
+ * The projection of every global Node is cached together with the
+ * Node::revision() it was computed from. On update(), a global subtree whose
+ * Nodes all kept their revision reuses its projected subtree as-is (the local
+ * Nodes are moved into the new local tree), and only the changed Nodes and
+ * the block shells on the path to them are projected again.
+ *
+ * As in ProjectionVisitor, a nested block is kept as a block only when it is
+ * a branch of a choice or par; otherwise its projected children are inlined
+ * into the enclosing block.
+ *
+ * The local tree is owned by IncrementalProjection and stays valid until the
+ * next update() or until IncrementalProjection is destroyed.
+ */
+class IncrementalProjection {
+    struct Entry {
+        unsigned long revision;
+        bool keep_block;            // Projected as a block, not inlined.
+        std::vector<Node *> locals; // Projection (zero or more Nodes).
+    };
+
+    Node *global_;
+    Role *endpoint_;
+    Node *local_;
+    std::unordered_map<Node *, Entry> cache_;
+    std::unordered_map<Node *, Entry> next_cache_;
+    std::unordered_set<Node *> moved_;
+    unsigned int num_projected_;
+
+  public:
+    /// \brief IncrementalProjection constructor.
+    /// \param[in] global root Node of the global tree (not owned).
+    /// \param[in] endpoint Role to project for (not owned).
+    IncrementalProjection(Node *global, Role *endpoint)
+        : global_(global), endpoint_(endpoint), local_(nullptr),
+          cache_(), next_cache_(), moved_(), num_projected_(0)
+    {
+        update();
+    }
+
+    /// \brief IncrementalProjection destructor, frees the local tree.
+    ~IncrementalProjection()
+    {
+        delete local_;
+    }
+
+    IncrementalProjection(const IncrementalProjection &) = delete;
+    IncrementalProjection &operator=(const IncrementalProjection &) = delete;
+
+    /// \returns root of the projected (local) tree.
+    Node *get_root() const
+    {
+        return local_;
+    }
+
+    /// \returns number of global Nodes projected afresh by the last update().
+    unsigned int num_projected() const
+    {
+        return num_projected_;
+    }
+
+    /// \brief Bring the local tree up to date with the global tree.
+    /// \returns root of the projected (local) tree.
+    Node *update()
+    {
+        num_projected_ = 0;
+        bool reused = false;
+        std::vector<Node *> locals;
+        project(global_, true, reused, locals);
+        Node *local;
+        if (global_->type() == ST_NODE_ROOT && locals.size() == 1) {
+            local = locals[0];
+        } else {
+            // Like ProjectionVisitor, wrap a projection which is not a block.
+            auto *root = new BlockNode();
+            for (auto child : locals) {
+                root->append_child(child);
+            }
+            local = root;
+        }
+
+        if (local_ != nullptr && local_ != local) {
+            release(local_);
+            delete local_;
+        }
+        local_ = local;
+
+        cache_.swap(next_cache_);
+        next_cache_.clear();
+        moved_.clear();
+        return local_;
+    }
+
+  private:
+    /// Project a global Node, reusing the cached local Nodes if possible.
+    /// \param[in] keep_block false if a plain block is inlined in its parent.
+    /// \param[out] out projection of node is appended.
+    void project(Node *node, bool keep_block, bool &reused, std::vector<Node *> &out)
+    {
+        auto cached = cache_.find(node);
+        bool same_rev = (cached != cache_.end() &&
+                         cached->second.revision == node->revision() &&
+                         cached->second.keep_block == keep_block);
+
+        auto *blk = dynamic_cast<BlockNode *>(node);
+        if (blk == nullptr || node->type() == ST_NODE_INTERRUPTIBLE) {
+            if (same_rev) {
+                reuse(node, cached->second, reused, out);
+                return;
+            }
+            project_leaf(node, keep_block, reused, out);
+            return;
+        }
+
+        bool branching = (node->type() == ST_NODE_CHOICE || node->type() == ST_NODE_PARALLEL);
+        bool children_reused = true;
+        std::vector<Node *> locals;
+        locals.reserve(blk->num_children());
+        for (auto it=blk->child_begin(); it!=blk->child_end(); it++) {
+            bool child_reused = false;
+            project(*it, branching, child_reused, locals);
+            children_reused &= child_reused;
+        }
+
+        if (same_rev && children_reused) {
+            reuse(node, cached->second, reused, out);
+            return;
+        }
+
+        num_projected_++;
+        reused = false;
+        Entry entry { node->revision(), keep_block, { } };
+        if (node->type() == ST_NODE_ROOT && !keep_block) {
+            entry.locals = locals;
+        } else {
+            // Shell of the block, children are moved in from the projections.
+            auto *shell = dynamic_cast<BlockNode *>(project_shell(node));
+            for (auto local : locals) {
+                shell->append_child(local);
+            }
+            entry.locals.push_back(shell);
+        }
+        out.insert(out.end(), entry.locals.begin(), entry.locals.end());
+        next_cache_[node] = entry;
+    }
+
+    void reuse(Node *node, const Entry &entry, bool &reused, std::vector<Node *> &out)
+    {
+        next_cache_[node] = entry;
+        moved_.insert(entry.locals.begin(), entry.locals.end());
+        out.insert(out.end(), entry.locals.begin(), entry.locals.end());
+        reused = true;
+    }
+
+    void project_leaf(Node *node, bool keep_block, bool &reused, std::vector<Node *> &out)
+    {
+        num_projected_++;
+        ProjectionVisitor projector(endpoint_);
+        node->accept(projector);
+
+        auto *root = dynamic_cast<BlockNode *>(projector.get_root());
+        Entry entry { node->revision(), keep_block, { } };
+        while (root->num_children() > 0) {
+            entry.locals.push_back(root->detach_child(0));
+        }
+        delete root;
+
+        out.insert(out.end(), entry.locals.begin(), entry.locals.end());
+        next_cache_[node] = entry;
+        reused = false;
+    }
+
+    /// Projection of a block Node without its children.
+    Node *project_shell(Node *node)
+    {
+        switch (node->type()) {
+        case ST_NODE_CHOICE:
+            if (Role *at = dynamic_cast<ChoiceNode *>(node)->at()) {
+                return new ChoiceNode(at->clone());
+            }
+            return new ChoiceNode();
+        case ST_NODE_RECUR:
+            return new RecurNode(dynamic_cast<RecurNode *>(node)->label());
+        case ST_NODE_PARALLEL:
+            return new ParNode();
+        default:
+            return new BlockNode();
+        }
+    }
+
+    /// Detach local Nodes moved into the new local tree from the old one.
+    void release(Node *old_local)
+    {
+        std::vector<BlockNode *> stack;
+        if (auto *blk = dynamic_cast<BlockNode *>(old_local)) {
+            stack.push_back(blk);
+        }
+        while (!stack.empty()) {
+            BlockNode *blk = stack.back();
+            stack.pop_back();
+            for (unsigned int i=0; i<blk->num_children(); i++) {
+                Node *child = blk->child(i);
+                if (moved_.find(child) != moved_.end()) {
+                    blk->set_child(i, nullptr);
+                } else if (auto *child_blk = dynamic_cast<BlockNode *>(child)) {
+                    stack.push_back(child_blk);
+                }
+            }
+        }
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__INCREMENTAL_PROJECT_H__
@@ -0,0 +1,136 @@
+#ifndef SESSTYPE__UTIL__MONITOR_H__
+#define SESSTYPE__UTIL__MONITOR_H__
+
+#ifdef __cplusplus
+#include <atomic>
+#include <vector>
+#endif
+
+#include "sesstype/util/cfsm.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Runtime monitor of an endpoint against its CFSM.
+ *
+ * The CFSM is flattened into a dense (state x action) table, with an extra
+ * sticky reject state, so that each event is checked by a single table
+ * lookup without allocation. The current state is atomic and is updated
+ * lock-free, so one Monitor can be shared by the threads of an endpoint.
+ *
+ * Events are CFSM action ids, see CFSM::find_action.
+ */
+class Monitor {
+    std::vector<unsigned int> table_;
+    std::vector<unsigned char> final_;
+    unsigned int num_actions_;
+    unsigned int reject_;
+    std::atomic<unsigned int> state_;
+
+  public:
+    /// \brief Monitor constructor.
+    /// \param[in] fsm CFSM of the endpoint (not retained).
+    explicit Monitor(const CFSM &fsm)
+        : table_(), final_(), num_actions_(fsm.num_actions()),
+          reject_(fsm.num_states()), state_(fsm.initial())
+    {
+        table_.assign((reject_ + 1) * num_actions_, reject_);
+        final_.assign(reject_ + 1, 0);
+        for (unsigned int s=0; s<reject_; s++) {
+            for (auto it=fsm.transition_begin(s); it!=fsm.transition_end(s); it++) {
+                table_[s * num_actions_ + it->action] = it->target;
+            }
+            final_[s] = fsm.is_final(s) ? 1 : 0;
+        }
+    }
+
+    Monitor(const Monitor &) = delete;
+    Monitor &operator=(const Monitor &) = delete;
+
+    /// \returns current state, or reject_state() after a violation.
+    unsigned int state() const
+    {
+        return state_.load(std::memory_order_acquire);
+    }
+
+    /// \returns the sticky reject state.
+    unsigned int reject_state() const
+    {
+        return reject_;
+    }
+
+    /// \returns true if a violation has been observed.
+    bool is_rejected() const
+    {
+        return state() == reject_;
+    }
+
+    /// \returns true if the endpoint is in a final (terminated) state.
+    bool is_final() const
+    {
+        return final_[state()] != 0;
+    }
+
+    /// \brief Restart monitoring from the initial state.
+    void reset()
+    {
+        state_.store(0, std::memory_order_release);
+    }
+
+    /// \brief Check and perform one event.
+    /// \param[in] action CFSM action id of the event.
+    /// \returns true if the event is allowed, false on violation.
+    bool step(unsigned int action)
+    {
+        if (action >= num_actions_) {
+            state_.store(reject_, std::memory_order_release);
+            return false;
+        }
+        unsigned int cur = state_.load(std::memory_order_acquire);
+        unsigned int next;
+        do {
+            next = table_[cur * num_actions_ + action];
+        } while (!state_.compare_exchange_weak(cur, next,
+                    std::memory_order_acq_rel, std::memory_order_acquire));
+        return next != reject_;
+    }
+
+    /// \brief Check and perform a batch of buffered events in order.
+    ///
+    /// The batch is applied atomically: it is checked from the current
+    /// state and committed with a compare-and-swap, and checked again if a
+    /// concurrent step() or check() changed the state in between.
+    /// \param[in] actions CFSM action ids of the events.
+    /// \param[in] n number of events.
+    /// \returns index of the first violating event, or n if all are allowed.
+    ///          If the Monitor was already rejected, no event is checked and
+    ///          0 is returned.
+    unsigned int check(const unsigned int *actions, unsigned int n)
+    {
+        unsigned int start = state_.load(std::memory_order_acquire);
+        unsigned int cur, i;
+        do {
+            if (start == reject_) {
+                return 0;
+            }
+            cur = start;
+            for (i=0; i<n && cur!=reject_; i++) {
+                cur = (actions[i] < num_actions_ ? table_[cur * num_actions_ + actions[i]] : reject_);
+            }
+        } while (!state_.compare_exchange_weak(start, cur,
+                    std::memory_order_acq_rel, std::memory_order_acquire));
+        return (cur == reject_ ? i - 1 : n);
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__MONITOR_H__
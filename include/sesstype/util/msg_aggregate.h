@@ -0,0 +1,165 @@
+#ifndef SESSTYPE__UTIL__MSG_AGGREGATE_H__
+#define SESSTYPE__UTIL__MSG_AGGREGATE_H__
+
+#ifdef __cplusplus
+#include <string>
+#endif
+
+#include "sesstype/msg.h"
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/util/traversal.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Fuse runs of adjacent interactions between the same Roles.
+ *
+ * Two InteractionNodes are fused if they are adjacent children of the same
+ * sequential BlockNode (a block or a RecurNode body), have the same sender
+ * and the same receivers (in order), and no payload name would be repeated.
+ * The fused MsgSig has the labels joined by separator() and the payloads
+ * concatenated, e.g.
+ * <tt>A->B: X(int x); A->B: Y(int y);</tt> becomes
+ * <tt>A->B: X_Y(int x, int y);</tt>
+ *
+ * Every projection then has one action in place of the run (a send for the
+ * sender, a receive for each receiver, nothing for other Roles), and the
+ * fused label starts with the label of the first interaction, so branches
+ * of a choice remain distinguishable. Bodies of InterruptibleNodes are not
+ * changed, as an interrupt may occur between any two of their messages.
+ *
+ * Usage: <tt>util::walk(session->root(), aggregator);</tt>
+ */
+class MsgAggregator {
+    std::string separator_;
+    unsigned int max_payloads_;
+    unsigned int num_fused_;
+    unsigned int interruptible_; // Depth of enclosing InterruptibleNodes.
+
+  public:
+    MsgAggregator()
+        : separator_("_"), max_payloads_(0), num_fused_(0), interruptible_(0) { }
+
+    /// \param[in] separator between the labels of a fused MsgSig.
+    void set_separator(std::string separator)
+    {
+        separator_ = separator;
+    }
+
+    std::string separator() const
+    {
+        return separator_;
+    }
+
+    /// \param[in] max_payloads largest number of payloads of a fused MsgSig
+    ///            (0 for no limit).
+    void set_max_payloads(unsigned int max_payloads)
+    {
+        max_payloads_ = max_payloads;
+    }
+
+    /// \returns number of InteractionNodes removed by fusion.
+    unsigned int num_fused() const
+    {
+        return num_fused_;
+    }
+
+    /// \brief Walker interface for the iterative util::walk.
+    bool enter(Node *node)
+    {
+        if (node->type() == ST_NODE_INTERRUPTIBLE) {
+            interruptible_++;
+        }
+        return node->type() != ST_NODE_NESTED;
+    }
+
+    /// \brief Walker interface for the iterative util::walk.
+    ///
+    /// The children of a sequential BlockNode have been visited, so they
+    /// are fused here. Children of ChoiceNodes and ParNodes are branches,
+    /// not a sequence, and are never fused.
+    void leave(Node *node)
+    {
+        if (node->type() == ST_NODE_INTERRUPTIBLE) {
+            interruptible_--;
+            return;
+        }
+        if (interruptible_ > 0
+                || (node->type() != ST_NODE_ROOT && node->type() != ST_NODE_RECUR)) {
+            return;
+        }
+        auto *block = dynamic_cast<BlockNode *>(node);
+        if (block == nullptr) {
+            return;
+        }
+        for (unsigned int i=1; i<block->num_children(); ) {
+            auto *prev = dynamic_cast<InteractionNode *>(block->child(i - 1));
+            auto *cur = dynamic_cast<InteractionNode *>(block->child(i));
+            if (prev == nullptr || cur == nullptr || !fusible(prev, cur)) {
+                i++;
+                continue;
+            }
+            fuse(prev, cur);
+            delete block->detach_child(i);
+            num_fused_++;
+        }
+    }
+
+    /// \returns true if the messages of first and second can be one message.
+    bool fusible(const InteractionNode *first, const InteractionNode *second) const
+    {
+        if (first->sndr() == nullptr || second->sndr() == nullptr
+                || first->sndr()->name() != second->sndr()->name()
+                || first->num_rcvrs() != second->num_rcvrs()) {
+            return false;
+        }
+        for (unsigned int i=0; i<first->num_rcvrs(); i++) {
+            if (first->rcvr(i)->name() != second->rcvr(i)->name()) {
+                return false;
+            }
+        }
+        MsgSig *msg = first->msg(), *next = second->msg();
+        if (max_payloads_ > 0 && msg->num_payloads() + next->num_payloads() > max_payloads_) {
+            return false;
+        }
+        for (auto it=next->payload_begin(); it!=next->payload_end(); it++) {
+            if (!(*it)->name().empty() && msg->has_payload((*it)->name())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    /// Append the message of second to the message of first.
+    void fuse(InteractionNode *first, const InteractionNode *second) const
+    {
+        MsgSig *msg = first->msg(), *next = second->msg();
+        std::string label = msg->label();
+        if (!label.empty() && !next->label().empty()) {
+            label += separator_;
+        }
+        MsgSig fused(label + next->label());
+        for (auto it=msg->payload_begin(); it!=msg->payload_end(); it++) {
+            fused.add_payload(*it);
+        }
+        for (auto it=next->payload_begin(); it!=next->payload_end(); it++) {
+            fused.add_payload(*it);
+        }
+        first->set_msg(&fused);
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__MSG_AGGREGATE_H__
@@ -0,0 +1,254 @@
+#ifndef SESSTYPE__UTIL__OUTPUT_BUFFER_H__
+#define SESSTYPE__UTIL__OUTPUT_BUFFER_H__
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#endif
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Reusable output buffer for printers and exporters.
+ *
+ * Text is formatted directly into an in-memory buffer, which is written to
+ * the underlying std::ostream (or stdio FILE) in bulk whenever it grows past
+ * its capacity, when flush() is called, or when the outermost Scope ends.
+ * Integers and pointers are formatted without going through the stream.
+ */
+class OutputBuffer {
+    std::ostream *os_;
+    std::FILE *file_;
+    std::string buf_;
+    std::size_t capacity_;
+    unsigned int depth_;
+    bool error_;
+
+  public:
+    /// \brief Flush the buffer when the outermost Scope is left.
+    ///
+    /// Printers open a Scope in every visit method, so that output is
+    /// complete when a top-level visit returns, while nested visits only
+    /// append to the buffer.
+    class Scope {
+        OutputBuffer &buf_;
+
+      public:
+        explicit Scope(OutputBuffer &buf) : buf_(buf)
+        {
+            buf_.depth_++;
+        }
+
+        ~Scope()
+        {
+            if (--buf_.depth_ == 0) {
+                buf_.flush();
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    /// \brief OutputBuffer constructor.
+    /// \param[in] os output stream to write to.
+    /// \param[in] capacity in bytes before the buffer is written out.
+    explicit OutputBuffer(std::ostream &os, std::size_t capacity=1<<16)
+        : os_(&os), file_(nullptr), buf_(), capacity_(capacity), depth_(0),
+          error_(false)
+    {
+        buf_.reserve(capacity_ + 256);
+    }
+
+    /// \brief OutputBuffer constructor.
+    /// \param[in] file stdio stream to write to.
+    /// \param[in] capacity in bytes before the buffer is written out.
+    explicit OutputBuffer(std::FILE *file, std::size_t capacity=1<<16)
+        : os_(nullptr), file_(file), buf_(), capacity_(capacity), depth_(0),
+          error_(false)
+    {
+        buf_.reserve(capacity_ + 256);
+    }
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    /// \brief OutputBuffer destructor, flushes pending output.
+    ~OutputBuffer()
+    {
+        flush();
+    }
+
+    /// \brief Write pending output to the underlying stream.
+    void flush()
+    {
+        if (buf_.empty()) {
+            return;
+        }
+        if (file_ != nullptr) {
+            if (std::fwrite(buf_.data(), 1, buf_.size(), file_) != buf_.size()) {
+                error_ = true;
+            }
+        } else {
+            os_->write(buf_.data(), buf_.size());
+            if (!*os_) {
+                error_ = true;
+            }
+        }
+        buf_.clear();
+    }
+
+    /// \returns true if no write to the underlying stream has failed.
+    bool is_valid() const
+    {
+        return !error_;
+    }
+
+    /// \returns number of bytes pending in the buffer.
+    std::size_t size() const
+    {
+        return buf_.size();
+    }
+
+    OutputBuffer &write(const char *s, std::size_t n)
+    {
+        buf_.append(s, n);
+        if (buf_.size() >= capacity_) {
+            flush();
+        }
+        return *this;
+    }
+
+    /// \brief Append <tt>n</tt> copies of string <tt>s</tt>.
+    OutputBuffer &repeat(const std::string &s, unsigned int n)
+    {
+        for (unsigned int i=0; i<n; i++) {
+            buf_.append(s);
+        }
+        if (buf_.size() >= capacity_) {
+            flush();
+        }
+        return *this;
+    }
+
+    OutputBuffer &operator<<(const std::string &s)
+    {
+        return write(s.data(), s.size());
+    }
+
+    OutputBuffer &operator<<(const char *s)
+    {
+        return write(s, std::strlen(s));
+    }
+
+    OutputBuffer &operator<<(char c)
+    {
+        buf_.push_back(c);
+        if (buf_.size() >= capacity_) {
+            flush();
+        }
+        return *this;
+    }
+
+    OutputBuffer &operator<<(unsigned long long n)
+    {
+        char digits[24];
+        char *p = digits + sizeof(digits);
+        do {
+            *--p = '0' + (n % 10);
+            n /= 10;
+        } while (n != 0);
+        return write(p, digits + sizeof(digits) - p);
+    }
+
+    OutputBuffer &operator<<(long long n)
+    {
+        if (n < 0) {
+            *this << '-';
+            return *this << (0ULL - static_cast<unsigned long long>(n));
+        }
+        return *this << static_cast<unsigned long long>(n);
+    }
+
+    OutputBuffer &operator<<(unsigned long n)
+    {
+        return *this << static_cast<unsigned long long>(n);
+    }
+
+    OutputBuffer &operator<<(long n)
+    {
+        return *this << static_cast<long long>(n);
+    }
+
+    OutputBuffer &operator<<(unsigned int n)
+    {
+        return *this << static_cast<unsigned long long>(n);
+    }
+
+    OutputBuffer &operator<<(int n)
+    {
+        return *this << static_cast<long long>(n);
+    }
+
+    /// \brief Append pointer as hexadecimal (same as std::ostream).
+    OutputBuffer &operator<<(const void *ptr)
+    {
+        std::uintptr_t n = reinterpret_cast<std::uintptr_t>(ptr);
+        if (n == 0) {
+            return *this << '0';
+        }
+        char digits[2 + 2*sizeof(n)];
+        char *p = digits + sizeof(digits);
+        while (n != 0) {
+            *--p = "0123456789abcdef"[n & 0xf];
+            n >>= 4;
+        }
+        *--p = 'x';
+        *--p = '0';
+        return write(p, digits + sizeof(digits) - p);
+    }
+
+    /// \brief Append s as a quoted JSON string.
+    OutputBuffer &json_string(const std::string &s)
+    {
+        buf_.push_back('"');
+        for (char c : s) {
+            switch (c) {
+                case '"':  buf_.append("\\\""); break;
+                case '\\': buf_.append("\\\\"); break;
+                case '\n': buf_.append("\\n");  break;
+                case '\t': buf_.append("\\t");  break;
+                case '\r': buf_.append("\\r");  break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        buf_.append("\\u00");
+                        buf_.push_back("0123456789abcdef"[(c >> 4) & 0xf]);
+                        buf_.push_back("0123456789abcdef"[c & 0xf]);
+                    } else {
+                        buf_.push_back(c);
+                    }
+            }
+        }
+        buf_.push_back('"');
+        if (buf_.size() >= capacity_) {
+            flush();
+        }
+        return *this;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__OUTPUT_BUFFER_H__
@@ -0,0 +1,590 @@
+#ifndef SESSTYPE__UTIL__PARALLEL_H__
+#define SESSTYPE__UTIL__PARALLEL_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#endif
+
+#include "sesstype/role.h"
+#include "sesstype/session.h"
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/node/continue.h"
+#include "sesstype/node/par.h"
+#include "sesstype/node/nested.h"
+#include "sesstype/node/interruptible.h"
+#include "sesstype/util/node_visitor.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Fork-join pool of worker threads with work-stealing queues.
+ *
+ * Tasks forked from a worker go to the back of its own queue, and are taken
+ * LIFO by the owner and FIFO by thieves. Threads waiting for a TaskGroup run
+ * pending tasks instead of blocking, so nested fork-join does not deadlock.
+ */
+class ForkJoinPool {
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<WorkQueue> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stop_;
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+
+  public:
+    /// \brief ForkJoinPool constructor.
+    /// \param[in] num_threads number of worker threads (0 for auto).
+    explicit ForkJoinPool(unsigned int num_threads = 0)
+        : queues_(std::max(1u, num_threads ? num_threads : std::thread::hardware_concurrency())),
+          threads_(), stop_(false), idle_mutex_(), idle_()
+    {
+        for (unsigned int i=0; i<queues_.size(); i++) {
+            threads_.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    ~ForkJoinPool()
+    {
+        stop_ = true;
+        idle_.notify_all();
+        for (auto &thread : threads_) {
+            thread.join();
+        }
+    }
+
+    ForkJoinPool(const ForkJoinPool &) = delete;
+    ForkJoinPool &operator=(const ForkJoinPool &) = delete;
+
+    /// \returns number of worker threads.
+    unsigned int num_threads() const
+    {
+        return threads_.size();
+    }
+
+    /// \brief Schedule a task.
+    void push(std::function<void()> task)
+    {
+        unsigned int idx = (current() == this ? index() : 0);
+        {
+            std::lock_guard<std::mutex> lock(queues_[idx].mutex);
+            queues_[idx].tasks.push_back(std::move(task));
+        }
+        idle_.notify_one();
+    }
+
+    /// \brief Run one pending task, own queue first then stealing.
+    /// \returns true if a task was run.
+    bool try_run_one()
+    {
+        std::function<void()> task;
+        unsigned int self = (current() == this ? index() : 0);
+        {
+            std::lock_guard<std::mutex> lock(queues_[self].mutex);
+            if (!queues_[self].tasks.empty()) {
+                task = std::move(queues_[self].tasks.back());
+                queues_[self].tasks.pop_back();
+            }
+        }
+        for (unsigned int i=1; !task && i<queues_.size(); i++) {
+            WorkQueue &victim = queues_[(self + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+  private:
+    static ForkJoinPool *&current()
+    {
+        static thread_local ForkJoinPool *pool = nullptr;
+        return pool;
+    }
+
+    static unsigned int &index()
+    {
+        static thread_local unsigned int idx = 0;
+        return idx;
+    }
+
+    void work(unsigned int idx)
+    {
+        current() = this;
+        index() = idx;
+        while (!stop_) {
+            if (!try_run_one()) {
+                std::unique_lock<std::mutex> lock(idle_mutex_);
+                idle_.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+    }
+};
+
+/**
+ * \brief Group of forked tasks joined by wait().
+ *
+ * The first exception thrown by a task is rethrown by wait().
+ */
+class TaskGroup {
+    ForkJoinPool &pool_;
+    std::atomic<long> pending_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+  public:
+    explicit TaskGroup(ForkJoinPool &pool)
+        : pool_(pool), pending_(0), error_mutex_(), error_() { }
+
+    ~TaskGroup()
+    {
+        help();
+    }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    /// \brief Fork task.
+    void run(std::function<void()> task)
+    {
+        pending_++;
+        pool_.push([this, task]() {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+            pending_--;
+        });
+    }
+
+    /// \brief Join all forked tasks, running pending tasks meanwhile.
+    void wait()
+    {
+        help();
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+  private:
+    void help()
+    {
+        while (pending_.load(std::memory_order_acquire) > 0) {
+            if (!pool_.try_run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+/// \brief Default discard of parallel_fold_tmpl, for Results which own nothing.
+struct KeepResult {
+    template <class Result>
+    void operator()(Result &) const { }
+};
+
+/**
+ * \brief Sequential tree fold with an explicit stack, see parallel_fold_tmpl.
+ */
+template <class BaseNode, class BlockType, class Result, class Map, class Combine,
+          class Discard = KeepResult>
+Result sequential_fold_tmpl(BaseNode *node, Map &map, Combine &combine,
+                            Discard discard = Discard())
+{
+    struct Frame {
+        BaseNode *node;
+        Result result;
+        unsigned int next;
+    };
+    std::vector<Frame> stack;
+    try {
+        stack.push_back(Frame { node, Result(), 0 });
+        stack.back().result = map(node);
+        while (true) {
+            Frame &top = stack.back();
+            auto *blk = dynamic_cast<BlockType *>(top.node);
+            if (blk != nullptr && top.next < blk->num_children()) {
+                BaseNode *child = blk->child(top.next++);
+                if (child != nullptr) {
+                    stack.push_back(Frame { child, Result(), 0 });
+                    stack.back().result = map(child);
+                }
+                continue;
+            }
+            if (stack.size() == 1) {
+                return top.result;
+            }
+            // The child is popped only once combined, so it is discarded
+            // with its parent if combine throws.
+            combine(stack[stack.size() - 2].result, top.result);
+            stack.pop_back();
+        }
+    } catch (...) {
+        for (auto &frame : stack) {
+            discard(frame.result);
+        }
+        throw;
+    }
+}
+
+/**
+ * \brief Parallel tree fold (map then reduce over children).
+ *
+ * The result of a Node is map(node) combined, in order, with the result of
+ * each of its children by combine(result, child_result). The children of
+ * blocks are folded as parallel tasks, each with its own copy of map
+ * (per-task visitor state), until fork_depth levels of forking; deeper
+ * subtrees are folded sequentially with an explicit stack.
+ *
+ * If map or combine throws, the exception is rethrown once every task has
+ * finished, and discard(result) is called on each Result which was computed
+ * but not yet combined into its parent (combine takes over the child Result
+ * only when it returns), e.g. to free the Nodes of a partial clone.
+ */
+template <class BaseNode, class BlockType, class Result, class Map, class Combine,
+          class Discard = KeepResult>
+Result parallel_fold_tmpl(ForkJoinPool &pool, BaseNode *node, Map map, Combine combine,
+                          unsigned int fork_depth = 8, Discard discard = Discard())
+{
+    if (fork_depth == 0) {
+        return sequential_fold_tmpl<BaseNode, BlockType, Result>(node, map, combine, discard);
+    }
+
+    // Chains of single-child blocks do not fork, fold them on the way back.
+    std::vector<BaseNode *> chain;
+    auto *blk = dynamic_cast<BlockType *>(node);
+    while (blk != nullptr && blk->num_children() == 1 && blk->child(0) != nullptr) {
+        chain.push_back(node);
+        node = blk->child(0);
+        blk = dynamic_cast<BlockType *>(node);
+    }
+
+    Result result = Result();
+    try {
+        if (blk == nullptr || blk->num_children() < 2) {
+            result = sequential_fold_tmpl<BaseNode, BlockType, Result>(node, map, combine, discard);
+        } else {
+            result = map(node);
+            // Large child lists are split in a few chunks per worker.
+            const unsigned int n = blk->num_children();
+            const unsigned int chunk = std::max(1u, n / (4 * pool.num_threads()));
+            std::vector<Result> results(n);
+            unsigned int next = 0; // First of results not combined yet.
+            try {
+                {
+                    TaskGroup group(pool);
+                    for (unsigned int begin=0; begin<n; begin+=chunk) {
+                        unsigned int end = std::min(n, begin + chunk);
+                        group.run([&pool, blk, map, combine, fork_depth, discard, &results,
+                                   begin, end]() {
+                            for (unsigned int i=begin; i<end; i++) {
+                                if (BaseNode *child = blk->child(i)) {
+                                    results[i] = parallel_fold_tmpl<BaseNode, BlockType, Result,
+                                                                    Map, Combine, Discard>(
+                                            pool, child, map, combine, fork_depth - 1, discard);
+                                }
+                            }
+                        });
+                    }
+                    group.wait();
+                }
+                for (; next<n; next++) {
+                    if (blk->child(next) != nullptr) {
+                        combine(result, results[next]);
+                    }
+                }
+            } catch (...) {
+                for (; next<n; next++) {
+                    discard(results[next]);
+                }
+                throw;
+            }
+        }
+
+        for (auto it=chain.rbegin(); it!=chain.rend(); it++) {
+            Result parent = map(*it);
+            try {
+                combine(parent, result);
+            } catch (...) {
+                discard(parent);
+                throw;
+            }
+            result = parent;
+        }
+    } catch (...) {
+        discard(result);
+        throw;
+    }
+    return result;
+}
+
+/// \brief Parallel tree fold over Node, see parallel_fold_tmpl.
+template <class Result, class Map, class Combine, class Discard = KeepResult>
+Result parallel_fold(ForkJoinPool &pool, Node *root, Map map, Combine combine,
+                     unsigned int fork_depth = 8, Discard discard = Discard())
+{
+    return parallel_fold_tmpl<Node, BlockNode, Result, Map, Combine, Discard>(
+            pool, root, map, combine, fork_depth, discard);
+}
+
+/// \brief Node count statistics of a tree.
+struct NodeStats {
+    unsigned long num_nodes;
+    unsigned long depth;
+    std::map<unsigned int, unsigned long> num_by_type;
+};
+
+/// \returns NodeStats of tree at root, computed in parallel.
+inline NodeStats parallel_stats(ForkJoinPool &pool, Node *root)
+{
+    return parallel_fold<NodeStats>(pool, root,
+            [](Node *node) -> NodeStats {
+                return NodeStats { 1, 1, { { node->type(), 1 } } };
+            },
+            [](NodeStats &acc, const NodeStats &child) {
+                acc.num_nodes += child.num_nodes;
+                acc.depth = std::max(acc.depth, child.depth + 1);
+                for (auto &count : child.num_by_type) {
+                    acc.num_by_type[count.first] += count.second;
+                }
+            });
+}
+
+/**
+ * \brief Hash of the attributes of a single Node (not its children).
+ */
+class NodeHash : public NodeVisitor {
+    std::uint64_t hash_;
+
+  public:
+    NodeHash() : hash_(0) { }
+
+    /// \returns hash of the last visited Node.
+    std::uint64_t hash() const
+    {
+        return hash_;
+    }
+
+    static std::uint64_t mix(std::uint64_t h, std::uint64_t v)
+    {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+
+    static std::uint64_t mix(std::uint64_t h, std::string s)
+    {
+        return mix(h, std::hash<std::string>()(s));
+    }
+
+    void visit(Node *node) override
+    {
+        hash_ = mix(0, node->type());
+    }
+
+    void visit(BlockNode *node) override
+    {
+        hash_ = mix(0, node->type());
+    }
+
+    void visit(InteractionNode *node) override
+    {
+        hash_ = mix(mix(0, node->type()), node->msg()->label());
+        hash_ = mix(hash_, node->msg()->num_payloads());
+        hash_ = mix(hash_, node->sndr() ? node->sndr()->name() : "");
+        for (auto it=node->rcvr_begin(); it!=node->rcvr_end(); it++) {
+            hash_ = mix(hash_, (*it)->name());
+        }
+    }
+
+    void visit(ChoiceNode *node) override
+    {
+        hash_ = mix(mix(0, node->type()), node->at() ? node->at()->name() : "");
+    }
+
+    void visit(RecurNode *node) override
+    {
+        hash_ = mix(mix(0, node->type()), node->label());
+    }
+
+    void visit(ContinueNode *node) override
+    {
+        hash_ = mix(mix(0, node->type()), node->label());
+    }
+
+    void visit(ParNode *node) override
+    {
+        hash_ = mix(0, node->type());
+    }
+
+    void visit(NestedNode *node) override
+    {
+        hash_ = mix(mix(mix(0, node->type()), node->name()), node->scope());
+    }
+
+    void visit(InterruptibleNode *node) override
+    {
+        hash_ = mix(mix(mix(0, node->type()), node->scope()), node->num_interrupts());
+    }
+};
+
+/// \returns structural hash of tree at root, computed in parallel.
+inline std::uint64_t parallel_hash(ForkJoinPool &pool, Node *root)
+{
+    return parallel_fold<std::uint64_t>(pool, root,
+            [](Node *node) -> std::uint64_t {
+                NodeHash hasher;
+                node->accept(hasher);
+                return hasher.hash();
+            },
+            [](std::uint64_t &acc, const std::uint64_t &child) {
+                acc = NodeHash::mix(acc, child);
+            });
+}
+
+/**
+ * \brief Copy of a single Node without its children.
+ *
+ * Nodes which do not accept a util::NodeVisitor (e.g. parameterised Nodes)
+ * are not visited, and get_shell() stays nullptr.
+ */
+class ShellClone : public NodeVisitor {
+    Node *shell_;
+
+  public:
+    ShellClone() : shell_(nullptr) { }
+
+    /// \returns copy of the last visited Node, without children.
+    Node *get_shell() const
+    {
+        return shell_;
+    }
+
+    void visit(Node *node) override
+    {
+        shell_ = dynamic_cast<Node *>(node->clone());
+    }
+
+    void visit(BlockNode *node) override
+    {
+        shell_ = new BlockNode();
+    }
+
+    void visit(InteractionNode *node) override
+    {
+        shell_ = node->clone();
+    }
+
+    void visit(ChoiceNode *node) override
+    {
+        shell_ = new ChoiceNode(node->at() ? node->at()->clone() : nullptr);
+    }
+
+    void visit(RecurNode *node) override
+    {
+        shell_ = new RecurNode(node->label());
+    }
+
+    void visit(ContinueNode *node) override
+    {
+        shell_ = node->clone();
+    }
+
+    void visit(ParNode *node) override
+    {
+        shell_ = new ParNode();
+    }
+
+    void visit(NestedNode *node) override
+    {
+        shell_ = node->clone();
+    }
+
+    void visit(InterruptibleNode *node) override
+    {
+        auto *shell = new InterruptibleNode(node->scope());
+        for (auto it=node->interrupt_begin(); it!=node->interrupt_end(); it++) {
+            shell->add_interrupt(it->first->clone(), it->second->clone());
+        }
+        for (auto it=node->throw_begin(); it!=node->throw_end(); it++) {
+            shell->add_throw(it->first->clone(), it->second->clone());
+        }
+        for (auto it=node->catch_begin(); it!=node->catch_end(); it++) {
+            shell->add_catch(it->first->clone(), it->second->clone());
+        }
+        shell_ = shell;
+    }
+};
+
+/// \returns deep copy of tree at root, computed in parallel.
+/// Nodes which ShellClone cannot copy (e.g. parameterised Nodes) are not
+/// BlockNodes, so the fold does not descend into them and their subtree is
+/// copied with Node::clone.
+inline Node *parallel_clone(ForkJoinPool &pool, Node *root)
+{
+    return parallel_fold<Node *>(pool, root,
+            [](Node *node) -> Node * {
+                ShellClone cloner;
+                node->accept(cloner);
+                Node *shell = cloner.get_shell();
+                return shell != nullptr ? shell : dynamic_cast<Node *>(node->clone());
+            },
+            [](Node *&acc, Node *const &child) {
+                dynamic_cast<BlockNode *>(acc)->append_child(child);
+            },
+            8, [](Node *&node) { delete node; });
+}
+
+/**
+ * \brief Deep copy of a Session with the body cloned in parallel.
+ *
+ * The copy is identical to the Session copy constructor. Nodes are
+ * individually owned and freed by their parents, so they are allocated
+ * normally rather than from an arena.
+ */
+inline Session *parallel_clone(ForkJoinPool &pool, const Session *session)
+{
+    Node *root = (session->root() == nullptr ? nullptr : parallel_clone(pool, session->root()));
+    return new Session(*session, root);
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__PARALLEL_H__
@@ -18,6 +18,8 @@
 
 #include "sesstype/util/role_visitor.h"
 #include "sesstype/util/node_visitor.h"
+#include "sesstype/util/output_buffer.h"
+#include "sesstype/util/traversal.h"
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -27,9 +29,13 @@ namespace util {
 #ifdef __cplusplus
 /**
  * \brief Protocol and Expression printer.
+ *
+ * Output is formatted into an OutputBuffer and written to the stream in bulk
+ * when the outermost visit returns. The tree is traversed with the
+ * iterative util::walk, so deep trees do not recurse.
  */
 class Print : public NodeVisitor, public RoleVisitor {
-    std::ostream &os_;
+    OutputBuffer os_;
     unsigned int indent_lvl_;
     std::string indent_str_;
     unsigned int line_count_;
@@ -53,9 +59,7 @@ class Print : public NodeVisitor, public RoleVisitor {
         os_ << line_count_++ << "\t ";
         if (indent_lvl_ > 1) {
             os_ << '|';
-            for (unsigned int i=1; i<indent_lvl_; i++) {
-                os_ << indent_str_;
-            }
+            os_.repeat(indent_str_, indent_lvl_ - 1);
         }
     }
 
@@ -67,11 +71,107 @@ class Print : public NodeVisitor, public RoleVisitor {
 
     void visit(Node *node)
     {
-        prefix();
-        os_ << "generic {} @ " << node << "\n";
+        print_tree(node);
     }
 
     void visit(InteractionNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(BlockNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(RecurNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(ContinueNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(ChoiceNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(ParNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(NestedNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(InterruptibleNode *node)
+    {
+        print_tree(node);
+    }
+
+    void visit(Role *role)
+    {
+        OutputBuffer::Scope scope(os_);
+        os_ << role->name();
+        os_ << "@" << role;
+    }
+
+    /// \brief Walker interface for the iterative util::walk.
+    bool enter(Node *node)
+    {
+        if (auto interaction = dynamic_cast<InteractionNode *>(node)) {
+            print(interaction);
+        } else if (auto recur = dynamic_cast<RecurNode *>(node)) {
+            print(recur);
+        } else if (auto cont = dynamic_cast<ContinueNode *>(node)) {
+            print(cont);
+        } else if (auto choice = dynamic_cast<ChoiceNode *>(node)) {
+            print(choice);
+        } else if (auto par = dynamic_cast<ParNode *>(node)) {
+            print(par);
+        } else if (auto nested = dynamic_cast<NestedNode *>(node)) {
+            print(nested);
+        } else if (auto interruptible = dynamic_cast<InterruptibleNode *>(node)) {
+            print(interruptible);
+        } else if (dynamic_cast<BlockNode *>(node) == nullptr) {
+            prefix();
+            os_ << "generic {} @ " << node << "\n";
+        }
+        if (is_indented(node)) {
+            indent_lvl_++;
+            return true;
+        }
+        return false;
+    }
+
+    /// \brief Walker interface for the iterative util::walk.
+    void leave(Node *node)
+    {
+        if (is_indented(node)) {
+            indent_lvl_--;
+        }
+    }
+
+  private:
+    /// Children of blocks (except interruptible) are printed one level in.
+    static bool is_indented(Node *node)
+    {
+        return dynamic_cast<BlockNode *>(node) != nullptr
+            && dynamic_cast<InterruptibleNode *>(node) == nullptr;
+    }
+
+    void print_tree(Node *node)
+    {
+        OutputBuffer::Scope scope(os_);
+        walk(node, *this);
+    }
+
+    void print(InteractionNode *node)
     {
         prefix();
         os_ << "interaction { from: ";
@@ -91,49 +191,34 @@ class Print : public NodeVisitor, public RoleVisitor {
             << "(" << node->msg()->num_payloads() << ") } @" << node << "\n";
     }
 
-    void visit(BlockNode *node)
-    {
-        indent_lvl_++;
-        for (auto it=node->child_begin(); it!=node->child_end(); it++) {
-            (*it)->accept(*this);
-        }
-        indent_lvl_--;
-    }
-
-    void visit(RecurNode *node)
+    void print(RecurNode *node)
     {
         prefix();
         os_ << "recur " << "{ label: " << node->label() << " }";
         os_ << " children: " << node->num_children() << " @" << node << "\n";
-
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
     }
 
-    void visit(ContinueNode *node)
+    void print(ContinueNode *node)
     {
         prefix();
         os_ << "cont { label: " << node->label() << " } @" << node << "\n";
     }
 
-    void visit(ChoiceNode *node)
+    void print(ChoiceNode *node)
     {
         prefix();
         os_ << "choice { at: " << node->at()->name() << " }";
         os_ << " children: " << node->num_children() << " @" << node << "\n";
-
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
     }
 
-    void visit(ParNode *node)
+    void print(ParNode *node)
     {
         prefix();
         os_ << "par {}";
         os_ << " parblocks:children: " << node->num_children() << " @" << node << "\n";
-
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
     }
 
-    void visit(NestedNode *node)
+    void print(NestedNode *node)
     {
         prefix();
         os_ << "nested { name: " << node->name();
@@ -151,7 +236,7 @@ class Print : public NodeVisitor, public RoleVisitor {
         os_ << "]} @ " << node << "\n";
     }
 
-    void visit(InterruptibleNode *node)
+    void print(InterruptibleNode *node)
     {
         prefix();
         os_ << "interruptible { scope: " << node->scope();
@@ -172,12 +257,6 @@ class Print : public NodeVisitor, public RoleVisitor {
         }
         os_ <<"} @ " << node << "\n";
     }
-
-    void visit(Role *role)
-    {
-        os_ << role->name();
-        os_ << "@" << role;
-    }
 };
 #endif // __cplusplus
 
@@ -3,6 +3,7 @@
 
 #ifdef __cplusplus
 #include <stack>
+#include <vector>
 #endif
 
 #include "sesstype/role.h"
@@ -15,7 +16,9 @@
 #include "sesstype/node/par.h"
 #include "sesstype/node/nested.h"
 #include "sesstype/node/interruptible.h"
+#include "sesstype/util/bind_recur.h"
 #include "sesstype/util/node_visitor.h"
+#include "sesstype/util/traversal.h"
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -25,13 +28,18 @@ namespace util {
 #ifdef __cplusplus
 /**
  * \brief Endpoint projection.
+ *
+ * The tree is traversed with the iterative util::walk, so any visit() call
+ * projects the whole subtree with heap memory bounded by its depth and no
+ * recursion.
  */
 class ProjectionVisitor : public NodeVisitor {
     Role *endpoint_;
     std::stack<Node *> stack_;
+    std::vector<Node *> pushed_; // Global Nodes with a projected block on stack_.
 
   public:
-    ProjectionVisitor(Role *endpoint) : endpoint_(endpoint), stack_()
+    ProjectionVisitor(Role *endpoint) : endpoint_(endpoint), stack_(), pushed_()
     {
         stack_.push(new BlockNode());
     }
@@ -43,109 +51,156 @@ class ProjectionVisitor : public NodeVisitor {
 
     void visit(Node *node) override
     {
-       // Nothing.
+        project_tree(node);
     }
 
     void visit(BlockNode *node) override
     {
-        /// Note that we are not adding a new root node here,
-        /// because the parent is addeded by one of below:
-        ///
-        /// 1. Subclass of BlockNode
-        /// 2. Constructor if this is the root Node
-        ///    (the only place when BlockNode exists as BlockNode)
-        for (auto it=node->child_begin(); it!=node->child_end(); it++) {
-            (*it)->accept(*this);
-        }
+        project_tree(node);
     }
 
     void visit(InteractionNode *node) override
     {
-        auto *parent = dynamic_cast<BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor> *>(stack_.top());
-        InteractionNode *projected_node;
-
-        if (node->sndr()->matches(endpoint_)) {
-            projected_node = node->clone();
-            projected_node->remove_sndr();
-            parent->append_child(projected_node);
-            return;
-        }
-        for (auto it=node->rcvr_begin(); it!=node->rcvr_end(); it++) {
-            if (*it && (*it)->matches(endpoint_)) {
-                projected_node = node->clone();
-                projected_node->remove_rcvrs();
-                parent->append_child(projected_node);
-                return;
-            }
-        }
-
-        // Remove this node because is does not match from/to
+        project_tree(node);
     }
 
-    void visit(ChoiceNode *node)
+    void visit(ChoiceNode *node) override
     {
-        auto *projected_node = new ChoiceNode(node->at());
-
-        stack_.push(projected_node);
-        if (endpoint_->matches(projected_node->at())) {
-            // Choice sender
-        }
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
-        stack_.pop();
-
-        dynamic_cast<BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor> *>(stack_.top())->append_child(projected_node);
+        project_tree(node);
     }
 
     void visit(RecurNode *node) override
     {
-        auto *projected_node = new RecurNode(node->label());
-
-        stack_.push(projected_node);
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
-        stack_.pop();
-
-        dynamic_cast<BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor> *>(stack_.top())->append_child(projected_node);
+        project_tree(node);
     }
 
     void visit(ContinueNode *node) override
     {
-        auto *projected_node = new ContinueNode(node->label());
-        dynamic_cast<BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor> *>(stack_.top())->append_child(projected_node);
+        project_tree(node);
     }
 
-    void visit(ParNode *node)
+    void visit(ParNode *node) override
     {
-        auto *projected_node = new ParNode();
+        project_tree(node);
+    }
 
-        stack_.push(projected_node);
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
-        stack_.pop();
+    void visit(NestedNode *node) override
+    {
+        project_tree(node);
+    }
 
-        dynamic_cast<BlockNode *>(stack_.top())->append_child(projected_node);
+    void visit(InterruptibleNode *node) override
+    {
+        project_tree(node);
     }
 
-    void visit(NestedNode *node)
+    /// \brief Walker interface for the iterative util::walk.
+    bool enter(Node *node)
     {
-        // Only include nested node if role arg matches.
-        for (auto it=node->rolearg_begin(); it!=node->rolearg_end(); it++) {
-            if ((*it)->matches(endpoint_)) {
-                dynamic_cast<BlockNode *>(stack_.top())->append_child(node->clone());
-                break;
+        if (auto interaction = dynamic_cast<InteractionNode *>(node)) {
+            project(interaction);
+        } else if (auto choice = dynamic_cast<ChoiceNode *>(node)) {
+            push(node, new ChoiceNode(choice->at() != nullptr ? choice->at()->clone() : nullptr));
+            return true;
+        } else if (auto recur = dynamic_cast<RecurNode *>(node)) {
+            push(node, new RecurNode(recur->label()));
+            return true;
+        } else if (dynamic_cast<ParNode *>(node) != nullptr) {
+            push(node, new ParNode());
+            return true;
+        } else if (auto interruptible = dynamic_cast<InterruptibleNode *>(node)) {
+            // TODO only retain interrupts relevant to endpoint role?
+            push(node, interruptible->clone());
+            return true;
+        } else if (auto cont = dynamic_cast<ContinueNode *>(node)) {
+            auto *projected_node = new ContinueNode(cont->label());
+            if (cont->is_bound()) {
+                projected_node->bind(cont->scope());
+            }
+            append(projected_node);
+        } else if (auto nested = dynamic_cast<NestedNode *>(node)) {
+            // Only include nested node if role arg matches.
+            for (auto it=nested->rolearg_begin(); it!=nested->rolearg_end(); it++) {
+                if ((*it)->matches(endpoint_)) {
+                    append(nested->clone());
+                    break;
+                }
+            }
+        } else if (dynamic_cast<BlockNode *>(node) != nullptr) {
+            /// Note that we are not adding a new root node here,
+            /// because the parent is addeded by one of above:
+            ///
+            /// 1. Subclass of BlockNode
+            /// 2. Constructor if this is the root Node
+            ///    (the only place when BlockNode exists as BlockNode)
+            ///
+            /// except for branches of choice and par, which are kept as blocks.
+            if (node->type() == ST_NODE_ROOT && is_branching(stack_.top())) {
+                push(node, new BlockNode());
             }
+            return true;
         }
+        return false;
     }
 
-    void visit(InterruptibleNode *node)
+    /// \brief Walker interface for the iterative util::walk.
+    void leave(Node *node)
     {
-        auto *new_node = node->clone();
+        if (!pushed_.empty() && pushed_.back() == node) {
+            pushed_.pop_back();
+            Node *projected_node = stack_.top();
+            stack_.pop();
+            append(projected_node);
+        }
+    }
 
-        // TODO only retain interrupts relevant to endpoint role?
+  private:
+    /// Project the subtree of node, then bind the projected ContinueNodes
+    /// to the projected RecurNodes (bindings of node are to global ones).
+    void project_tree(Node *node)
+    {
+        walk(node, *this);
+        RecurBinder binder;
+        walk(stack_.top(), binder);
+    }
 
-        stack_.push(new_node);
-        node->BlockNodeTmpl<Node, Role, MsgSig, util::NodeVisitor>::accept(*this);
-        stack_.pop();
+    void project(InteractionNode *node)
+    {
+        InteractionNode *projected_node;
 
-        dynamic_cast<BlockNode *>(stack_.top())->append_child(new_node);
+        if (node->sndr()->matches(endpoint_)) {
+            projected_node = node->clone();
+            projected_node->remove_sndr();
+            append(projected_node);
+            return;
+        }
+        for (auto it=node->rcvr_begin(); it!=node->rcvr_end(); it++) {
+            if (*it && (*it)->matches(endpoint_)) {
+                projected_node = node->clone();
+                projected_node->remove_rcvrs();
+                append(projected_node);
+                return;
+            }
+        }
+
+        // Remove this node because is does not match from/to
+    }
+
+    /// Make projected_node the parent of the projections of node's children.
+    void push(Node *node, Node *projected_node)
+    {
+        pushed_.push_back(node);
+        stack_.push(projected_node);
+    }
+
+    void append(Node *projected_node)
+    {
+        dynamic_cast<BlockNode *>(stack_.top())->append_child(projected_node);
+    }
+
+    static bool is_branching(Node *node)
+    {
+        return node->type() == ST_NODE_CHOICE || node->type() == ST_NODE_PARALLEL;
     }
 };
 #endif // __cplusplus
@@ -0,0 +1,94 @@
+#ifndef SESSTYPE__UTIL__STAMPED_H__
+#define SESSTYPE__UTIL__STAMPED_H__
+
+#ifdef __cplusplus
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#endif
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Revision stamp and frozen flag of a mutable object.
+ *
+ * Stamps are drawn from one counter shared by Nodes, MsgSigs, MsgPayloads
+ * and Roles, so a stamp is unique and larger than every stamp assigned
+ * before it. An object which owns others (e.g. an InteractionNode and its
+ * MsgSig) reports the largest stamp of itself and its parts as revision().
+ */
+class Stamped {
+    unsigned long revision_;
+    bool frozen_;
+
+  public:
+    virtual ~Stamped() { }
+
+    /// \returns revision stamp (unique across all Stamped objects).
+    virtual unsigned long revision() const { return revision_; }
+
+    /// \brief Mark as modified by assigning a fresh revision stamp.
+    /// \exception std::logic_error if frozen.
+    void touch()
+    {
+        check_mutable();
+        revision_ = next_revision();
+    }
+
+    /// \brief Make immutable.
+    virtual void freeze() { frozen_ = true; }
+
+    /// \returns true if frozen.
+    bool is_frozen() const { return frozen_; }
+
+    /// \exception std::logic_error if frozen.
+    void check_mutable() const
+    {
+        if (frozen_) {
+            throw std::logic_error("Object is frozen");
+        }
+    }
+
+  protected:
+    Stamped() : revision_(next_revision()), frozen_(false) { }
+
+    /// \brief A copy is a new (mutable) object with its own revision.
+    Stamped(const Stamped &) : revision_(next_revision()), frozen_(false) { }
+
+    Stamped &operator=(const Stamped &)
+    {
+        touch();
+        return *this;
+    }
+
+    /// \returns largest of revision and the revision of each part in [begin, end).
+    template <class Iterator>
+    static unsigned long max_revision(unsigned long revision, Iterator begin, Iterator end)
+    {
+        for (auto it=begin; it!=end; it++) {
+            if (*it != nullptr) {
+                revision = std::max(revision, (*it)->revision());
+            }
+        }
+        return revision;
+    }
+
+  private:
+    static unsigned long next_revision()
+    {
+        static std::atomic<unsigned long> counter(0);
+        return ++counter;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__STAMPED_H__
@@ -0,0 +1,126 @@
+#ifndef SESSTYPE__UTIL__TEXT_READER_H__
+#define SESSTYPE__UTIL__TEXT_READER_H__
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/module.h"
+#include "sesstype/msg.h"
+#include "sesstype/node.h"
+#include "sesstype/session.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Single-pass reader of the canonical text format (see TextExport).
+ *
+ * The input is tokenised on the fly and the tree is built as it is read,
+ * using an explicit stack of open blocks, so nesting depth is only limited
+ * by memory. Reading the output of TextExport gives a tree which exports to
+ * the same text.
+ *
+ * Syntax errors throw std::runtime_error with the line and column of the
+ * offending token, nothing read so far is leaked.
+ */
+class TextReader {
+  public:
+    /// \brief Token kinds.
+    enum TokenKind { END, NAME, STRING, PUNCT };
+
+    struct Token {
+        TokenKind kind;
+        const char *begin; ///< Start of token in input (after the quote).
+        std::size_t size;
+        std::size_t offset; ///< Offset of token in input.
+    };
+
+  private:
+    const char *data_;
+    std::size_t size_;
+    std::size_t pos_;
+    Token tok_; // Current (lookahead) token.
+    std::string str_; // Unescaped contents of current STRING token.
+
+  public:
+    /// \brief TextReader constructor.
+    /// \param[in] data of input text, must outlive the TextReader.
+    /// \param[in] size of data in bytes.
+    TextReader(const char *data, std::size_t size);
+
+    TextReader(const TextReader &) = delete;
+    TextReader &operator=(const TextReader &) = delete;
+
+    /// \returns true if all input has been read.
+    bool at_end() const
+    {
+        return tok_.kind == END;
+    }
+
+    /// \brief Read a Module with its imports and Sessions.
+    ///
+    /// As with Module::add_session, the Sessions are not owned by the
+    /// Module and must be deleted by the caller.
+    /// \exception std::runtime_error on syntax error.
+    Module *read_module();
+
+    /// \brief Read a single Session.
+    /// \exception std::runtime_error on syntax error.
+    Session *read_session();
+
+    /// \brief Read a single statement (Node tree).
+    /// \exception std::runtime_error on syntax error.
+    Node *read_statement();
+
+    /// \brief Read a whole file (memory-mapped) as a Module.
+    /// \exception std::runtime_error if unreadable or on syntax error.
+    static Module *read_module_file(std::string path);
+
+  private:
+    void next();
+    bool is_punct(char c) const;
+    bool is_keyword(const char *keyword) const;
+    void expect_punct(char c);
+    void expect_keyword(const char *keyword);
+    std::string name();
+    void msg(MsgSig &msg);
+    Node *statement_head(bool &is_block);
+    void handlers(Node *node);
+    [[noreturn]] void error(const std::string &what) const;
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// \brief Read a tree from canonical text.
+/// \param[in] text NUL-terminated input.
+/// \returns tree allocated dynamically, or NULL on syntax error.
+st_tree *st_tree_read_text(const char *text);
+
+/// \brief Read a module from a file in canonical text.
+/// \param[in] path of input file.
+/// \returns module allocated dynamically (trees are owned by the caller,
+///          see st_module_get_tree_at_idx), or NULL on error.
+st_module *st_module_read_text_file(const char *path);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__TEXT_READER_H__
@@ -0,0 +1,116 @@
+#ifndef SESSTYPE__UTIL__TRACE_CHECK_H__
+#define SESSTYPE__UTIL__TRACE_CHECK_H__
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#endif
+
+#include "sesstype/session.h"
+#include "sesstype/util/cfsm.h"
+#include "sesstype/util/monitor.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+/**
+ * Binary trace format (native byte order, no padding):
+ *
+ *     char     magic[4]     "STTR"
+ *     uint32   version      ST_TRACE_VERSION
+ *     uint32   num_roles    followed by num_roles x (uint32 len, char name[len])
+ *     uint32   num_labels   followed by num_labels x (uint32 len, char label[len])
+ *     events until end of file, each 3 x uint32 (sender, receiver, label)
+ *
+ * Sender and receiver are indices into the role table, label is an index
+ * into the label table.
+ */
+#define ST_TRACE_MAGIC   "STTR"
+#define ST_TRACE_VERSION 1
+
+#ifdef __cplusplus
+/**
+ * \brief Offline conformance checker of message traces against a Session.
+ *
+ * Every Role of the Session is projected and compiled into a Monitor. The
+ * trace is scanned once per worker thread, each worker checking a disjoint
+ * subset of the Roles, and the first violation of each Role is reported.
+ */
+class TraceChecker {
+  public:
+    /// \brief Outcome of the check for one Role.
+    struct Result {
+        std::string role;
+        long violation; ///< Index of first violating event, or -1.
+        bool complete;  ///< true if the Role ends in a final state.
+    };
+
+  private:
+    std::vector<std::string> roles_;
+    std::vector<std::unique_ptr<CFSM>> fsms_;
+    std::vector<Result> results_;
+    unsigned int num_threads_;
+
+  public:
+    /// \brief TraceChecker constructor.
+    /// \param[in] session global Session to check against.
+    /// \exception std::invalid_argument if a Role cannot be compiled.
+    explicit TraceChecker(const Session *session);
+
+    TraceChecker(const TraceChecker &) = delete;
+    TraceChecker &operator=(const TraceChecker &) = delete;
+
+    /// \param[in] num_threads maximum number of worker threads (0 for auto).
+    void set_num_threads(unsigned int num_threads)
+    {
+        num_threads_ = num_threads;
+    }
+
+    /// \brief Check a trace file, which is memory-mapped.
+    /// \param[in] path of trace file.
+    /// \returns true if no Role has a violation.
+    /// \exception std::runtime_error if the file cannot be read or is malformed.
+    bool check_file(std::string path);
+
+    /// \brief Check a trace in memory.
+    /// \param[in] data of trace.
+    /// \param[in] size of data in bytes.
+    /// \returns true if no Role has a violation.
+    /// \exception std::runtime_error if the trace is malformed.
+    bool check(const char *data, std::size_t size);
+
+    /// \returns results of the last check, one per Role.
+    const std::vector<Result> &results() const
+    {
+        return results_;
+    }
+};
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// \brief Check a binary trace file against a global session.
+/// \param[in] tree global session.
+/// \param[in] path of trace file.
+/// \returns number of roles with a violation, or -1 if the trace is unreadable.
+int st_tree_check_trace(st_tree *tree, const char *path);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__TRACE_CHECK_H__
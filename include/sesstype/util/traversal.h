@@ -0,0 +1,312 @@
+#ifndef SESSTYPE__UTIL__TRAVERSAL_H__
+#define SESSTYPE__UTIL__TRAVERSAL_H__
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#endif
+
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+
+#ifdef __cplusplus
+namespace sesstype {
+namespace util {
+#endif
+
+#ifdef __cplusplus
+/**
+ * \brief Pre-order iterator over a Node tree.
+ *
+ * Traversal uses an explicit stack on the heap, so the depth of the tree is
+ * not limited by the call stack. Null children are skipped.
+ */
+template <class BaseNode, class BlockType>
+class PreOrderIteratorTmpl {
+    struct Frame {
+        BaseNode *node;
+        unsigned int depth;
+    };
+    std::vector<Frame> stack_;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = BaseNode *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = BaseNode **;
+    using reference = BaseNode *;
+
+    /// \brief End iterator.
+    PreOrderIteratorTmpl() : stack_() { }
+
+    /// \brief Iterator starting at root.
+    explicit PreOrderIteratorTmpl(BaseNode *root) : stack_()
+    {
+        if (root != nullptr) {
+            stack_.push_back(Frame { root, 0 });
+        }
+    }
+
+    BaseNode *operator*() const
+    {
+        return stack_.back().node;
+    }
+
+    /// \returns depth of current Node (root is 0).
+    unsigned int depth() const
+    {
+        return stack_.back().depth;
+    }
+
+    /// \brief Advance to the next Node, skipping children of the current Node.
+    PreOrderIteratorTmpl &skip_children()
+    {
+        stack_.pop_back();
+        return *this;
+    }
+
+    PreOrderIteratorTmpl &operator++()
+    {
+        Frame cur = stack_.back();
+        stack_.pop_back();
+        if (auto *blk = dynamic_cast<BlockType *>(cur.node)) {
+            for (unsigned int i=blk->num_children(); i>0; i--) {
+                if (BaseNode *child = blk->child(i - 1)) {
+                    stack_.push_back(Frame { child, cur.depth + 1 });
+                }
+            }
+        }
+        return *this;
+    }
+
+    PreOrderIteratorTmpl operator++(int)
+    {
+        PreOrderIteratorTmpl it(*this);
+        ++(*this);
+        return it;
+    }
+
+    bool operator==(const PreOrderIteratorTmpl &other) const
+    {
+        if (stack_.empty() || other.stack_.empty()) {
+            return stack_.empty() && other.stack_.empty();
+        }
+        return stack_.size() == other.stack_.size() &&
+               stack_.back().node == other.stack_.back().node;
+    }
+
+    bool operator!=(const PreOrderIteratorTmpl &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+/**
+ * \brief Post-order iterator over a Node tree.
+ *
+ * Children are visited before their parent. Traversal uses an explicit stack
+ * on the heap. Null children are skipped.
+ */
+template <class BaseNode, class BlockType>
+class PostOrderIteratorTmpl {
+    struct Frame {
+        BaseNode *node;
+        unsigned int next;
+    };
+    std::vector<Frame> stack_;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = BaseNode *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = BaseNode **;
+    using reference = BaseNode *;
+
+    /// \brief End iterator.
+    PostOrderIteratorTmpl() : stack_() { }
+
+    /// \brief Iterator starting at the first leaf of root.
+    explicit PostOrderIteratorTmpl(BaseNode *root) : stack_()
+    {
+        if (root != nullptr) {
+            stack_.push_back(Frame { root, 0 });
+            descend();
+        }
+    }
+
+    BaseNode *operator*() const
+    {
+        return stack_.back().node;
+    }
+
+    /// \returns depth of current Node (root is 0).
+    unsigned int depth() const
+    {
+        return stack_.size() - 1;
+    }
+
+    PostOrderIteratorTmpl &operator++()
+    {
+        stack_.pop_back();
+        descend();
+        return *this;
+    }
+
+    PostOrderIteratorTmpl operator++(int)
+    {
+        PostOrderIteratorTmpl it(*this);
+        ++(*this);
+        return it;
+    }
+
+    bool operator==(const PostOrderIteratorTmpl &other) const
+    {
+        if (stack_.empty() || other.stack_.empty()) {
+            return stack_.empty() && other.stack_.empty();
+        }
+        return stack_.size() == other.stack_.size() &&
+               stack_.back().node == other.stack_.back().node;
+    }
+
+    bool operator!=(const PostOrderIteratorTmpl &other) const
+    {
+        return !(*this == other);
+    }
+
+  private:
+    /// Move to the first Node on top of the stack with all children done.
+    void descend()
+    {
+        while (!stack_.empty()) {
+            Frame &top = stack_.back();
+            auto *blk = dynamic_cast<BlockType *>(top.node);
+            if (blk == nullptr || top.next >= blk->num_children()) {
+                return;
+            }
+            BaseNode *child = blk->child(top.next++);
+            if (child != nullptr) {
+                stack_.push_back(Frame { child, 0 });
+            }
+        }
+    }
+};
+
+/// \brief begin()/end() pair for range-based for loops.
+template <class Iterator>
+class TraversalRange {
+    Iterator begin_;
+
+  public:
+    explicit TraversalRange(Iterator begin) : begin_(begin) { }
+
+    Iterator begin() const
+    {
+        return begin_;
+    }
+
+    Iterator end() const
+    {
+        return Iterator();
+    }
+};
+
+/**
+ * \brief Iterative tree walk with enter and leave callbacks.
+ *
+ * walker.enter(node) is called in pre-order and returns false to skip the
+ * children of node; walker.leave(node) is called for every Node after its
+ * children. Depth is bounded only by heap memory.
+ */
+template <class BaseNode, class BlockType, class Walker>
+void walk_tmpl(BaseNode *root, Walker &walker)
+{
+    struct Frame {
+        BaseNode *node;
+        unsigned int next;
+    };
+    std::vector<Frame> stack;
+    if (root == nullptr || !walker.enter(root)) {
+        if (root != nullptr) walker.leave(root);
+        return;
+    }
+    stack.push_back(Frame { root, 0 });
+    while (!stack.empty()) {
+        Frame &top = stack.back();
+        auto *blk = dynamic_cast<BlockType *>(top.node);
+        if (blk == nullptr || top.next >= blk->num_children()) {
+            BaseNode *node = top.node;
+            stack.pop_back();
+            walker.leave(node);
+            continue;
+        }
+        BaseNode *child = blk->child(top.next++);
+        if (child == nullptr) {
+            continue;
+        }
+        if (walker.enter(child)) {
+            stack.push_back(Frame { child, 0 });
+        } else {
+            walker.leave(child);
+        }
+    }
+}
+
+/**
+ * \brief Iterative visitor driver: accept visitor on every Node in pre-order.
+ *
+ * The visitor must not descend into BlockNode children itself (i.e. its
+ * visit methods handle a single Node), the driver does the traversal.
+ */
+template <class BaseNode, class BlockType, class VisitorType>
+void accept_preorder_tmpl(BaseNode *root, VisitorType &visitor)
+{
+    PreOrderIteratorTmpl<BaseNode, BlockType> end;
+    for (PreOrderIteratorTmpl<BaseNode, BlockType> it(root); it!=end; ++it) {
+        (*it)->accept(visitor);
+    }
+}
+
+/**
+ * \brief Iterative visitor driver: accept visitor on every Node in post-order.
+ *
+ * See accept_preorder_tmpl.
+ */
+template <class BaseNode, class BlockType, class VisitorType>
+void accept_postorder_tmpl(BaseNode *root, VisitorType &visitor)
+{
+    PostOrderIteratorTmpl<BaseNode, BlockType> end;
+    for (PostOrderIteratorTmpl<BaseNode, BlockType> it(root); it!=end; ++it) {
+        (*it)->accept(visitor);
+    }
+}
+
+using PreOrderIterator = PreOrderIteratorTmpl<Node, BlockNode>;
+using PostOrderIterator = PostOrderIteratorTmpl<Node, BlockNode>;
+
+/// \returns range of Nodes of tree at root in pre-order.
+inline TraversalRange<PreOrderIterator> preorder(Node *root)
+{
+    return TraversalRange<PreOrderIterator>(PreOrderIterator(root));
+}
+
+/// \returns range of Nodes of tree at root in post-order.
+inline TraversalRange<PostOrderIterator> postorder(Node *root)
+{
+    return TraversalRange<PostOrderIterator>(PostOrderIterator(root));
+}
+
+/// \brief Iterative tree walk, see walk_tmpl.
+template <class Walker>
+void walk(Node *root, Walker &walker)
+{
+    walk_tmpl<Node, BlockNode, Walker>(root, walker);
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+} // namespace util
+} // namespace sesstype
+#endif
+
+#endif//SESSTYPE__UTIL__TRAVERSAL_H__
@@ -27,4 +27,39 @@ st_node *st_node_get_child(st_node *const parent, unsigned int index)
     return nullptr;
 }
 
+st_node *st_node_detach_child(st_node *const parent, unsigned int index)
+{
+    if (auto blknode = dynamic_cast<BlockNode *>(parent)) {
+        return blknode->detach_child(index);
+    }
+    return nullptr;
+}
+
+st_node *st_node_insert_child(st_node *const parent, unsigned int index, st_node *child)
+{
+    if (auto blknode = dynamic_cast<BlockNode *>(parent)) {
+        blknode->insert_child(index, child);
+    }
+    return parent;
+}
+
+st_node *st_node_splice_children(st_node *const parent, unsigned int index,
+                                 st_node *const src, unsigned int first, unsigned int last)
+{
+    auto blknode = dynamic_cast<BlockNode *>(parent);
+    auto src_blknode = dynamic_cast<BlockNode *>(src);
+    if (blknode && src_blknode) {
+        blknode->splice(index, src_blknode, first, last);
+    }
+    return parent;
+}
+
+st_node *st_node_swap_children(st_node *const parent, unsigned int i, unsigned int j)
+{
+    if (auto blknode = dynamic_cast<BlockNode *>(parent)) {
+        blknode->swap_children(i, j);
+    }
+    return parent;
+}
+
 } // namespace sesstype
@@ -0,0 +1,171 @@
+#include <memory>
+#include <vector>
+
+#include <sesstype/bulk.h>
+#include <sesstype/msg.h>
+#include <sesstype/node.h>
+#include <sesstype/node/block.h>
+#include <sesstype/node/choice.h>
+#include <sesstype/node/continue.h>
+#include <sesstype/node/interaction.h>
+#include <sesstype/node/par.h>
+#include <sesstype/node/recur.h>
+#include <sesstype/role.h>
+#include <sesstype/session.h>
+
+namespace sesstype {
+
+namespace {
+
+bool is_block_kind(unsigned int kind)
+{
+    return kind == ST_NODE_ROOT || kind == ST_NODE_CHOICE
+        || kind == ST_NODE_RECUR || kind == ST_NODE_PARALLEL;
+}
+
+/// Check every index in desc before anything is allocated.
+bool is_valid(const st_tree_bulk *desc)
+{
+    if (desc->num_nodes > 0 && (desc->kinds == nullptr || desc->parents == nullptr)) {
+        return false;
+    }
+    if (desc->num_roles > 0 && desc->role_names == nullptr) {
+        return false;
+    }
+    for (unsigned int r=0; r<desc->num_roles; r++) {
+        if (desc->role_names[r] == nullptr) return false;
+    }
+    if (desc->num_labels > 0 && desc->label_names == nullptr) {
+        return false;
+    }
+    for (unsigned int l=0; l<desc->num_labels; l++) {
+        if (desc->label_names[l] == nullptr) return false;
+    }
+    if (desc->num_msgs > 0) {
+        if (desc->msg_labels == nullptr || desc->payload_offsets == nullptr) {
+            return false;
+        }
+        for (unsigned int m=0; m<desc->num_msgs; m++) {
+            if (desc->msg_labels[m] >= desc->num_labels
+                    || desc->payload_offsets[m] > desc->payload_offsets[m + 1]) {
+                return false;
+            }
+        }
+        if (desc->payload_offsets[desc->num_msgs] > desc->payload_offsets[0]
+                && desc->payload_types == nullptr) {
+            return false;
+        }
+        for (unsigned int p=desc->payload_offsets[0]; p<desc->payload_offsets[desc->num_msgs]; p++) {
+            if (desc->payload_types[p] == nullptr) return false;
+        }
+    }
+
+    for (unsigned int i=0; i<desc->num_nodes; i++) {
+        int parent = desc->parents[i];
+        if (i == 0 ? parent != -1 : (parent < 0 || static_cast<unsigned int>(parent) >= i
+                    || !is_block_kind(desc->kinds[parent]))) {
+            return false;
+        }
+        unsigned int kind = desc->kinds[i];
+        int role = desc->roles != nullptr ? desc->roles[i] : -1;
+        switch (kind) {
+            case ST_NODE_ROOT:
+            case ST_NODE_PARALLEL:
+                break;
+            case ST_NODE_CHOICE:
+                if (role >= static_cast<int>(desc->num_roles)) return false;
+                break;
+            case ST_NODE_RECUR:
+            case ST_NODE_CONTINUE:
+                if (desc->args == nullptr || desc->args[i] >= desc->num_labels) return false;
+                break;
+            case ST_NODE_SENDRECV:
+                if (desc->args == nullptr || desc->args[i] >= desc->num_msgs) return false;
+                if (role >= static_cast<int>(desc->num_roles)) return false;
+                if (desc->rcvr_offsets != nullptr) {
+                    if (desc->rcvr_offsets[i] > desc->rcvr_offsets[i + 1]) return false;
+                    for (unsigned int k=desc->rcvr_offsets[i]; k<desc->rcvr_offsets[i + 1]; k++) {
+                        if (desc->rcvrs == nullptr || desc->rcvrs[k] >= desc->num_roles) return false;
+                    }
+                }
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+st_tree *st_tree_mk_bulk(const st_tree_bulk *desc)
+{
+    if (desc == nullptr || !is_valid(desc)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Session> session(new Session(desc->name != nullptr ? desc->name : "default"));
+    std::vector<Role *> roles(desc->num_roles);
+    for (unsigned int r=0; r<desc->num_roles; r++) {
+        roles[r] = new Role(desc->role_names[r]);
+        session->add_role(roles[r]);
+    }
+
+    // Message prototypes, cloned into each InteractionNode.
+    std::vector<std::unique_ptr<MsgSig>> msgs(desc->num_msgs);
+    for (unsigned int m=0; m<desc->num_msgs; m++) {
+        msgs[m].reset(new MsgSig(desc->label_names[desc->msg_labels[m]]));
+        for (unsigned int p=desc->payload_offsets[m]; p<desc->payload_offsets[m + 1]; p++) {
+            const char *name = desc->payload_names != nullptr ? desc->payload_names[p] : nullptr;
+            MsgPayload payload(desc->payload_types[p], name != nullptr ? name : "");
+            msgs[m]->add_payload(&payload);
+        }
+    }
+
+    std::vector<BlockNode *> blocks(desc->num_nodes, nullptr);
+    Node *root = nullptr;
+    for (unsigned int i=0; i<desc->num_nodes; i++) {
+        int role = desc->roles != nullptr ? desc->roles[i] : -1;
+        Node *node = nullptr;
+        switch (desc->kinds[i]) {
+            case ST_NODE_ROOT:
+                node = blocks[i] = new BlockNode();
+                break;
+            case ST_NODE_PARALLEL:
+                node = blocks[i] = new ParNode();
+                break;
+            case ST_NODE_CHOICE:
+                node = blocks[i] = new ChoiceNode(role >= 0 ? roles[role]->clone() : nullptr);
+                break;
+            case ST_NODE_RECUR:
+                node = blocks[i] = new RecurNode(desc->label_names[desc->args[i]]);
+                break;
+            case ST_NODE_CONTINUE:
+                node = new ContinueNode(desc->label_names[desc->args[i]]);
+                break;
+            case ST_NODE_SENDRECV:
+            {
+                auto *interaction = new InteractionNode(msgs[desc->args[i]].get());
+                if (role >= 0) {
+                    interaction->set_sndr(roles[role]);
+                }
+                if (desc->rcvr_offsets != nullptr) {
+                    for (unsigned int k=desc->rcvr_offsets[i]; k<desc->rcvr_offsets[i + 1]; k++) {
+                        interaction->add_rcvr(roles[desc->rcvrs[k]]);
+                    }
+                }
+                node = interaction;
+                break;
+            }
+        }
+        if (i == 0) {
+            root = node;
+        } else {
+            blocks[desc->parents[i]]->append_child(node);
+        }
+    }
+    session->set_root(root);
+    return session.release();
+}
+
+} // namespace sesstype
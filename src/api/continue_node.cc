@@ -32,4 +32,15 @@ const char *st_continue_node_get_label(st_node *node)
     }
 }
 
+int st_continue_node_get_scope(st_node *node)
+{
+    if (ContinueNode *cont = dynamic_cast<ContinueNode *>(node)) {
+        return cont->scope();
+    } else {
+        std::cerr << __FILE__ << ":" << __LINE__ << ": "
+                  << __FUNCTION__ << ": node is not a Continue.\n";
+        return -1;
+    }
+}
+
 } // namespace sesstype
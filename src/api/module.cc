@@ -1,4 +1,6 @@
 #include <sesstype/module.h>
+#include <sesstype/util/bind_recur.h>
+#include <sesstype/util/traversal.h>
 
 namespace sesstype {
 
@@ -25,9 +27,7 @@ st_tree *st_module_get_tree(st_module *const module, const char *name)
 
 st_tree *st_module_get_tree_at_idx(st_module *const module, unsigned int index)
 {
-    auto it = module->session_begin();
-    for (int i=0; i<index; i++, it++) { /* empty */ }
-    return it->second;
+    return module->session_at(index);
 }
 
 st_module *st_module_import(st_module *const module, st_import *import)
@@ -36,6 +36,21 @@ st_module *st_module_import(st_module *const module, st_import *import)
     return module;
 }
 
+const st_module *st_module_freeze(st_module *const module)
+{
+    for (auto it=module->session_begin(); it!=module->session_end(); it++) {
+        if (it->second->is_frozen()) {
+            continue;
+        }
+        util::RecurBinder binder;
+        util::walk(it->second->root(), binder);
+        if (!binder.is_valid()) {
+            return NULL;
+        }
+    }
+    return module->freeze();
+}
+
 void st_module_free(st_module *module)
 {
     delete module;
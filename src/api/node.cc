@@ -1,8 +1,10 @@
 #include <iostream>
 
 #include "sesstype/node.h"
+#include "sesstype/util/bind_recur.h"
 #include "sesstype/util/print.h"
 #include "sesstype/util/project.h"
+#include "sesstype/util/traversal.h"
 
 namespace sesstype {
 
@@ -13,6 +15,13 @@ st_node *st_node_project(st_node *const node, st_role *const endpoint)
     return proj_visitor.get_root();
 }
 
+bool st_node_bind_recur(st_node *const node)
+{
+    sesstype::util::RecurBinder binder;
+    sesstype::util::walk(node, binder);
+    return binder.is_valid();
+}
+
 void st_node_print(st_node *const node)
 {
     sesstype::util::Print printer;
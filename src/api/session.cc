@@ -1,6 +1,8 @@
 #include <sesstype/import.h>
 #include <sesstype/session.h>
 #include <sesstype/role.h>
+#include <sesstype/util/bind_recur.h>
+#include <sesstype/util/traversal.h>
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -28,6 +30,18 @@ st_node *st_tree_get_root(st_tree *tree)
     return tree->root();
 }
 
+const st_tree *st_tree_freeze(st_tree *tree)
+{
+    if (!tree->is_frozen()) {
+        util::RecurBinder binder;
+        util::walk(tree->root(), binder);
+        if (!binder.is_valid()) {
+            return NULL;
+        }
+    }
+    return tree->freeze();
+}
+
 void st_tree_free(st_tree *tree)
 {
     delete tree;
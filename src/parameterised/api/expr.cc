@@ -62,15 +62,14 @@ st_expr *st_expr_copy(const st_expr *e)
 
 bool st_expr_is_identical(st_expr *e0, st_expr *e1)
 {
-    assert(0 /*TODO*/);
-    return false;
+    return sesstype::parameterised::util::ExprCanon::is_identical(e0, e1);
 }
 
 st_expr *st_expr_eval(st_expr *const e)
 {
-    sesstype::parameterised::util::ExprEval s;
-    e->accept(s);
-    return s.eval();
+    sesstype::parameterised::util::ExprCanon canon;
+    e->accept(canon);
+    return canon.canon();
 }
 
 st_expr *st_expr_apply(st_expr *const b, st_expr *const e)
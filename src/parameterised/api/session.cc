@@ -1,8 +1,12 @@
 #include <iostream>
+#include <map>
+#include <string>
+
 #include "sesstype/session.h"
 #include "sesstype/parameterised/const.h"
 #include "sesstype/parameterised/session.h"
 #include "sesstype/parameterised/util/print.h"
+#include "sesstype/parameterised/util/specialise.h"
 
 #ifdef __cplusplus
 namespace sesstype {
@@ -73,6 +77,19 @@ void st_param_tree_print(st_param_tree *const tree)
     tree->root()->accept(prot_printer);
 }
 
+st_param_tree *st_param_tree_specialise(st_param_tree *const tree,
+        unsigned int num_consts, st_const **consts)
+{
+    std::map<std::string, long> constants;
+    for (unsigned int i=0; i<num_consts; i++) {
+        if (auto val = dynamic_cast<ValueConstant *>(consts[i])) {
+            constants[val->name()] = val->value();
+        }
+    }
+    sesstype::parameterised::util::Specialise specialiser(constants);
+    return specialiser.session(*tree);
+}
+
 void st_param_tree_free(st_param_tree *const tree)
 {
     delete tree;
@@ -0,0 +1,726 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#include <sesstype/parameterised/expr.h>
+#include <sesstype/parameterised/expr/add.h>
+#include <sesstype/parameterised/expr/log.h>
+#include <sesstype/parameterised/expr/mul.h>
+#include <sesstype/parameterised/expr/rng.h>
+#include <sesstype/parameterised/expr/sub.h>
+#include <sesstype/parameterised/expr/val.h>
+#include <sesstype/parameterised/expr/var.h>
+#include <sesstype/parameterised/msg.h>
+#include <sesstype/parameterised/node.h>
+#include <sesstype/parameterised/nodes.h>
+#include <sesstype/parameterised/role.h>
+#include <sesstype/parameterised/session.h>
+#include <sesstype/parameterised/util/comm_graph.h>
+#include <sesstype/parameterised/util/traversal.h>
+
+namespace sesstype {
+namespace parameterised {
+namespace util {
+
+namespace {
+
+/// Expr compiled to postfix operations over variable slots.
+struct Program {
+    struct Op {
+        unsigned int code; // ST_EXPR_* of the operation.
+        long arg;          // Value of ST_EXPR_CONST, slot of ST_EXPR_VAR.
+    };
+    std::vector<Op> ops;
+
+    /// \returns false if the value is undefined (e.g. division by zero).
+    bool eval(const long *vars, std::vector<long> &stack, long &result) const
+    {
+        stack.clear();
+        for (auto &op : ops) {
+            if (op.code == ST_EXPR_CONST) {
+                stack.push_back(op.arg);
+                continue;
+            }
+            if (op.code == ST_EXPR_VAR) {
+                stack.push_back(vars[op.arg]);
+                continue;
+            }
+            long rhs = stack.back();
+            stack.pop_back();
+            long &lhs = stack.back();
+            switch (op.code) {
+                case ST_EXPR_ADD: lhs += rhs; break;
+                case ST_EXPR_SUB: lhs -= rhs; break;
+                case ST_EXPR_MUL: lhs *= rhs; break;
+                case ST_EXPR_DIV:
+                    if (rhs == 0) return false;
+                    lhs /= rhs;
+                    break;
+                case ST_EXPR_MOD:
+                    if (rhs == 0) return false;
+                    lhs %= rhs;
+                    break;
+                case ST_EXPR_SHL: lhs <<= rhs; break;
+                case ST_EXPR_SHR: lhs >>= rhs; break;
+                case ST_EXPR_LOG:
+                {
+                    if (lhs <= 0 || rhs < 2) return false;
+                    long log = 0;
+                    for (long value=lhs; value>=rhs; value/=rhs) {
+                        log++;
+                    }
+                    lhs = log;
+                    break;
+                }
+            }
+        }
+        result = stack.back();
+        return true;
+    }
+};
+
+/// Compiles Exprs with variables bound to slots (innermost binding first).
+class Compiler {
+    const std::map<std::string, long> &constants_;
+    std::vector<std::string> scope_; // Variable of each slot.
+
+  public:
+    explicit Compiler(const std::map<std::string, long> &constants)
+        : constants_(constants), scope_() { }
+
+    unsigned int num_slots() const
+    {
+        return scope_.size();
+    }
+
+    /// \returns slot of var.
+    unsigned int bind(const std::string &var)
+    {
+        scope_.push_back(var);
+        return scope_.size() - 1;
+    }
+
+    void unbind(unsigned int num_slots)
+    {
+        scope_.resize(num_slots);
+    }
+
+    Program compile(Expr *expr) const
+    {
+        Program program;
+        compile(expr, program);
+        return program;
+    }
+
+  private:
+    void compile(Expr *expr, Program &program) const
+    {
+        switch (expr->type()) {
+            case ST_EXPR_CONST:
+                program.ops.push_back({ ST_EXPR_CONST, static_cast<ValExpr *>(expr)->num() });
+                return;
+            case ST_EXPR_VAR:
+            {
+                const std::string &name = static_cast<VarExpr *>(expr)->name();
+                for (unsigned int slot=scope_.size(); slot>0; slot--) {
+                    if (scope_[slot - 1] == name) {
+                        program.ops.push_back({ ST_EXPR_VAR, slot - 1 });
+                        return;
+                    }
+                }
+                auto it = constants_.find(name);
+                if (it == constants_.end()) {
+                    throw std::invalid_argument("Unbound variable " + name);
+                }
+                program.ops.push_back({ ST_EXPR_CONST, it->second });
+                return;
+            }
+            case ST_EXPR_LOG:
+            {
+                auto log = static_cast<LogExpr *>(expr);
+                compile(log->value(), program);
+                compile(log->base(), program);
+                program.ops.push_back({ ST_EXPR_LOG, 0 });
+                return;
+            }
+            default:
+                if (auto bin = dynamic_cast<BinExpr *>(expr)) {
+                    compile(bin->lhs(), program);
+                    compile(bin->rhs(), program);
+                    program.ops.push_back({ static_cast<unsigned int>(expr->type()), 0 });
+                    return;
+                }
+                throw std::invalid_argument("Range or sequence used as a single index");
+        }
+    }
+};
+
+/// Loop over [from, to], binding the slot of its nesting level.
+struct Loop {
+    Program from;
+    Program to;
+    bool has_except;     // Skip the values in [except_from, except_to].
+    Program except_from;
+    Program except_to;
+};
+
+/// Bounds [from, to] of one dimension of a MsgCond.
+struct Bound {
+    Program from;
+    Program to;
+};
+
+/// One sender-receiver pair of an InteractionNode with its iteration space.
+struct Pattern {
+    std::vector<Loop> loops;
+    unsigned int src_role;
+    unsigned int dst_role;
+    std::vector<Program> src_index;
+    std::vector<Program> dst_index;
+    unsigned int cond_side; // 0 without condition, 1 on sender, 2 on receiver.
+    std::vector<Bound> cond;
+    Program size;
+};
+
+/// Collects a Pattern per sender-receiver pair of every InteractionNode.
+class PatternBuilder {
+    Compiler compiler_;
+    const std::map<std::string, unsigned int> &role_ids_;
+    const TypeSizeTable &sizes_;
+    std::vector<Loop> loops_;
+
+  public:
+    std::vector<Pattern> patterns;
+
+    PatternBuilder(const std::map<std::string, long> &constants,
+            const std::map<std::string, unsigned int> &role_ids, const TypeSizeTable &sizes)
+        : compiler_(constants), role_ids_(role_ids), sizes_(sizes), loops_(), patterns() { }
+
+    bool enter(Node *node)
+    {
+        switch (node->type()) {
+            case ST_NODE_SENDRECV:
+                if (auto interaction = dynamic_cast<InteractionNode *>(node)) {
+                    add(interaction);
+                }
+                return false;
+            case ST_NODE_FOR:
+            {
+                auto for_node = dynamic_cast<ForNode *>(node);
+                RngExpr *bindexpr = for_node->bindexpr();
+                bind_loop(bindexpr, bindexpr != nullptr ? bindexpr->bindvar() : "", for_node->except());
+                return true;
+            }
+            case ST_NODE_ONEOF:
+            {
+                auto oneof = dynamic_cast<OneofNode *>(node);
+                bind_loop(oneof->range(), oneof->var());
+                return true;
+            }
+            case ST_NODE_NESTED:
+            case ST_NODE_ALLREDUCE:
+                return false;
+            default:
+                return true;
+        }
+    }
+
+    void leave(Node *node)
+    {
+        if (node->type() == ST_NODE_FOR || node->type() == ST_NODE_ONEOF) {
+            loops_.pop_back();
+            compiler_.unbind(loops_.size());
+        }
+    }
+
+  private:
+    /// Bind var over range, except is a value or range of var to skip.
+    void bind_loop(RngExpr *range, const std::string &var, Expr *except = nullptr)
+    {
+        if (range == nullptr) {
+            throw std::invalid_argument("Loop without range");
+        }
+        Loop loop { compiler_.compile(range->from()), compiler_.compile(range->to()), false, Program(), Program() };
+        if (except != nullptr) {
+            Bound bound = bounds(except);
+            loop.has_except = true;
+            loop.except_from = bound.from;
+            loop.except_to = bound.to;
+        }
+        loops_.push_back(loop);
+        compiler_.bind(var);
+    }
+
+    /// \returns [from, to] of a range, or [expr, expr] of a single value.
+    Bound bounds(Expr *expr) const
+    {
+        if (auto rng = dynamic_cast<RngExpr *>(expr)) {
+            return Bound { compiler_.compile(rng->from()), compiler_.compile(rng->to()) };
+        }
+        Program value = compiler_.compile(expr);
+        return Bound { value, value };
+    }
+
+    /// Compile the condition of interaction into pattern.
+    void condition(InteractionNode *interaction, Role *rcvr, Pattern &pattern) const
+    {
+        MsgCond *cond = interaction->cond();
+        pattern.cond_side = 0;
+        if (cond == nullptr || cond->num_dimens() == 0) {
+            return;
+        }
+        if (cond->name() == interaction->sndr()->name()) {
+            pattern.cond_side = 1;
+        } else if (cond->name() == rcvr->name()) {
+            pattern.cond_side = 2;
+        } else {
+            throw std::invalid_argument("Condition on Role " + cond->name() + " outside of interaction");
+        }
+        std::size_t num_dimens = pattern.cond_side == 1 ? pattern.src_index.size() : pattern.dst_index.size();
+        if (cond->num_dimens() != num_dimens) {
+            throw std::invalid_argument("Condition on Role " + cond->name() + " with wrong dimensions");
+        }
+        for (unsigned int i=0; i<cond->num_dimens(); i++) {
+            pattern.cond.push_back(bounds((*cond)[i]));
+        }
+    }
+
+    /// \returns index Programs of role, ranges are added to pattern loops.
+    std::vector<Program> index(Role *role, Pattern &pattern)
+    {
+        std::vector<Program> programs;
+        for (unsigned int i=0; i<role->num_dimens(); i++) {
+            Expr *param = (*role)[i];
+            if (auto rng = dynamic_cast<RngExpr *>(param)) {
+                pattern.loops.push_back(Loop { compiler_.compile(rng->from()), compiler_.compile(rng->to()),
+                        false, Program(), Program() });
+                unsigned int slot = compiler_.bind(rng->bindvar());
+                programs.push_back(Program { { { ST_EXPR_VAR, static_cast<long>(slot) } } });
+            } else {
+                programs.push_back(compiler_.compile(param));
+            }
+        }
+        return programs;
+    }
+
+    unsigned int role_id(Role *role) const
+    {
+        auto it = role_ids_.find(role->name());
+        if (it == role_ids_.end()) {
+            throw std::invalid_argument("Undeclared Role " + role->name());
+        }
+        return it->second;
+    }
+
+    void add(InteractionNode *interaction)
+    {
+        if (interaction->sndr() == nullptr) {
+            return;
+        }
+        Expr *size = new ValExpr(0);
+        if (interaction->msg() != nullptr) {
+            for (auto it=interaction->msg()->payload_begin(); it!=interaction->msg()->payload_end(); it++) {
+                Expr *payload_size = new ValExpr(sizes_.size((*it)->type()));
+                if (auto payload = dynamic_cast<MsgPayload *>(*it)) {
+                    for (unsigned int i=0; i<payload->num_dimens(); i++) {
+                        Expr *dimen = (*payload)[i];
+                        auto rng = dynamic_cast<RngExpr *>(dimen);
+                        payload_size = new MulExpr(payload_size, rng != nullptr
+                                ? new AddExpr(new SubExpr(rng->to()->clone(), rng->from()->clone()), new ValExpr(1))
+                                : dimen->clone());
+                    }
+                }
+                size = new AddExpr(size, payload_size);
+            }
+        }
+
+        unsigned int num_slots = compiler_.num_slots();
+        try {
+            for (auto it=interaction->rcvr_begin(); it!=interaction->rcvr_end(); it++) {
+                Pattern pattern;
+                pattern.loops = loops_;
+                pattern.src_role = role_id(interaction->sndr());
+                pattern.dst_role = role_id(*it);
+                pattern.src_index = index(interaction->sndr(), pattern);
+                pattern.dst_index = index(*it, pattern);
+                condition(interaction, *it, pattern);
+                pattern.size = compiler_.compile(size);
+                patterns.push_back(pattern);
+                compiler_.unbind(num_slots);
+            }
+        } catch (...) {
+            delete size;
+            throw;
+        }
+        delete size;
+    }
+};
+
+/// Chunk of the outermost loop of a Pattern.
+struct Work {
+    unsigned int pattern;
+    long from;
+    long to;
+};
+
+struct Edge {
+    unsigned long src;
+    unsigned long dst;
+    unsigned long msgs;
+    unsigned long bytes;
+};
+
+/// Smallest buffer of a worker before its edges are merged.
+const std::size_t MIN_EDGE_BUFFER = 1 << 16;
+
+/// Sort edges by (src, dst) and merge the messages of equal edges.
+void merge_edges(std::vector<Edge> &edges)
+{
+    std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+        return a.src < b.src || (a.src == b.src && a.dst < b.dst);
+    });
+    auto out = edges.begin();
+    for (auto it=edges.begin(); it!=edges.end(); it++) {
+        if (out != edges.begin() && (out - 1)->src == it->src && (out - 1)->dst == it->dst) {
+            (out - 1)->msgs += it->msgs;
+            (out - 1)->bytes += it->bytes;
+        } else {
+            *out++ = *it;
+        }
+    }
+    edges.erase(out, edges.end());
+}
+
+struct Entry {
+    unsigned long dst;
+    unsigned long msgs;
+    unsigned long bytes;
+};
+
+/// Run worker(tid) on num_threads threads, including the calling thread.
+template <class Worker>
+void run_threads(unsigned int num_threads, Worker worker)
+{
+    std::vector<std::thread> threads;
+    for (unsigned int t=1; t<num_threads; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
+CommGraph::CommGraph()
+    : roles_(), layouts_(), role_offsets_(), row_offsets_(), columns_(), msgs_(),
+      bytes_(), num_dropped_(0), num_threads_(0), layout_order_(ST_LAYOUT_ROW_MAJOR)
+{
+}
+
+void CommGraph::build(const Session &session, const std::map<std::string, long> &constants,
+        const TypeSizeTable &sizes)
+{
+    roles_.clear();
+    layouts_.clear();
+    role_offsets_.assign(1, 0);
+    row_offsets_.clear();
+    columns_.clear();
+    msgs_.clear();
+    bytes_.clear();
+    num_dropped_ = 0;
+
+    for (auto it=session.role_begin(); it!=session.role_end(); it++) {
+        roles_.push_back(it->first);
+    }
+    std::sort(roles_.begin(), roles_.end());
+
+    std::map<std::string, unsigned int> role_ids;
+    for (unsigned int r=0; r<roles_.size(); r++) {
+        role_ids[roles_[r]] = r;
+        layouts_.push_back(RoleLayout(session.role(roles_[r]), constants, layout_order_));
+        role_offsets_.push_back(role_offsets_.back() + layouts_.back().size());
+    }
+    unsigned long num_ranks = role_offsets_.back();
+
+    PatternBuilder builder(constants, role_ids, sizes);
+    if (session.root() != nullptr) {
+        walk(session.root(), builder);
+    }
+    const std::vector<Pattern> &patterns = builder.patterns;
+
+    unsigned int num_threads = num_threads_;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Split the outermost loop of every Pattern into chunks.
+    std::vector<Work> work;
+    for (unsigned int p=0; p<patterns.size(); p++) {
+        if (patterns[p].loops.empty()) {
+            work.push_back(Work { p, 0, 0 });
+            continue;
+        }
+        std::vector<long> stack;
+        long from, to;
+        if (!patterns[p].loops[0].from.eval(nullptr, stack, from)
+                || !patterns[p].loops[0].to.eval(nullptr, stack, to)) {
+            throw std::invalid_argument("Cannot evaluate loop bound");
+        }
+        if (to < from) {
+            continue;
+        }
+        unsigned long chunk = std::max(1ul, (to - from + 1) / (8ul * num_threads));
+        for (long lo=from; lo<=to; lo+=chunk) {
+            work.push_back(Work { p, lo, std::min<long>(to, lo + chunk - 1) });
+        }
+    }
+    num_threads = std::max(1u, std::min<unsigned int>(num_threads, work.size()));
+
+    std::vector<std::vector<Edge>> edges(num_threads);
+    std::vector<unsigned long> dropped(num_threads, 0);
+    std::atomic<std::size_t> next_work(0);
+    std::atomic<bool> undefined(false);
+    auto enumerate = [&](unsigned int tid) {
+        std::vector<long> stack;
+        std::vector<long> vars;
+        std::vector<long> index;
+
+        // Messages are merged per (src, dst) whenever the buffer doubles, so
+        // it stays within twice the number of distinct edges of the worker.
+        std::size_t limit = MIN_EDGE_BUFFER;
+        auto add_edge = [&](unsigned long src, unsigned long dst, unsigned long bytes) {
+            edges[tid].push_back(Edge { src, dst, 1, bytes });
+            if (edges[tid].size() >= limit) {
+                merge_edges(edges[tid]);
+                limit = std::max(MIN_EDGE_BUFFER, 2 * edges[tid].size());
+            }
+        };
+
+        // rank of the Role instance at index, or num_ranks if out of range.
+        auto rank_of = [&](unsigned int role, const std::vector<Program> &programs) {
+            if (programs.size() != layouts_[role].num_dimens()) {
+                return num_ranks;
+            }
+            index.resize(programs.size());
+            for (unsigned int d=0; d<programs.size(); d++) {
+                if (!programs[d].eval(vars.data(), stack, index[d])) {
+                    undefined = true;
+                    return num_ranks;
+                }
+            }
+            unsigned long rank;
+            if (!layouts_[role].find_rank(index.data(), rank)) {
+                return num_ranks;
+            }
+            return role_offsets_[role] + rank;
+        };
+
+        // true if the iteration value of loop is excluded by its except.
+        auto excluded = [&](const Loop &loop, long value) {
+            if (!loop.has_except) {
+                return false;
+            }
+            long from, to;
+            if (!loop.except_from.eval(vars.data(), stack, from)
+                    || !loop.except_to.eval(vars.data(), stack, to)) {
+                undefined = true;
+                return true;
+            }
+            return from <= value && value <= to;
+        };
+
+        // true if the Role instance of the condition of pattern is selected.
+        auto selected = [&](const Pattern &pattern) {
+            const std::vector<Program> &programs = pattern.cond_side == 1
+                ? pattern.src_index : pattern.dst_index;
+            for (unsigned int d=0; d<pattern.cond.size(); d++) {
+                long value, from, to;
+                if (!programs[d].eval(vars.data(), stack, value)
+                        || !pattern.cond[d].from.eval(vars.data(), stack, from)
+                        || !pattern.cond[d].to.eval(vars.data(), stack, to)) {
+                    undefined = true;
+                    return false;
+                }
+                if (value < from || value > to) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // Iterate over loops [level, end) of pattern.
+        std::function<void(const Pattern &, unsigned int)> iterate;
+        iterate = [&](const Pattern &pattern, unsigned int level) {
+            if (level == pattern.loops.size()) {
+                if (!selected(pattern)) {
+                    return;
+                }
+                unsigned long src = rank_of(pattern.src_role, pattern.src_index);
+                unsigned long dst = rank_of(pattern.dst_role, pattern.dst_index);
+                long size;
+                if (!pattern.size.eval(vars.data(), stack, size)) {
+                    undefined = true;
+                    return;
+                }
+                if (src == num_ranks || dst == num_ranks) {
+                    dropped[tid]++;
+                    return;
+                }
+                add_edge(src, dst, static_cast<unsigned long>(size));
+                return;
+            }
+            long from, to;
+            if (!pattern.loops[level].from.eval(vars.data(), stack, from)
+                    || !pattern.loops[level].to.eval(vars.data(), stack, to)) {
+                undefined = true;
+                return;
+            }
+            for (long i=from; i<=to && !undefined; i++) {
+                if (excluded(pattern.loops[level], i)) {
+                    continue;
+                }
+                vars[level] = i;
+                iterate(pattern, level + 1);
+            }
+        };
+
+        for (std::size_t w=next_work++; w<work.size() && !undefined; w=next_work++) {
+            const Pattern &pattern = patterns[work[w].pattern];
+            vars.assign(pattern.loops.size(), 0);
+            if (pattern.loops.empty()) {
+                iterate(pattern, 0);
+                continue;
+            }
+            for (long i=work[w].from; i<=work[w].to && !undefined; i++) {
+                if (excluded(pattern.loops[0], i)) {
+                    continue;
+                }
+                vars[0] = i;
+                iterate(pattern, 1);
+            }
+        }
+        merge_edges(edges[tid]);
+    };
+    run_threads(num_threads, enumerate);
+    if (undefined) {
+        throw std::invalid_argument("Cannot evaluate index expression");
+    }
+    for (auto n : dropped) {
+        num_dropped_ += n;
+    }
+
+    // Bucket the edges by source, then sort and merge each row.
+    std::vector<unsigned long> starts(num_ranks + 1, 0);
+    for (auto &thread_edges : edges) {
+        for (auto &edge : thread_edges) {
+            starts[edge.src + 1]++;
+        }
+    }
+    for (unsigned long r=0; r<num_ranks; r++) {
+        starts[r + 1] += starts[r];
+    }
+    std::vector<Entry> entries(starts[num_ranks]);
+    std::vector<unsigned long> cursor(starts.begin(), starts.end() - 1);
+    for (auto &thread_edges : edges) {
+        for (auto &edge : thread_edges) {
+            entries[cursor[edge.src]++] = Entry { edge.dst, edge.msgs, edge.bytes };
+        }
+        std::vector<Edge>().swap(thread_edges);
+    }
+
+    unsigned int num_row_threads = std::max<unsigned long>(1, std::min<unsigned long>(num_threads, num_ranks));
+    std::vector<unsigned long> row_sizes(num_ranks, 0);
+    auto merge_rows = [&](unsigned int tid) {
+        for (unsigned long r=tid; r<num_ranks; r+=num_row_threads) {
+            auto begin = entries.begin() + starts[r], end = entries.begin() + starts[r + 1];
+            std::sort(begin, end, [](const Entry &a, const Entry &b) { return a.dst < b.dst; });
+            auto out = begin;
+            for (auto it=begin; it!=end; it++) {
+                if (out != begin && (out - 1)->dst == it->dst) {
+                    (out - 1)->msgs += it->msgs;
+                    (out - 1)->bytes += it->bytes;
+                } else {
+                    *out++ = *it;
+                }
+            }
+            row_sizes[r] = out - begin;
+        }
+    };
+    run_threads(num_row_threads, merge_rows);
+
+    row_offsets_.assign(num_ranks + 1, 0);
+    for (unsigned long r=0; r<num_ranks; r++) {
+        row_offsets_[r + 1] = row_offsets_[r] + row_sizes[r];
+    }
+    columns_.resize(row_offsets_[num_ranks]);
+    msgs_.resize(row_offsets_[num_ranks]);
+    bytes_.resize(row_offsets_[num_ranks]);
+    auto compact_rows = [&](unsigned int tid) {
+        for (unsigned long r=tid; r<num_ranks; r+=num_row_threads) {
+            for (unsigned long k=0; k<row_sizes[r]; k++) {
+                const Entry &entry = entries[starts[r] + k];
+                columns_[row_offsets_[r] + k] = entry.dst;
+                msgs_[row_offsets_[r] + k] = entry.msgs;
+                bytes_[row_offsets_[r] + k] = entry.bytes;
+            }
+        }
+    };
+    run_threads(num_row_threads, compact_rows);
+}
+
+unsigned long CommGraph::find_edge(unsigned long src, unsigned long dst) const
+{
+    if (src >= num_ranks()) {
+        return num_edges();
+    }
+    auto begin = columns_.begin() + row_offsets_[src], end = columns_.begin() + row_offsets_[src + 1];
+    auto it = std::lower_bound(begin, end, dst);
+    return it != end && *it == dst ? it - columns_.begin() : num_edges();
+}
+
+const RoleLayout &CommGraph::layout(const std::string &role) const
+{
+    auto it = std::lower_bound(roles_.begin(), roles_.end(), role);
+    if (it == roles_.end() || *it != role) {
+        throw std::out_of_range("Unknown Role " + role);
+    }
+    return layouts_[it - roles_.begin()];
+}
+
+unsigned long CommGraph::rank(const std::string &role, const std::vector<long> &index) const
+{
+    auto it = std::lower_bound(roles_.begin(), roles_.end(), role);
+    if (it == roles_.end() || *it != role) {
+        throw std::out_of_range("Unknown Role " + role);
+    }
+    unsigned int r = it - roles_.begin();
+    return role_offsets_[r] + layouts_[r].rank(index);
+}
+
+std::string CommGraph::role(unsigned long rank) const
+{
+    if (rank >= num_ranks()) {
+        throw std::out_of_range("Rank out of range");
+    }
+    auto it = std::upper_bound(role_offsets_.begin(), role_offsets_.end(), rank);
+    return roles_[it - role_offsets_.begin() - 1];
+}
+
+std::vector<long> CommGraph::index(unsigned long rank) const
+{
+    if (rank >= num_ranks()) {
+        throw std::out_of_range("Rank out of range");
+    }
+    auto it = std::upper_bound(role_offsets_.begin(), role_offsets_.end(), rank);
+    unsigned int r = it - role_offsets_.begin() - 1;
+    return layouts_[r].index(rank - role_offsets_[r]);
+}
+
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
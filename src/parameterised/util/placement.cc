@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include <sesstype/parameterised/util/comm_graph.h>
+#include <sesstype/parameterised/util/placement.h>
+
+namespace sesstype {
+namespace parameterised {
+namespace util {
+
+namespace {
+
+/// Undirected weighted graph in CSR form, without self loops.
+struct Graph {
+    std::vector<unsigned long> offsets;
+    std::vector<unsigned long> adj;
+    std::vector<long> weights;
+};
+
+Graph symmetrise(const CommGraph &comm, unsigned int weight)
+{
+    const std::vector<unsigned long> &rows = comm.row_offsets();
+    const std::vector<unsigned long> &cols = comm.columns();
+    const std::vector<unsigned long> &w = weight == ST_PLACE_MSGS ? comm.msgs() : comm.bytes();
+    unsigned long n = comm.num_ranks();
+
+    std::vector<unsigned long> starts(n + 1, 0);
+    for (unsigned long u=0; u<n; u++) {
+        for (unsigned long e=rows[u]; e<rows[u + 1]; e++) {
+            if (cols[e] != u) {
+                starts[u + 1]++;
+                starts[cols[e] + 1]++;
+            }
+        }
+    }
+    for (unsigned long u=0; u<n; u++) {
+        starts[u + 1] += starts[u];
+    }
+    std::vector<std::pair<unsigned long, long>> entries(starts[n]);
+    std::vector<unsigned long> cursor(starts.begin(), starts.end() - 1);
+    for (unsigned long u=0; u<n; u++) {
+        for (unsigned long e=rows[u]; e<rows[u + 1]; e++) {
+            if (cols[e] != u) {
+                entries[cursor[u]++] = { cols[e], static_cast<long>(w[e]) };
+                entries[cursor[cols[e]]++] = { u, static_cast<long>(w[e]) };
+            }
+        }
+    }
+
+    // Merge u -> v and v -> u into one edge.
+    Graph graph;
+    graph.offsets.push_back(0);
+    for (unsigned long u=0; u<n; u++) {
+        std::sort(entries.begin() + starts[u], entries.begin() + starts[u + 1]);
+        for (unsigned long k=starts[u]; k<starts[u + 1]; k++) {
+            if (graph.adj.size() > graph.offsets.back() && graph.adj.back() == entries[k].first) {
+                graph.weights.back() += entries[k].second;
+            } else {
+                graph.adj.push_back(entries[k].first);
+                graph.weights.push_back(entries[k].second);
+            }
+        }
+        graph.offsets.push_back(graph.adj.size());
+    }
+    return graph;
+}
+
+/// Bisection of subsets of the vertices of a Graph.
+class Bisector {
+    const Graph &graph_;
+    std::vector<unsigned int> stamp_;  // Generation in which a vertex is in the subset.
+    std::vector<unsigned long> local_; // Index of a vertex in the subset.
+    unsigned int generation_;
+
+    static const unsigned int max_passes = 8;
+
+  public:
+    explicit Bisector(const Graph &graph)
+        : graph_(graph), stamp_(graph.offsets.size() - 1, 0),
+          local_(graph.offsets.size() - 1, 0), generation_(0) { }
+
+    /// \returns side (0 or 1) of each vertex of verts, with size0 vertices on side 0.
+    std::vector<char> bisect(const std::vector<unsigned long> &verts, unsigned long size0)
+    {
+        generation_++;
+        for (unsigned long i=0; i<verts.size(); i++) {
+            stamp_[verts[i]] = generation_;
+            local_[verts[i]] = i;
+        }
+        std::vector<char> side(verts.size(), 1);
+        if (size0 == 0 || size0 >= verts.size()) {
+            std::fill(side.begin(), side.end(), size0 == 0 ? 1 : 0);
+            return side;
+        }
+        grow(verts, size0, side);
+        for (unsigned int pass=0; pass<max_passes; pass++) {
+            if (!refine(verts, size0, side)) {
+                break;
+            }
+        }
+        return side;
+    }
+
+  private:
+    /// Call f(local index, weight) for each neighbour of vertex in the subset.
+    template <class F>
+    void for_neighbours(unsigned long vertex, F f) const
+    {
+        for (unsigned long e=graph_.offsets[vertex]; e<graph_.offsets[vertex + 1]; e++) {
+            unsigned long v = graph_.adj[e];
+            if (stamp_[v] == generation_) {
+                f(local_[v], graph_.weights[e]);
+            }
+        }
+    }
+
+    /// \returns last vertex reached by breadth-first search from vertex 0.
+    unsigned long peripheral(const std::vector<unsigned long> &verts) const
+    {
+        std::vector<char> seen(verts.size(), 0);
+        std::queue<unsigned long> queue;
+        unsigned long last = 0;
+        queue.push(0);
+        seen[0] = 1;
+        while (!queue.empty()) {
+            last = queue.front();
+            queue.pop();
+            for_neighbours(verts[last], [&](unsigned long j, long) {
+                if (!seen[j]) {
+                    seen[j] = 1;
+                    queue.push(j);
+                }
+            });
+        }
+        return last;
+    }
+
+    /// Greedy graph growing of side 0 from a peripheral vertex.
+    void grow(const std::vector<unsigned long> &verts, unsigned long size0, std::vector<char> &side) const
+    {
+        std::vector<long> conn(verts.size(), 0);
+        std::priority_queue<std::pair<long, long>> heap; // (connection, -index)
+        heap.push({ 0, -static_cast<long>(peripheral(verts)) });
+        unsigned long next = 0;
+        for (unsigned long count=0; count<size0; count++) {
+            unsigned long i;
+            while (!heap.empty() && (side[-heap.top().second] == 0 || heap.top().first != conn[-heap.top().second])) {
+                heap.pop();
+            }
+            if (heap.empty()) {
+                // Disconnected: continue from the first vertex of side 1.
+                while (side[next] == 0) {
+                    next++;
+                }
+                i = next;
+            } else {
+                i = -heap.top().second;
+                heap.pop();
+            }
+            side[i] = 0;
+            for_neighbours(verts[i], [&](unsigned long j, long w) {
+                if (side[j] == 1) {
+                    conn[j] += w;
+                    heap.push({ conn[j], -static_cast<long>(j) });
+                }
+            });
+        }
+    }
+
+    /// One Fiduccia-Mattheyses pass keeping size0 vertices on side 0.
+    /// \returns true if the cut was reduced.
+    bool refine(const std::vector<unsigned long> &verts, unsigned long size0, std::vector<char> &side) const
+    {
+        unsigned long m = verts.size();
+        std::vector<long> gain(m, 0);
+        for (unsigned long i=0; i<m; i++) {
+            for_neighbours(verts[i], [&](unsigned long j, long w) {
+                gain[i] += side[j] != side[i] ? w : -w;
+            });
+        }
+        std::priority_queue<std::pair<long, long>> heaps[2]; // (gain, -index)
+        for (unsigned long i=0; i<m; i++) {
+            heaps[static_cast<int>(side[i])].push({ gain[i], -static_cast<long>(i) });
+        }
+        std::vector<char> locked(m, 0);
+        auto clean = [&](int s) {
+            while (!heaps[s].empty()) {
+                unsigned long i = -heaps[s].top().second;
+                if (!locked[i] && side[i] == s && heaps[s].top().first == gain[i]) {
+                    return true;
+                }
+                heaps[s].pop();
+            }
+            return false;
+        };
+
+        std::vector<unsigned long> moves;
+        unsigned long count0 = size0;
+        long total = 0, best_total = 0;
+        unsigned long best_len = 0;
+        unsigned long max_idle = std::max<unsigned long>(64, m / 8);
+        while (moves.size() - best_len < max_idle) {
+            bool has0 = clean(0), has1 = clean(1);
+            int from;
+            if (count0 > size0) {
+                from = 0;
+            } else if (count0 < size0) {
+                from = 1;
+            } else if (has0 && has1) {
+                from = heaps[0].top().first >= heaps[1].top().first ? 0 : 1;
+            } else {
+                from = has0 ? 0 : 1;
+            }
+            if (!(from == 0 ? has0 : has1)) {
+                break;
+            }
+            unsigned long i = -heaps[from].top().second;
+            heaps[from].pop();
+            side[i] = 1 - from;
+            locked[i] = 1;
+            total += gain[i];
+            moves.push_back(i);
+            count0 += from == 0 ? -1 : 1;
+            for_neighbours(verts[i], [&](unsigned long j, long w) {
+                if (locked[j]) {
+                    return;
+                }
+                gain[j] += side[j] == side[i] ? -2 * w : 2 * w;
+                heaps[static_cast<int>(side[j])].push({ gain[j], -static_cast<long>(j) });
+            });
+            if (count0 == size0 && total > best_total) {
+                best_total = total;
+                best_len = moves.size();
+            }
+        }
+        for (unsigned long k=moves.size(); k>best_len; k--) {
+            side[moves[k - 1]] ^= 1;
+        }
+        return best_total > 0;
+    }
+};
+
+} // namespace
+
+Placement::Placement(const std::vector<unsigned int> &hierarchy)
+    : hierarchy_(hierarchy), spans_(hierarchy.size(), 1), slots_(), weight_(ST_PLACE_BYTES)
+{
+    for (unsigned int level=hierarchy_.size(); level>0; level--) {
+        if (hierarchy_[level - 1] == 0) {
+            throw std::invalid_argument("Placement level without children");
+        }
+        if (level < hierarchy_.size()) {
+            spans_[level - 1] = spans_[level] * hierarchy_[level];
+        }
+    }
+}
+
+void Placement::place(const CommGraph &graph)
+{
+    unsigned long n = graph.num_ranks();
+    if (n > capacity()) {
+        throw std::invalid_argument("More ranks than slots");
+    }
+    Graph undirected = symmetrise(graph, weight_);
+    Bisector bisector(undirected);
+    slots_.assign(n, 0);
+
+    // Split verts between parts [0, num_parts) of level, each with span slots.
+    std::function<void(const std::vector<unsigned long> &, unsigned int, unsigned long, unsigned long)> split;
+    split = [&](const std::vector<unsigned long> &verts, unsigned int level,
+            unsigned long num_parts, unsigned long base) {
+        if (verts.empty()) {
+            return;
+        }
+        if (level == hierarchy_.size()) {
+            slots_[verts[0]] = base;
+            return;
+        }
+        unsigned long span = spans_[level];
+        if (num_parts == 1) {
+            unsigned int next = level + 1;
+            split(verts, next, next < hierarchy_.size() ? hierarchy_[next] : 1, base);
+            return;
+        }
+        unsigned long parts0 = num_parts / 2;
+        unsigned long parts1 = num_parts - parts0;
+        unsigned long size0 = (verts.size() * parts0 + num_parts / 2) / num_parts;
+        size0 = std::min(size0, parts0 * span);
+        size0 = std::max(size0, verts.size() > parts1 * span ? verts.size() - parts1 * span : 0);
+
+        std::vector<char> side = bisector.bisect(verts, size0);
+        std::vector<unsigned long> verts0, verts1;
+        for (unsigned long i=0; i<verts.size(); i++) {
+            (side[i] == 0 ? verts0 : verts1).push_back(verts[i]);
+        }
+        split(verts0, level, parts0, base);
+        split(verts1, level, parts1, base + parts0 * span);
+    };
+
+    std::vector<unsigned long> verts(n);
+    for (unsigned long r=0; r<n; r++) {
+        verts[r] = r;
+    }
+    split(verts, 0, hierarchy_.empty() ? 1 : hierarchy_[0], 0);
+}
+
+void Placement::set_slots(const std::vector<unsigned long> &slots)
+{
+    std::vector<char> used(capacity(), 0);
+    for (auto slot : slots) {
+        if (slot >= capacity() || used[slot]) {
+            throw std::invalid_argument("Invalid placement slot");
+        }
+        used[slot] = 1;
+    }
+    slots_ = slots;
+}
+
+unsigned long Placement::traffic(const CommGraph &graph, unsigned int level) const
+{
+    const std::vector<unsigned long> &w = weight_ == ST_PLACE_MSGS ? graph.msgs() : graph.bytes();
+    unsigned long total = 0;
+    for (unsigned long u=0; u<graph.num_ranks(); u++) {
+        for (unsigned long e=graph.row_offsets()[u]; e<graph.row_offsets()[u + 1]; e++) {
+            if (domain(u, level) != domain(graph.columns()[e], level)) {
+                total += w[e];
+            }
+        }
+    }
+    return total;
+}
+
+} // namespace util
+} // namespace parameterised
+} // namespace sesstype
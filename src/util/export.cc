@@ -0,0 +1,44 @@
+#include <cstdio>
+
+#include "sesstype/module.h"
+#include "sesstype/session.h"
+#include "sesstype/util/export.h"
+#include "sesstype/util/output_buffer.h"
+
+namespace sesstype {
+
+namespace {
+
+template <class Exporter, class Object>
+int export_to(Object *object, FILE *out)
+{
+    util::OutputBuffer buf(out);
+    Exporter exporter(buf);
+    exporter.write(*object);
+    buf.flush();
+    return exporter.is_valid() && std::fflush(out) == 0 ? 0 : -1;
+}
+
+} // namespace
+
+int st_tree_export_json(st_tree *const tree, FILE *out)
+{
+    return export_to<util::JsonExport>(tree, out);
+}
+
+int st_tree_export_text(st_tree *const tree, FILE *out)
+{
+    return export_to<util::TextExport>(tree, out);
+}
+
+int st_module_export_json(st_module *const module, FILE *out)
+{
+    return export_to<util::JsonExport>(module, out);
+}
+
+int st_module_export_text(st_module *const module, FILE *out)
+{
+    return export_to<util::TextExport>(module, out);
+}
+
+} // namespace sesstype
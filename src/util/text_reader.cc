@@ -0,0 +1,477 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sesstype/import.h>
+#include <sesstype/module.h>
+#include <sesstype/node/block.h>
+#include <sesstype/node/choice.h>
+#include <sesstype/node/continue.h>
+#include <sesstype/node/interaction.h>
+#include <sesstype/node/interruptible.h>
+#include <sesstype/node/nested.h>
+#include <sesstype/node/par.h>
+#include <sesstype/node/recur.h>
+#include <sesstype/session.h>
+#include <sesstype/util/text_reader.h>
+
+namespace sesstype {
+namespace util {
+
+TextReader::TextReader(const char *data, std::size_t size)
+    : data_(data), size_(size), pos_(0), tok_(), str_()
+{
+    next();
+}
+
+void TextReader::next()
+{
+    for (;;) {
+        while (pos_ < size_ && std::isspace(static_cast<unsigned char>(data_[pos_]))) {
+            pos_++;
+        }
+        if (pos_ + 1 < size_ && data_[pos_] == '/' && data_[pos_ + 1] == '/') {
+            while (pos_ < size_ && data_[pos_] != '\n') {
+                pos_++;
+            }
+            continue;
+        }
+        break;
+    }
+    tok_.offset = pos_;
+    if (pos_ >= size_) {
+        tok_.kind = END;
+        tok_.begin = data_ + pos_;
+        tok_.size = 0;
+        return;
+    }
+
+    char c = data_[pos_];
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+        std::size_t start = pos_;
+        while (pos_ < size_ && (std::isalnum(static_cast<unsigned char>(data_[pos_]))
+                    || data_[pos_] == '_' || data_[pos_] == '.')) {
+            pos_++;
+        }
+        tok_.kind = NAME;
+        tok_.begin = data_ + start;
+        tok_.size = pos_ - start;
+        return;
+    }
+    if (c == '"') {
+        str_.clear();
+        pos_++;
+        while (pos_ < size_ && data_[pos_] != '"') {
+            char ch = data_[pos_++];
+            if (ch == '\\') {
+                if (pos_ >= size_) break;
+                ch = data_[pos_++];
+                switch (ch) {
+                    case 'n': ch = '\n'; break;
+                    case 't': ch = '\t'; break;
+                    case 'r': ch = '\r'; break;
+                    case 'u':
+                    {
+                        unsigned int code = 0;
+                        for (unsigned int i=0; i<4; i++, pos_++) {
+                            if (pos_ >= size_ || !std::isxdigit(static_cast<unsigned char>(data_[pos_]))) {
+                                error("bad escape sequence");
+                            }
+                            char digit = data_[pos_];
+                            code = code * 16 + (std::isdigit(static_cast<unsigned char>(digit))
+                                    ? digit - '0' : (std::tolower(digit) - 'a' + 10));
+                        }
+                        ch = static_cast<char>(code);
+                        break;
+                    }
+                    default: break; // \" and \\ .
+                }
+            }
+            str_.push_back(ch);
+        }
+        if (pos_ >= size_) {
+            error("unterminated string");
+        }
+        pos_++; // Closing quote.
+        tok_.kind = STRING;
+        tok_.begin = str_.data();
+        tok_.size = str_.size();
+        return;
+    }
+    if (std::strchr("{}()<>,;:@", c) != nullptr) {
+        tok_.kind = PUNCT;
+        tok_.begin = data_ + pos_++;
+        tok_.size = 1;
+        return;
+    }
+    error(std::string("unexpected character '") + c + "'");
+}
+
+bool TextReader::is_punct(char c) const
+{
+    return tok_.kind == PUNCT && *tok_.begin == c;
+}
+
+bool TextReader::is_keyword(const char *keyword) const
+{
+    return tok_.kind == NAME && std::strlen(keyword) == tok_.size
+        && std::memcmp(tok_.begin, keyword, tok_.size) == 0;
+}
+
+void TextReader::expect_punct(char c)
+{
+    if (!is_punct(c)) {
+        error(std::string("expected '") + c + "'");
+    }
+    next();
+}
+
+void TextReader::expect_keyword(const char *keyword)
+{
+    if (!is_keyword(keyword)) {
+        error(std::string("expected '") + keyword + "'");
+    }
+    next();
+}
+
+std::string TextReader::name()
+{
+    if (tok_.kind != NAME && tok_.kind != STRING) {
+        error("expected name");
+    }
+    std::string s(tok_.begin, tok_.size);
+    next();
+    return s;
+}
+
+void TextReader::msg(MsgSig &msg)
+{
+    expect_punct('(');
+    while (!is_punct(')')) {
+        if (msg.num_payloads() > 0) {
+            expect_punct(',');
+        }
+        std::string type = name();
+        std::string payload_name;
+        if (tok_.kind == NAME || tok_.kind == STRING) {
+            payload_name = name();
+        }
+        MsgPayload payload(type, payload_name);
+        msg.add_payload(&payload);
+    }
+    next();
+}
+
+Node *TextReader::statement_head(bool &is_block)
+{
+    is_block = true;
+    if (is_punct('{')) {
+        next();
+        return new BlockNode();
+    }
+    if (is_keyword("rec")) {
+        next();
+        std::string label = name();
+        expect_punct('{');
+        return new RecurNode(label);
+    }
+    if (is_keyword("choice")) {
+        next();
+        std::string at;
+        bool has_at = is_keyword("at");
+        if (has_at) {
+            next();
+            at = name();
+        }
+        expect_punct('{');
+        return new ChoiceNode(has_at ? new Role(at) : nullptr);
+    }
+    if (is_keyword("par")) {
+        next();
+        expect_punct('{');
+        return new ParNode();
+    }
+    if (is_keyword("interruptible")) {
+        next();
+        std::string scope;
+        if (tok_.kind == NAME || tok_.kind == STRING) {
+            scope = name();
+        }
+        expect_punct('{');
+        return new InterruptibleNode(scope);
+    }
+
+    is_block = false;
+    if (is_keyword("continue")) {
+        next();
+        std::string label = name();
+        expect_punct(';');
+        return new ContinueNode(label);
+    }
+    if (is_keyword("do")) {
+        next();
+        std::string protocol = name();
+        std::string scope;
+        if (is_punct('@')) {
+            next();
+            scope = name();
+        }
+        std::unique_ptr<NestedNode> node(new NestedNode(protocol, scope));
+        if (is_punct('<')) {
+            next();
+            while (!is_punct('>')) {
+                if (node->num_args() > 0) {
+                    expect_punct(',');
+                }
+                std::unique_ptr<MsgSig> arg(new MsgSig(name()));
+                msg(*arg);
+                node->add_arg(arg.release());
+            }
+            next();
+        }
+        expect_punct('(');
+        while (!is_punct(')')) {
+            if (node->num_roleargs() > 0) {
+                expect_punct(',');
+            }
+            node->add_arg(new Role(name()));
+        }
+        next();
+        expect_punct(';');
+        return node.release();
+    }
+
+    MsgSig msgsig(name());
+    msg(msgsig);
+    std::unique_ptr<InteractionNode> node(new InteractionNode(&msgsig));
+    if (is_keyword("from")) {
+        next();
+        Role sndr(name());
+        node->set_sndr(&sndr);
+    }
+    if (is_keyword("to")) {
+        do {
+            next();
+            Role rcvr(name());
+            node->add_rcvr(&rcvr);
+        } while (is_punct(','));
+    }
+    expect_punct(';');
+    return node.release();
+}
+
+void TextReader::handlers(Node *node)
+{
+    auto *interruptible = static_cast<InterruptibleNode *>(node);
+    next(); // with
+    expect_punct('{');
+    while (!is_punct('}')) {
+        int kind = is_keyword("interrupt") ? 0 : is_keyword("throw") ? 1 : is_keyword("catch") ? 2 : -1;
+        if (kind < 0) {
+            error("expected 'interrupt', 'throw' or 'catch'");
+        }
+        next();
+        std::string role = name();
+        expect_punct(':');
+        std::unique_ptr<MsgSig> handler(new MsgSig(name()));
+        msg(*handler);
+        expect_punct(';');
+        switch (kind) {
+            case 0: interruptible->add_interrupt(new Role(role), handler.release()); break;
+            case 1: interruptible->add_throw(new Role(role), handler.release()); break;
+            case 2: interruptible->add_catch(new Role(role), handler.release()); break;
+        }
+    }
+    next();
+}
+
+Node *TextReader::read_statement()
+{
+    std::vector<BlockNode *> stack;
+    Node *root = nullptr;
+    try {
+        do {
+            if (!stack.empty() && is_punct('}')) {
+                next();
+                BlockNode *blk = stack.back();
+                stack.pop_back();
+                if (blk->type() == ST_NODE_INTERRUPTIBLE && is_keyword("with")) {
+                    handlers(blk);
+                }
+                continue;
+            }
+            if (tok_.kind == END) {
+                error("unexpected end of input");
+            }
+            bool is_block;
+            Node *node = statement_head(is_block);
+            if (stack.empty()) {
+                root = node;
+            } else {
+                stack.back()->append_child(node);
+            }
+            if (is_block) {
+                stack.push_back(static_cast<BlockNode *>(node));
+            }
+        } while (!stack.empty());
+    } catch (...) {
+        delete root;
+        throw;
+    }
+    return root;
+}
+
+Session *TextReader::read_session()
+{
+    bool local = is_keyword("local");
+    if (!local && !is_keyword("global")) {
+        error("expected 'global' or 'local'");
+    }
+    next();
+    expect_keyword("protocol");
+    std::unique_ptr<Session> session(new Session(name()));
+    std::string endpoint;
+    bool has_endpoint = is_keyword("at");
+    if (has_endpoint) {
+        next();
+        endpoint = name();
+    }
+    expect_punct('(');
+    while (!is_punct(')')) {
+        if (session->num_roles() > 0) {
+            expect_punct(',');
+        }
+        expect_keyword("role");
+        session->add_role(new Role(name()));
+    }
+    next();
+    if (is_punct(';')) {
+        next();
+    } else {
+        session->set_root(read_statement());
+    }
+    if (local) {
+        if (has_endpoint && !session->has_role(endpoint)) {
+            error("endpoint " + endpoint + " is not a role");
+        }
+        session->set_endpoint(has_endpoint ? session->role(endpoint) : nullptr);
+    }
+    return session.release();
+}
+
+Module *TextReader::read_module()
+{
+    expect_keyword("module");
+    std::unique_ptr<Module> module(new Module(name()));
+    expect_punct(';');
+    while (is_keyword("import")) {
+        next();
+        std::string import = name();
+        std::string from, as;
+        if (is_keyword("from")) {
+            next();
+            from = name();
+        }
+        if (is_keyword("as")) {
+            next();
+            as = name();
+        }
+        expect_punct(';');
+        module->add_import(new Import(import, from, as));
+    }
+    std::vector<Session *> sessions;
+    try {
+        while (!at_end()) {
+            sessions.push_back(read_session());
+            module->add_session(sessions.back());
+        }
+    } catch (...) {
+        for (Session *session : sessions) {
+            delete session;
+        }
+        throw;
+    }
+    return module.release();
+}
+
+Module *TextReader::read_module_file(std::string path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read " + path);
+    }
+    std::size_t size = st.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    Module *module;
+    try {
+        TextReader reader(static_cast<const char *>(data), size);
+        module = reader.read_module();
+    } catch (...) {
+        munmap(data, size);
+        throw;
+    }
+    munmap(data, size);
+    return module;
+}
+
+void TextReader::error(const std::string &what) const
+{
+    unsigned int line = 1, column = 1;
+    for (std::size_t i=0; i<tok_.offset && i<size_; i++) {
+        if (data_[i] == '\n') {
+            line++;
+            column = 1;
+        } else {
+            column++;
+        }
+    }
+    throw std::runtime_error("Syntax error at " + std::to_string(line) + ":"
+            + std::to_string(column) + ": " + what);
+}
+
+} // namespace util
+
+st_tree *st_tree_read_text(const char *text)
+{
+    try {
+        util::TextReader reader(text, std::strlen(text));
+        Session *session = reader.read_session();
+        if (!reader.at_end()) {
+            delete session;
+            return NULL;
+        }
+        return session;
+    } catch (std::runtime_error &) {
+        return NULL;
+    }
+}
+
+st_module *st_module_read_text_file(const char *path)
+{
+    try {
+        return util::TextReader::read_module_file(path);
+    } catch (std::runtime_error &) {
+        return NULL;
+    }
+}
+
+} // namespace sesstype
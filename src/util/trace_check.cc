@@ -0,0 +1,292 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include <sesstype/session.h>
+#include <sesstype/util/trace_check.h>
+
+namespace sesstype {
+namespace util {
+
+namespace {
+
+/// Bounds-checked reader of the trace header.
+class TraceReader {
+    const char *data_;
+    std::size_t size_;
+    std::size_t pos_;
+
+  public:
+    TraceReader(const char *data, std::size_t size)
+        : data_(data), size_(size), pos_(0) { }
+
+    std::size_t pos() const
+    {
+        return pos_;
+    }
+
+    std::uint32_t read_u32()
+    {
+        std::uint32_t value;
+        need(sizeof(value));
+        std::memcpy(&value, data_ + pos_, sizeof(value));
+        pos_ += sizeof(value);
+        return value;
+    }
+
+    std::string read_str()
+    {
+        std::uint32_t len = read_u32();
+        need(len);
+        std::string str(data_ + pos_, len);
+        pos_ += len;
+        return str;
+    }
+
+    std::vector<std::string> read_table()
+    {
+        std::uint32_t num = read_u32();
+        std::vector<std::string> table;
+        for (std::uint32_t i=0; i<num; i++) {
+            table.push_back(read_str());
+        }
+        return table;
+    }
+
+    void need(std::size_t len)
+    {
+        if (size_ - pos_ < len) {
+            throw std::runtime_error("Malformed trace: truncated header");
+        }
+    }
+};
+
+/// Monitor of one Role with its trace-to-action lookup table.
+struct RoleMonitor {
+    unsigned int result;
+    std::unique_ptr<Monitor> monitor;
+    std::vector<unsigned int> lookup; // [dir][peer][label] -> action
+    bool active;
+};
+
+} // namespace
+
+TraceChecker::TraceChecker(const Session *session)
+    : roles_(), fsms_(), results_(), num_threads_(0)
+{
+    for (auto it=session->role_begin(); it!=session->role_end(); it++) {
+        roles_.push_back(it->first);
+    }
+    std::sort(roles_.begin(), roles_.end());
+
+    for (auto &name : roles_) {
+        if (session->root() == nullptr) {
+            fsms_.emplace_back(new CFSM());
+            continue;
+        }
+        CFSM *fsm = CFSMBuilder::compile(session->root(), session->role(name));
+        if (fsm == nullptr) {
+            throw std::invalid_argument("Cannot compile Role " + name);
+        }
+        fsms_.emplace_back(fsm);
+    }
+}
+
+bool TraceChecker::check_file(std::string path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open trace " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read trace " + path);
+    }
+    std::size_t size = st.st_size;
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map trace " + path);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    bool ok;
+    try {
+        ok = check(static_cast<const char *>(data), size);
+    } catch (...) {
+        munmap(data, size);
+        throw;
+    }
+    munmap(data, size);
+    return ok;
+}
+
+bool TraceChecker::check(const char *data, std::size_t size)
+{
+    TraceReader reader(data, size);
+    reader.need(4);
+    if (std::memcmp(data, ST_TRACE_MAGIC, 4) != 0) {
+        throw std::runtime_error("Malformed trace: bad magic");
+    }
+    reader.read_u32(); // Magic.
+    if (reader.read_u32() != ST_TRACE_VERSION) {
+        throw std::runtime_error("Malformed trace: unsupported version");
+    }
+    std::vector<std::string> trace_roles = reader.read_table();
+    std::vector<std::string> trace_labels = reader.read_table();
+
+    const std::size_t event_size = 3 * sizeof(std::uint32_t);
+    const char *events = data + reader.pos();
+    if ((size - reader.pos()) % event_size != 0) {
+        throw std::runtime_error("Malformed trace: truncated event");
+    }
+    const std::size_t num_events = (size - reader.pos()) / event_size;
+    const std::uint32_t num_troles = trace_roles.size();
+    const std::uint32_t num_tlabels = trace_labels.size();
+
+    std::unordered_map<std::string, unsigned int> role_idx, label_idx;
+    for (unsigned int i=0; i<num_troles; i++) {
+        role_idx.insert({ trace_roles[i], i });
+    }
+    for (unsigned int i=0; i<num_tlabels; i++) {
+        label_idx.insert({ trace_labels[i], i });
+    }
+
+    results_.clear();
+    for (auto &name : roles_) {
+        results_.push_back(Result { name, -1, true });
+    }
+
+    unsigned int num_threads = num_threads_;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::max(1u, std::min<unsigned int>(num_threads, roles_.size()));
+
+    std::atomic<bool> malformed(false);
+    auto in_range = [&](const std::uint32_t *ev) {
+        return ev[0] < num_troles && ev[1] < num_troles && ev[2] < num_tlabels;
+    };
+    auto worker = [&](unsigned int tid) {
+        // Roles are partitioned round-robin between workers.
+        std::vector<RoleMonitor> monitors;
+        std::vector<int> owner(num_troles, -1);
+        for (unsigned int r=tid; r<roles_.size(); r+=num_threads) {
+            const CFSM &fsm = *fsms_[r];
+            RoleMonitor m { r, std::unique_ptr<Monitor>(new Monitor(fsm)),
+                std::vector<unsigned int>(2 * num_troles * num_tlabels, fsm.num_actions()), true };
+            for (unsigned int a=0; a<fsm.num_actions(); a++) {
+                auto peer = role_idx.find(fsm.peer(fsm.action(a).peer));
+                auto label = label_idx.find(fsm.label(fsm.action(a).label));
+                if (peer != role_idx.end() && label != label_idx.end()) {
+                    m.lookup[(fsm.action(a).dir * num_troles + peer->second) * num_tlabels + label->second] = a;
+                }
+            }
+            auto self = role_idx.find(roles_[r]);
+            if (self != role_idx.end()) {
+                owner[self->second] = monitors.size();
+            }
+            monitors.push_back(std::move(m));
+        }
+
+        unsigned int num_active = monitors.size();
+        std::size_t e = 0;
+        for (; e<num_events && num_active>0; e++) {
+            std::uint32_t ev[3];
+            std::memcpy(ev, events + e * event_size, event_size);
+            if (!in_range(ev)) {
+                malformed = true;
+                return;
+            }
+            const std::uint32_t peers[2] = { ev[1], ev[0] };
+            const std::uint32_t selves[2] = { ev[0], ev[1] };
+            for (unsigned int dir=ST_CFSM_SEND; dir<=ST_CFSM_RECV; dir++) {
+                int slot = owner[selves[dir]];
+                if (slot < 0 || !monitors[slot].active) continue;
+                RoleMonitor &m = monitors[slot];
+                if (!m.monitor->step(m.lookup[(dir * num_troles + peers[dir]) * num_tlabels + ev[2]])) {
+                    results_[m.result].violation = e;
+                    results_[m.result].complete = false;
+                    m.active = false;
+                    num_active--;
+                }
+            }
+        }
+
+        // Once its monitors have stopped, a worker still checks that events
+        // are in range, but only in its share of the blocks of events. Every
+        // event is checked by the worker owning its block, whether or not
+        // that worker is still monitoring.
+        const std::size_t block = 4096;
+        for (std::size_t b=e/block; b*block<num_events && !malformed; b++) {
+            if (b % num_threads != tid) continue;
+            std::size_t end = std::min(num_events, (b + 1) * block);
+            for (std::size_t i=std::max(e, b * block); i<end; i++) {
+                std::uint32_t ev[3];
+                std::memcpy(ev, events + i * event_size, event_size);
+                if (!in_range(ev)) {
+                    malformed = true;
+                    return;
+                }
+            }
+        }
+
+        for (auto &m : monitors) {
+            if (m.active) {
+                results_[m.result].complete = m.monitor->is_final();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t=1; t<num_threads; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (malformed) {
+        throw std::runtime_error("Malformed trace: event out of range");
+    }
+
+    for (auto &result : results_) {
+        if (result.violation >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace util
+
+int st_tree_check_trace(st_tree *tree, const char *path)
+{
+    try {
+        util::TraceChecker checker(tree);
+        checker.check_file(path);
+        int num_violations = 0;
+        for (auto &result : checker.results()) {
+            if (result.violation >= 0) {
+                num_violations++;
+            }
+        }
+        return num_violations;
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return -1;
+    }
+}
+
+} // namespace sesstype
@@ -5,6 +5,7 @@
 
 #include "gtest/gtest.h"
 
+#include <sstream>
 #include <string>
 
 #include <sesstype/sesstype.h>
@@ -27,6 +28,85 @@ TEST_F(APITest, BasicUsage)
     EXPECT_STREQ(name, "default");
 }
 
+/**
+ * \test Bulk construction gives the same tree as per-node construction.
+ */
+TEST_F(APITest, BulkConstruction)
+{
+    // rec T { choice at A { { L(int x) from A to B, C; continue T; } { Q() from A to B; } } }
+    st_tree *tree = st_tree_mk_init("P");
+    st_tree_add_role(tree, st_role_init("A"));
+    st_tree_add_role(tree, st_role_init("B"));
+    st_tree_add_role(tree, st_role_init("C"));
+    st_node *root = new BlockNode();
+    st_node *recur = st_mk_recur_node(const_cast<char *>("T"));
+    st_node *choice = st_mk_choice_node(st_role_init("A"));
+    st_node *branch0 = new BlockNode();
+    st_msg *msg = new MsgSig("L");
+    MsgPayload payload("int", "x");
+    st_msg_add_payload(msg, &payload);
+    st_node *interaction = st_mk_interaction_node(msg);
+    st_msg_free(msg);
+    st_interaction_node_set_from(interaction, tree->role("A"));
+    st_interaction_node_add_to(interaction, tree->role("B"));
+    st_interaction_node_add_to(interaction, tree->role("C"));
+    st_node_append_child(branch0, interaction);
+    st_node_append_child(branch0, st_mk_continue_node(const_cast<char *>("T")));
+    st_node *branch1 = new BlockNode();
+    msg = new MsgSig("Q");
+    interaction = st_mk_interaction_node(msg);
+    st_msg_free(msg);
+    st_interaction_node_set_from(interaction, tree->role("A"));
+    st_interaction_node_add_to(interaction, tree->role("B"));
+    st_node_append_child(branch1, interaction);
+    st_node_append_child(choice, branch0);
+    st_node_append_child(choice, branch1);
+    st_node_append_child(recur, choice);
+    st_node_append_child(root, recur);
+    st_tree_set_root(tree, root);
+
+    const char *role_names[] = { "A", "B", "C" };
+    const char *label_names[] = { "T", "L", "Q" };
+    const unsigned int msg_labels[] = { 1, 2 };
+    const unsigned int payload_offsets[] = { 0, 1, 1 };
+    const char *payload_types[] = { "int" };
+    const char *payload_names[] = { "x" };
+    const unsigned int kinds[] = { ST_NODE_ROOT, ST_NODE_RECUR, ST_NODE_CHOICE,
+        ST_NODE_ROOT, ST_NODE_SENDRECV, ST_NODE_CONTINUE, ST_NODE_ROOT, ST_NODE_SENDRECV };
+    const int parents[] = { -1, 0, 1, 2, 3, 3, 2, 6 };
+    const int roles[] = { -1, -1, 0, -1, 0, -1, -1, 0 };
+    const unsigned int args[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    const unsigned int rcvr_offsets[] = { 0, 0, 0, 0, 0, 2, 2, 2, 3 };
+    const unsigned int rcvrs[] = { 1, 2, 1 };
+    st_tree_bulk desc = {
+        "P", 3, role_names, 3, label_names,
+        2, msg_labels, payload_offsets, payload_types, payload_names,
+        8, kinds, parents, roles, args, rcvr_offsets, rcvrs,
+    };
+    st_tree *bulk = st_tree_mk_bulk(&desc);
+    ASSERT_NE(bulk, nullptr);
+
+    std::stringstream expected, actual;
+    {
+        util::OutputBuffer expected_buf(expected), actual_buf(actual);
+        util::TextExport(expected_buf).write(*tree);
+        util::TextExport(actual_buf).write(*bulk);
+    }
+    EXPECT_EQ(actual.str(), expected.str());
+
+    // Malformed descriptions are rejected.
+    const int bad_parents[] = { -1, 0, 1, 2, 3, 3, 2, 5 }; // Parent is a continue.
+    desc.parents = bad_parents;
+    EXPECT_EQ(st_tree_mk_bulk(&desc), nullptr);
+    desc.parents = parents;
+    const unsigned int bad_rcvrs[] = { 1, 3, 1 };
+    desc.rcvrs = bad_rcvrs;
+    EXPECT_EQ(st_tree_mk_bulk(&desc), nullptr);
+
+    st_tree_free(tree);
+    st_tree_free(bulk);
+}
+
 } // namespace tests
 } // namespace sesstype
 
@@ -5,9 +5,25 @@
 
 #include "gtest/gtest.h"
 
+#include <map>
+#include <sstream>
 #include <string>
 
 #include "sesstype/parameterised/const.h"
+#include "sesstype/parameterised/expr/add.h"
+#include "sesstype/parameterised/expr/mul.h"
+#include "sesstype/parameterised/expr/rng.h"
+#include "sesstype/parameterised/expr/sub.h"
+#include "sesstype/parameterised/expr/val.h"
+#include "sesstype/parameterised/expr/var.h"
+#include "sesstype/parameterised/module.h"
+#include "sesstype/parameterised/msg.h"
+#include "sesstype/parameterised/nodes.h"
+#include "sesstype/parameterised/role.h"
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/expr_print.h"
+#include "sesstype/parameterised/util/msg_count.h"
+#include "sesstype/parameterised/util/specialise.h"
 
 namespace sesstype {
 namespace tests {
@@ -45,6 +61,273 @@ TEST_F(ConstantTest, BasicConsts)
     delete inf;
 }
 
+/**
+ * \test Specialise a Session with ValueConstants.
+ */
+TEST_F(ConstantTest, Specialise)
+{
+    using sesstype::parameterised::AddExpr;
+    using sesstype::parameterised::BlockNode;
+    using sesstype::parameterised::ForNode;
+    using sesstype::parameterised::InteractionNode;
+    using sesstype::parameterised::Module;
+    using sesstype::parameterised::MsgPayload;
+    using sesstype::parameterised::MsgSig;
+    using sesstype::parameterised::MulExpr;
+    using sesstype::parameterised::RngExpr;
+    using sesstype::parameterised::Role;
+    using sesstype::parameterised::ScalableConstant;
+    using sesstype::parameterised::Session;
+    using sesstype::parameterised::SubExpr;
+    using sesstype::parameterised::ValExpr;
+    using sesstype::parameterised::ValueConstant;
+    using sesstype::parameterised::VarExpr;
+
+    // global protocol P(role W[1..N]) {
+    //   foreach (i:1..N-1) { M(int[N*2]) from W[i] to W[i+1]; }
+    //   foreach (N:0..1) { X() from W[N] to W[N+1]; }
+    // }
+    Module module("M");
+    module.add_constant(new ValueConstant("N", 4));
+    module.add_constant(new ScalableConstant("K", 1));
+
+    Session session("P");
+    auto *w = new Role("W");
+    w->add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    session.add_role(w);
+
+    auto *root = new BlockNode();
+    auto *loop = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1))));
+    MsgSig msg("M");
+    MsgPayload payload("int");
+    payload.add_param(new MulExpr(new VarExpr("N"), new ValExpr(2)));
+    msg.add_payload(&payload);
+    auto *interaction = new InteractionNode(&msg);
+    Role sndr("W"), rcvr("W");
+    sndr.add_param(new VarExpr("i"));
+    rcvr.add_param(new AddExpr(new VarExpr("i"), new ValExpr(1)));
+    interaction->set_sndr(&sndr);
+    interaction->add_rcvr(&rcvr);
+    loop->append_child(interaction);
+    root->append_child(loop);
+
+    // Loop variable named N shadows the constant.
+    auto *shadow = new ForNode(new RngExpr("N", new ValExpr(0), new ValExpr(1)));
+    MsgSig msg_x("X");
+    auto *interaction_x = new InteractionNode(&msg_x);
+    Role sndr_x("W");
+    sndr_x.add_param(new VarExpr("N"));
+    interaction_x->set_sndr(&sndr_x);
+    shadow->append_child(interaction_x);
+    root->append_child(shadow);
+    session.set_root(root);
+
+    Session *specialised = sesstype::parameterised::util::specialise(session, module);
+
+    auto *w_range = dynamic_cast<RngExpr *>((*specialised->role("W"))[0]);
+    ASSERT_NE(w_range, nullptr);
+    ASSERT_EQ(w_range->to()->type(), ST_EXPR_CONST);
+    EXPECT_EQ(dynamic_cast<ValExpr *>(w_range->to())->num(), 4);
+
+    auto *s_root = dynamic_cast<BlockNode *>(specialised->root());
+    ASSERT_EQ(s_root->num_children(), 2);
+    auto *s_loop = dynamic_cast<ForNode *>(s_root->child(0));
+    ASSERT_NE(s_loop, nullptr);
+    EXPECT_EQ(s_loop->bindexpr()->bindvar(), "i");
+    ASSERT_EQ(s_loop->bindexpr()->to()->type(), ST_EXPR_CONST);
+    EXPECT_EQ(dynamic_cast<ValExpr *>(s_loop->bindexpr()->to())->num(), 3);
+
+    ASSERT_EQ(s_loop->num_children(), 1);
+    auto *s_interaction = dynamic_cast<InteractionNode *>(s_loop->child(0));
+    ASSERT_NE(s_interaction, nullptr);
+    auto *s_payload = dynamic_cast<MsgPayload *>(s_interaction->msg()->payload(0));
+    ASSERT_NE(s_payload, nullptr);
+    ASSERT_EQ((*s_payload)[0]->type(), ST_EXPR_CONST);
+    EXPECT_EQ(dynamic_cast<ValExpr *>((*s_payload)[0])->num(), 8);
+    EXPECT_EQ((*s_interaction->sndr())[0]->type(), ST_EXPR_VAR);
+
+    auto *s_shadow = dynamic_cast<ForNode *>(s_root->child(1));
+    ASSERT_NE(s_shadow, nullptr);
+    auto *s_interaction_x = dynamic_cast<InteractionNode *>(s_shadow->child(0));
+    ASSERT_NE(s_interaction_x, nullptr);
+    EXPECT_EQ((*s_interaction_x->sndr())[0]->type(), ST_EXPR_VAR);
+
+    // The original Session is unchanged.
+    EXPECT_EQ(dynamic_cast<RngExpr *>((*session.role("W"))[0])->to()->type(), ST_EXPR_VAR);
+    EXPECT_EQ(loop->bindexpr()->to()->type(), ST_EXPR_SUB);
+
+    delete specialised;
+}
+
+/**
+ * \test Closed-form message and byte counts of a parameterised Session.
+ */
+TEST_F(ConstantTest, MessageCount)
+{
+    using sesstype::parameterised::AddExpr;
+    using sesstype::parameterised::BlockNode;
+    using sesstype::parameterised::ChoiceNode;
+    using sesstype::parameterised::Expr;
+    using sesstype::parameterised::ForNode;
+    using sesstype::parameterised::InteractionNode;
+    using sesstype::parameterised::MsgPayload;
+    using sesstype::parameterised::MsgSig;
+    using sesstype::parameterised::RngExpr;
+    using sesstype::parameterised::Role;
+    using sesstype::parameterised::Session;
+    using sesstype::parameterised::SubExpr;
+    using sesstype::parameterised::ValExpr;
+    using sesstype::parameterised::VarExpr;
+    using sesstype::parameterised::util::ExprPrintVisitor;
+    using sesstype::parameterised::util::MsgCount;
+    using sesstype::parameterised::util::TypeSizeTable;
+
+    // global protocol P(role M, role W[1..N]) {
+    //   Data(int[N], Matrix) from M to W[1..N];
+    //   foreach (i:1..N-1) { Ring(double) from W[i] to W[i+1]; }
+    //   foreach (i:1..N) { foreach (j:i..N) { Tri(int) from W[i] to W[j]; } }
+    //   Res(long) from W[1..N] to M;
+    // }
+    Session session("P");
+    session.add_role(new Role("M"));
+    auto *w = new Role("W");
+    w->add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    session.add_role(w);
+    auto *root = new BlockNode();
+
+    MsgSig data("Data");
+    MsgPayload data_array("int"), data_matrix("Matrix");
+    data_array.add_param(new VarExpr("N"));
+    data.add_payload(&data_array);
+    data.add_payload(&data_matrix);
+    auto *scatter = new InteractionNode(&data);
+    Role m("M"), w_all("W");
+    w_all.add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    scatter->set_sndr(&m);
+    scatter->add_rcvr(&w_all);
+    root->append_child(scatter);
+
+    auto *ring_loop = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1))));
+    MsgSig ring("Ring");
+    MsgPayload ring_payload("double");
+    ring.add_payload(&ring_payload);
+    auto *ring_interaction = new InteractionNode(&ring);
+    Role w_i("W"), w_next("W");
+    w_i.add_param(new VarExpr("i"));
+    w_next.add_param(new AddExpr(new VarExpr("i"), new ValExpr(1)));
+    ring_interaction->set_sndr(&w_i);
+    ring_interaction->add_rcvr(&w_next);
+    ring_loop->append_child(ring_interaction);
+    root->append_child(ring_loop);
+
+    auto *outer = new ForNode(new RngExpr("i", new ValExpr(1), new VarExpr("N")));
+    auto *inner = new ForNode(new RngExpr("j", new VarExpr("i"), new VarExpr("N")));
+    MsgSig tri("Tri");
+    MsgPayload tri_payload("int");
+    tri.add_payload(&tri_payload);
+    auto *tri_interaction = new InteractionNode(&tri);
+    Role w_j("W");
+    w_j.add_param(new VarExpr("j"));
+    tri_interaction->set_sndr(&w_i);
+    tri_interaction->add_rcvr(&w_j);
+    inner->append_child(tri_interaction);
+    outer->append_child(inner);
+    root->append_child(outer);
+
+    MsgSig res("Res");
+    MsgPayload res_payload("long");
+    res.add_payload(&res_payload);
+    auto *gather = new InteractionNode(&res);
+    gather->set_sndr(&w_all);
+    gather->add_rcvr(&m);
+    root->append_child(gather);
+    session.set_root(root);
+
+    TypeSizeTable sizes;
+    MsgCount count(sizes);
+    count.analyse(session);
+    EXPECT_TRUE(count.is_valid());
+    EXPECT_TRUE(count.is_exact());
+    ASSERT_EQ(count.roles().size(), 2);
+    ASSERT_EQ(count.unknown_types().size(), 1);
+    EXPECT_EQ(*count.unknown_types().begin(), "Matrix");
+
+    auto print = [](Expr *expr) {
+        std::stringstream ss;
+        ExprPrintVisitor printer(ss);
+        expr->accept(printer);
+        delete expr;
+        return ss.str();
+    };
+    EXPECT_EQ(print(count.sent("M")), "N");
+    EXPECT_EQ(print(count.sent_bytes("M")), "4*N*N");
+    EXPECT_EQ(print(count.received("M")), "N");
+    EXPECT_EQ(print(count.received_bytes("M")), "8*N");
+    EXPECT_EQ(print(count.sent("X")), "0");
+
+    // Counts agree with the unrolled protocol for any N.
+    for (long n=1; n<=8; n++) {
+        long w_sent = (n - 1) + n * (n + 1) / 2 + n;
+        long w_sent_bytes = 8 * (n - 1) + 4 * n * (n + 1) / 2 + 8 * n;
+        long w_received = n + (n - 1) + n * (n + 1) / 2;
+        long value;
+        Expr *expr = count.sent("W");
+        ASSERT_TRUE(MsgCount::evaluate(expr, { { "N", n } }, value));
+        EXPECT_EQ(value, w_sent);
+        delete expr;
+        expr = count.sent_bytes("W");
+        ASSERT_TRUE(MsgCount::evaluate(expr, { { "N", n } }, value));
+        EXPECT_EQ(value, w_sent_bytes);
+        delete expr;
+        expr = count.received("W");
+        ASSERT_TRUE(MsgCount::evaluate(expr, { { "N", n } }, value));
+        EXPECT_EQ(value, w_received);
+        delete expr;
+    }
+
+    // A custom payload size, and over-approximation of a choice.
+    sizes.set_size("Matrix", 64);
+    auto *choice = new ChoiceNode(m.clone());
+    choice->append_child(scatter->clone());
+    root->append_child(choice);
+    MsgCount sized(sizes);
+    sized.analyse(session);
+    EXPECT_TRUE(sized.unknown_types().empty());
+    EXPECT_FALSE(sized.is_exact());
+    EXPECT_EQ(print(sized.sent_bytes("M")), "(8*N*N+128*N)");
+
+    // foreach (i:1..N) { foreach (j:i..N) { foreach (k:j..N) { Tet() from A to B; } } }
+    Session nested("T");
+    nested.add_role(new Role("A"));
+    nested.add_role(new Role("B"));
+    auto *nested_root = new BlockNode();
+    auto *loop_i = new ForNode(new RngExpr("i", new ValExpr(1), new VarExpr("N")));
+    auto *loop_j = new ForNode(new RngExpr("j", new VarExpr("i"), new VarExpr("N")));
+    auto *loop_k = new ForNode(new RngExpr("k", new VarExpr("j"), new VarExpr("N")));
+    MsgSig tet("Tet");
+    auto *tet_interaction = new InteractionNode(&tet);
+    Role a("A"), b("B");
+    tet_interaction->set_sndr(&a);
+    tet_interaction->add_rcvr(&b);
+    loop_k->append_child(tet_interaction);
+    loop_j->append_child(loop_k);
+    loop_i->append_child(loop_j);
+    nested_root->append_child(loop_i);
+    nested.set_root(nested_root);
+
+    MsgCount tetrahedral;
+    tetrahedral.analyse(nested);
+    EXPECT_TRUE(tetrahedral.is_valid());
+    EXPECT_TRUE(tetrahedral.is_exact());
+    for (long n=1; n<=10; n++) {
+        long value;
+        Expr *expr = tetrahedral.sent("A");
+        ASSERT_TRUE(MsgCount::evaluate(expr, { { "N", n } }, value));
+        EXPECT_EQ(value, n * (n + 1) * (n + 2) / 6);
+        delete expr;
+    }
+}
+
 } // namespace tests
 } // namespace sesstype
 
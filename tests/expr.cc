@@ -6,6 +6,7 @@
 #include "gtest/gtest.h"
 
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "sesstype/parameterised/expr.h"
@@ -22,9 +23,12 @@
 #include "sesstype/parameterised/expr/rng.h"
 #include "sesstype/parameterised/expr/log.h"
 #include "sesstype/parameterised/util/expr_apply.h"
+#include "sesstype/parameterised/util/expr_canon.h"
 #include "sesstype/parameterised/util/expr_eval.h"
 #include "sesstype/parameterised/util/expr_invert.h"
+#include "sesstype/parameterised/util/expr_print.h"
 #include "sesstype/parameterised/util/print.h"
+#include "sesstype/parameterised/util/range_set.h"
 #include "sesstype/parameterised/util/empty_visitor.h"
 
 namespace sesstype {
@@ -273,6 +277,74 @@ TEST_F(ExprTest, InvertExpr)
     delete inverted;
 }
 
+/**
+ * \test Expression inversion of composed, shifted and modular maps.
+ */
+TEST_F(ExprTest, InvertIndexMaps)
+{
+    auto invert = [](util::ExprInvert &inverter, Expr *expr) {
+        expr->accept(inverter);
+        Expr *inverted = inverter.invert();
+        std::string s = "(null)";
+        if (inverted != nullptr) {
+            std::stringstream ss;
+            util::ExprPrintVisitor printer(ss);
+            inverted->accept(printer);
+            s = ss.str();
+        }
+        delete expr;
+        return s;
+    };
+
+    // 3*(i+1) --> i/3-1
+    util::ExprInvert inv_mul("i");
+    EXPECT_EQ(invert(inv_mul, new MulExpr(new ValExpr(3), new AddExpr(new VarExpr("i"), new ValExpr(1)))), "(i/3-1)");
+    // i >> 2 --> 4*i
+    util::ExprInvert inv_shr("i");
+    EXPECT_EQ(invert(inv_shr, new ShrExpr(new VarExpr("i"), new ValExpr(2))), "4*i");
+    // 2*i-i+3 --> i-3
+    util::ExprInvert inv_affine("i");
+    EXPECT_EQ(invert(inv_affine, new AddExpr(
+                    new SubExpr(new MulExpr(new ValExpr(2), new VarExpr("i")), new VarExpr("i")),
+                    new ValExpr(3))), "(i-3)");
+    // i*i is not affine.
+    util::ExprInvert inv_square("i");
+    EXPECT_EQ(invert(inv_square, new MulExpr(new VarExpr("i"), new VarExpr("i"))), "(null)");
+    // (i+1)%N needs the range of i.
+    util::ExprInvert inv_mod("i");
+    EXPECT_EQ(invert(inv_mod, new ModExpr(new AddExpr(new VarExpr("i"), new ValExpr(1)), new VarExpr("N"))), "(null)");
+    // i:0..N spans more than one period.
+    RngExpr wide("i", new ValExpr(0), new VarExpr("N"));
+    util::ExprInvert inv_wide(&wide);
+    EXPECT_EQ(invert(inv_wide, new ModExpr(new AddExpr(new VarExpr("i"), new ValExpr(1)), new VarExpr("N"))), "(null)");
+
+    // Ring neighbour (i+1)%N with i:0..N-1 --> (N+(i-1)%N)%N
+    RngExpr ring("i", new ValExpr(0), new SubExpr(new VarExpr("N"), new ValExpr(1)));
+    util::ExprInvert inv_ring(&ring);
+    auto ring_expr = new ModExpr(new AddExpr(new VarExpr("i"), new ValExpr(1)), new VarExpr("N"));
+    ring_expr->accept(inv_ring);
+    Expr *ring_inverted = inv_ring.invert();
+    ASSERT_NE(ring_inverted, nullptr);
+    std::stringstream ring_ss;
+    util::ExprPrintVisitor ring_printer(ring_ss);
+    ring_inverted->accept(ring_printer);
+    EXPECT_EQ(ring_ss.str(), "(N+(i-1)%N)%N");
+    for (long y=0; y<5; y++) {
+        util::ExprCanon forward({ { "N", 5 } }), backward({ { "i", y }, { "N", 5 } });
+        ring_inverted->accept(backward);
+        Expr *x = backward.canon();
+        ASSERT_EQ(x->type(), ST_EXPR_CONST);
+        ModExpr check(new AddExpr(x, new ValExpr(1)), new VarExpr("N"));
+        check.accept(forward);
+        Expr *fx = forward.canon();
+        ASSERT_EQ(fx->type(), ST_EXPR_CONST);
+        EXPECT_EQ(dynamic_cast<ValExpr *>(fx)->num(), y);
+        delete fx;
+    }
+    delete ring_expr;
+    delete ring_inverted;
+}
+
 /**
  * \test Expression apply.
  */
@@ -296,6 +368,125 @@ TEST_F(ExprTest, ApplyExpr)
     delete applied;
 }
 
+/**
+ * \test Expression canonical form.
+ */
+TEST_F(ExprTest, CanonExpr)
+{
+    auto canon = [](Expr *expr) {
+        util::ExprCanon canon;
+        expr->accept(canon);
+        Expr *canonical = canon.canon();
+        std::stringstream ss;
+        util::ExprPrintVisitor printer(ss);
+        canonical->accept(printer);
+        delete canonical;
+        delete expr;
+        return ss.str();
+    };
+
+    // (i+1)+1 --> i+2
+    EXPECT_EQ(canon(new AddExpr(new AddExpr(new VarExpr("i"), new ValExpr(1)), new ValExpr(1))), "(i+2)");
+    // i-i --> 0
+    EXPECT_EQ(canon(new SubExpr(new VarExpr("i"), new VarExpr("i"))), "0");
+    // 2*(i+N)-N --> N+2*i
+    EXPECT_EQ(canon(new SubExpr(
+                    new MulExpr(new ValExpr(2), new AddExpr(new VarExpr("i"), new VarExpr("N"))),
+                    new VarExpr("N"))), "(N+2*i)");
+    // i+N and N+i --> N+i
+    EXPECT_EQ(canon(new AddExpr(new VarExpr("i"), new VarExpr("N"))), "(N+i)");
+    EXPECT_EQ(canon(new AddExpr(new VarExpr("N"), new VarExpr("i"))), "(N+i)");
+    // (N-1)*(N+1) --> N*N-1
+    EXPECT_EQ(canon(new MulExpr(
+                    new SubExpr(new VarExpr("N"), new ValExpr(1)),
+                    new AddExpr(new VarExpr("N"), new ValExpr(1)))), "(N*N-1)");
+    // 1-i --> -1*i+1
+    EXPECT_EQ(canon(new SubExpr(new ValExpr(1), new VarExpr("i"))), "(-1*i+1)");
+    // (2*i+4)/2 --> i+2, (i+1)/2 is kept.
+    EXPECT_EQ(canon(new DivExpr(
+                    new AddExpr(new MulExpr(new ValExpr(2), new VarExpr("i")), new ValExpr(4)),
+                    new ValExpr(2))), "(i+2)");
+    EXPECT_EQ(canon(new DivExpr(new AddExpr(new ValExpr(1), new VarExpr("i")), new ValExpr(2))), "(i+1)/2");
+    // (i+i)%2 --> 0, i<<2 --> 4*i
+    EXPECT_EQ(canon(new ModExpr(new AddExpr(new VarExpr("i"), new VarExpr("i")), new ValExpr(2))), "0");
+    EXPECT_EQ(canon(new ShlExpr(new VarExpr("i"), new ValExpr(2))), "4*i");
+    // i:1+1..N-1+1 --> i:2..N
+    EXPECT_EQ(canon(new RngExpr("i",
+                    new AddExpr(new ValExpr(1), new ValExpr(1)),
+                    new AddExpr(new SubExpr(new VarExpr("N"), new ValExpr(1)), new ValExpr(1)))), "i2..N");
+
+    // Identity modulo canonical form, including opaque subexpressions.
+    auto e0 = new AddExpr(new MulExpr(new VarExpr("i"), new ValExpr(2)), new DivExpr(new VarExpr("N"), new ValExpr(3)));
+    auto e1 = new AddExpr(new DivExpr(new VarExpr("N"), new ValExpr(3)), new ShlExpr(new VarExpr("i"), new ValExpr(1)));
+    auto e2 = new AddExpr(new VarExpr("i"), new DivExpr(new VarExpr("N"), new ValExpr(3)));
+    EXPECT_TRUE(st_expr_is_identical(e0, e1));
+    EXPECT_FALSE(st_expr_is_identical(e0, e2));
+    delete e0;
+    delete e1;
+    delete e2;
+}
+
+/**
+ * \test Range set algebra.
+ */
+TEST_F(ExprTest, RangeSet)
+{
+    using util::RangeSet;
+
+    // i:1..N-1 with N=8 and 2,4,..,10.
+    auto rng = new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1)));
+    RangeSet symbolic(rng);
+    EXPECT_FALSE(symbolic.is_valid());
+    RangeSet a(rng, { { "N", 8 } });
+    ASSERT_TRUE(a.is_valid());
+    EXPECT_EQ(a, RangeSet::range(1, 7));
+    delete rng;
+    RangeSet b = RangeSet::strided(2, 10, 2);
+    EXPECT_EQ(b.size(), 5);
+    EXPECT_TRUE(b.contains(10));
+    EXPECT_FALSE(b.contains(3));
+
+    EXPECT_EQ(a | b, RangeSet::range(1, 8) | RangeSet::range(10, 10));
+    EXPECT_EQ((a | b).num_intervals(), 2);
+    EXPECT_EQ(a & b, RangeSet::strided(2, 6, 2));
+    EXPECT_EQ((a - b).size(), 4);
+    EXPECT_EQ(a - b, RangeSet::strided(1, 7, 2));
+    EXPECT_EQ(b - a, RangeSet::range(8, 8) | RangeSet::range(10, 10));
+    EXPECT_TRUE((a - a).empty());
+    EXPECT_TRUE((a & b).is_subset(a));
+    EXPECT_FALSE(b.is_subset(a));
+    EXPECT_TRUE(RangeSet::range(3, 1).empty());
+    EXPECT_THROW(RangeSet::strided(0, 1, 0), std::invalid_argument);
+    EXPECT_THROW(RangeSet::strided(0, 1L << 40, 2), std::length_error);
+    EXPECT_EQ(RangeSet::strided(0, 1L << 40, 1L << 30).size(), 1025);
+    EXPECT_EQ(RangeSet::strided(-3, 3, 3),
+              RangeSet::range(-3, -3) | RangeSet::range(0, 0) | RangeSet::range(3, 3));
+
+    // Normal form is independent of how the set was built.
+    auto seq = new SeqExpr();
+    for (int v : { 5, 3, 4, 9, 3 }) {
+        seq->append_value(v);
+    }
+    RangeSet c(seq);
+    delete seq;
+    EXPECT_EQ(c, RangeSet::range(3, 5) | RangeSet::range(9, 9));
+    EXPECT_EQ(c.size(), 4);
+
+    auto exprs = (c | RangeSet::range(11, 11)).to_exprs("j");
+    ASSERT_EQ(exprs.size(), 2);
+    auto *rng_expr = dynamic_cast<RngExpr *>(exprs[0]);
+    ASSERT_NE(rng_expr, nullptr);
+    EXPECT_EQ(rng_expr->bindvar(), "j");
+    EXPECT_EQ(dynamic_cast<ValExpr *>(rng_expr->from())->num(), 3);
+    EXPECT_EQ(dynamic_cast<ValExpr *>(rng_expr->to())->num(), 5);
+    auto *seq_expr = dynamic_cast<SeqExpr *>(exprs[1]);
+    ASSERT_NE(seq_expr, nullptr);
+    EXPECT_EQ(seq_expr->num_values(), 2);
+    for (auto expr : exprs) {
+        delete expr;
+    }
+}
+
 TEST_F(ExprTest, CloneExpr)
 {
     util::EmptyVisitor v;
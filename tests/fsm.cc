@@ -0,0 +1,733 @@
+/**
+ * \file test/fsm.cc
+ * \brief Tests for sesstype::util::CFSM.
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "sesstype/role.h"
+#include "sesstype/session.h"
+#include "sesstype/util.h"
+
+#include "sesstype/node.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/node/continue.h"
+#include "sesstype/node/par.h"
+#include "sesstype/util/bind_recur.h"
+#include "sesstype/util/cfsm.h"
+#include "sesstype/util/channel_bounds.h"
+#include "sesstype/util/explore.h"
+#include "sesstype/util/monitor.h"
+#include "sesstype/util/trace_check.h"
+#include "sesstype/util/graph_export.h"
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/graph_export.h"
+
+namespace sesstype {
+namespace tests {
+
+class FSMTest : public ::testing::Test {
+  protected:
+    FSMTest() {}
+
+    static InteractionNode *interaction(std::string label, Role *from, Role *to)
+    {
+        auto *node = new InteractionNode(new MsgSig(label));
+        node->set_sndr(from);
+        node->add_rcvr(to);
+        return node;
+    }
+
+    static util::CFSM *build(Node *root, Role *endpoint)
+    {
+        return util::CFSMBuilder::compile(root, endpoint);
+    }
+
+    static InteractionNode *send(std::string label, Role *to)
+    {
+        auto *node = new InteractionNode(new MsgSig(label));
+        node->add_rcvr(to);
+        return node;
+    }
+
+    static InteractionNode *recv(std::string label, Role *from)
+    {
+        auto *node = new InteractionNode(new MsgSig(label));
+        node->set_sndr(from);
+        return node;
+    }
+
+    static util::CFSM *compile(Node *local)
+    {
+        util::CFSMBuilder builder;
+        local->accept(builder);
+        return builder.build();
+    }
+
+    static void put_u32(std::string &buf, std::uint32_t value)
+    {
+        buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    static void put_str(std::string &buf, std::string str)
+    {
+        put_u32(buf, str.size());
+        buf.append(str);
+    }
+};
+
+/**
+ * \test CFSM of a recursive choice.
+ */
+TEST_F(FSMTest, RecurChoice)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+
+    // rec L { choice at A { A->B: More(); continue L; } or { A->B: Done(); } }
+    auto *root = new BlockNode();
+    auto *recur = new RecurNode("L");
+    auto *choice = new ChoiceNode(new Role("A"));
+    auto *more = new BlockNode();
+    more->append_child(interaction("More", A, B));
+    more->append_child(new ContinueNode("L"));
+    auto *done = new BlockNode();
+    done->append_child(interaction("Done", A, B));
+    choice->append_child(more);
+    choice->append_child(done);
+    recur->append_child(choice);
+    root->append_child(recur);
+
+    auto *fsm_a = build(root, A);
+    ASSERT_NE(fsm_a, nullptr);
+    EXPECT_EQ(fsm_a->num_states(), 2);
+    EXPECT_EQ(fsm_a->num_transitions(), 2);
+    int more_a = fsm_a->find_action(ST_CFSM_SEND, "B", "More");
+    int done_a = fsm_a->find_action(ST_CFSM_SEND, "B", "Done");
+    ASSERT_GE(more_a, 0);
+    ASSERT_GE(done_a, 0);
+    EXPECT_EQ(fsm_a->find_action(ST_CFSM_RECV, "B", "More"), -1);
+    EXPECT_EQ(fsm_a->next(fsm_a->initial(), more_a), fsm_a->initial());
+    int end = fsm_a->next(fsm_a->initial(), done_a);
+    ASSERT_GE(end, 0);
+    EXPECT_TRUE(fsm_a->is_final(end));
+    EXPECT_FALSE(fsm_a->is_final(fsm_a->initial()));
+    EXPECT_EQ(fsm_a->num_transitions(end), 0);
+
+    auto *fsm_b = build(root, B);
+    ASSERT_NE(fsm_b, nullptr);
+    EXPECT_EQ(fsm_b->num_states(), 2);
+    int more_b = fsm_b->find_action(ST_CFSM_RECV, "A", "More");
+    ASSERT_GE(more_b, 0);
+    EXPECT_EQ(fsm_b->next(fsm_b->initial(), more_b), fsm_b->initial());
+    EXPECT_EQ(fsm_b->peer(fsm_b->action(more_b).peer), "A");
+    EXPECT_EQ(fsm_b->label(fsm_b->action(more_b).label), "More");
+
+    delete fsm_a;
+    delete fsm_b;
+    delete root;
+    delete A;
+    delete B;
+}
+
+/**
+ * \test CFSM of parallel branches is their interleaving.
+ */
+TEST_F(FSMTest, ParInterleaving)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+    auto *C = new Role("C");
+
+    // par { A->B: X(); } and { C->A: Y(); }; A->C: Z();
+    auto *root = new BlockNode();
+    auto *par = new ParNode();
+    auto *left = new BlockNode();
+    left->append_child(interaction("X", A, B));
+    auto *right = new BlockNode();
+    right->append_child(interaction("Y", C, A));
+    par->append_child(left);
+    par->append_child(right);
+    root->append_child(par);
+    root->append_child(interaction("Z", A, C));
+
+    auto *fsm = build(root, A);
+    ASSERT_NE(fsm, nullptr);
+    EXPECT_EQ(fsm->num_states(), 5);
+    EXPECT_EQ(fsm->num_transitions(), 5);
+    int x = fsm->find_action(ST_CFSM_SEND, "B", "X");
+    int y = fsm->find_action(ST_CFSM_RECV, "C", "Y");
+    int z = fsm->find_action(ST_CFSM_SEND, "C", "Z");
+    int xy = fsm->next(fsm->next(fsm->initial(), x), y);
+    int yx = fsm->next(fsm->next(fsm->initial(), y), x);
+    ASSERT_GE(xy, 0);
+    EXPECT_EQ(xy, yx);
+    EXPECT_EQ(fsm->next(xy, x), -1);
+    EXPECT_TRUE(fsm->is_final(fsm->next(xy, z)));
+
+    delete fsm;
+    delete root;
+    delete A;
+    delete B;
+    delete C;
+}
+
+/**
+ * \test CFSM of an unknown continue label is invalid.
+ */
+TEST_F(FSMTest, InvalidContinue)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+
+    auto *root = new BlockNode();
+    root->append_child(interaction("X", A, B));
+    root->append_child(new ContinueNode("Missing"));
+
+    util::CFSMBuilder builder;
+    root->accept(builder);
+    EXPECT_FALSE(builder.is_valid());
+    EXPECT_EQ(builder.build(), nullptr);
+
+    delete root;
+    delete A;
+    delete B;
+}
+
+/**
+ * \test CFSM does not follow a ContinueNode binding made stale by an edit.
+ */
+TEST_F(FSMTest, StaleBinding)
+{
+    auto *B = new Role("B");
+
+    // rec X { B!P; rec Y { B!Q; continue X; } }
+    auto *root = new BlockNode();
+    auto *outer = new RecurNode("X");
+    auto *inner = new RecurNode("Y");
+    auto *cont = new ContinueNode("X");
+    outer->append_child(send("P", B));
+    inner->append_child(send("Q", B));
+    inner->append_child(cont);
+    outer->append_child(inner);
+    root->append_child(outer);
+    util::RecurBinder binder;
+    root->accept(binder);
+    ASSERT_EQ(cont->scope(), 1);
+
+    // rec X { B!P; rec X { B!Q; continue X; } }: continue X is the inner loop.
+    inner->set_label("X");
+    EXPECT_TRUE(cont->is_bound());
+    std::unique_ptr<util::CFSM> fsm(compile(root));
+    ASSERT_NE(fsm, nullptr);
+    int p = fsm->find_action(ST_CFSM_SEND, "B", "P");
+    int q = fsm->find_action(ST_CFSM_SEND, "B", "Q");
+    int loop = fsm->next(fsm->initial(), p);
+    ASSERT_GE(loop, 0);
+    EXPECT_EQ(fsm->next(loop, q), loop);
+    util::RecurScope scopes;
+    scopes.push(outer);
+    scopes.push(inner);
+    EXPECT_EQ(scopes.target(cont), inner);
+
+    // rec Z { B!P; rec Y { B!Q; continue X; } }: continue X has no target.
+    inner->set_label("Y");
+    outer->set_label("Z");
+    util::CFSMBuilder builder;
+    root->accept(builder);
+    EXPECT_FALSE(builder.is_valid());
+    EXPECT_EQ(scopes.target(cont), nullptr);
+
+    delete root;
+    delete B;
+}
+
+/**
+ * \test Monitor accepts conforming events and rejects violations.
+ */
+TEST_F(FSMTest, Monitor)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+
+    // rec L { A->B: Req(); B->A: Resp(); continue L; }
+    auto *root = new BlockNode();
+    auto *recur = new RecurNode("L");
+    recur->append_child(interaction("Req", A, B));
+    recur->append_child(interaction("Resp", B, A));
+    recur->append_child(new ContinueNode("L"));
+    root->append_child(recur);
+
+    auto *fsm = build(root, A);
+    ASSERT_NE(fsm, nullptr);
+    unsigned int req = fsm->find_action(ST_CFSM_SEND, "B", "Req");
+    unsigned int resp = fsm->find_action(ST_CFSM_RECV, "B", "Resp");
+
+    util::Monitor monitor(*fsm);
+    EXPECT_TRUE(monitor.step(req));
+    EXPECT_TRUE(monitor.step(resp));
+    EXPECT_TRUE(monitor.step(req));
+    EXPECT_FALSE(monitor.step(req));
+    EXPECT_TRUE(monitor.is_rejected());
+    EXPECT_FALSE(monitor.step(resp)); // Sticky.
+
+    monitor.reset();
+    unsigned int ok[] = { req, resp, req, resp };
+    EXPECT_EQ(monitor.check(ok, 4), 4);
+    EXPECT_FALSE(monitor.is_rejected());
+    unsigned int bad[] = { req, resp, resp, req };
+    EXPECT_EQ(monitor.check(bad, 4), 2);
+    EXPECT_TRUE(monitor.is_rejected());
+    EXPECT_EQ(monitor.check(ok, 4), 0); // Already rejected.
+
+    // Concurrent batches are applied atomically, each one is a full round.
+    monitor.reset();
+    std::vector<std::thread> threads;
+    std::atomic<unsigned int> failures(0);
+    for (unsigned int t=0; t<4; t++) {
+        threads.emplace_back([&]() {
+            unsigned int round[] = { req, resp };
+            for (unsigned int k=0; k<1000; k++) {
+                if (monitor.check(round, 2) != 2) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(monitor.state(), fsm->initial());
+
+    delete fsm;
+    delete root;
+    delete A;
+    delete B;
+}
+
+/**
+ * \test Trace checker reports the first violation of each Role.
+ */
+TEST_F(FSMTest, TraceCheck)
+{
+    // A->B: Req(); B->C: Fwd(); C->A: Done();
+    auto *session = new Session("Trace");
+    session->add_role(new Role("A"));
+    session->add_role(new Role("B"));
+    session->add_role(new Role("C"));
+    auto *root = new BlockNode();
+    root->append_child(interaction("Req", session->role("A"), session->role("B")));
+    root->append_child(interaction("Fwd", session->role("B"), session->role("C")));
+    root->append_child(interaction("Done", session->role("C"), session->role("A")));
+    session->set_root(root);
+
+    std::string header = ST_TRACE_MAGIC;
+    put_u32(header, ST_TRACE_VERSION);
+    put_u32(header, 3);
+    put_str(header, "C");
+    put_str(header, "B");
+    put_str(header, "A");
+    put_u32(header, 4);
+    put_str(header, "Req");
+    put_str(header, "Fwd");
+    put_str(header, "Done");
+    put_str(header, "Oops");
+
+    std::string good = header;
+    for (std::uint32_t ev : { 2, 1, 0,  1, 0, 1,  0, 2, 2 }) {
+        put_u32(good, ev);
+    }
+    std::string bad = header;
+    for (std::uint32_t ev : { 2, 1, 0,  1, 0, 1,  0, 2, 3 }) {
+        put_u32(bad, ev);
+    }
+
+    util::TraceChecker checker(session);
+    checker.set_num_threads(2);
+    EXPECT_TRUE(checker.check(good.data(), good.size()));
+    for (auto &result : checker.results()) {
+        EXPECT_EQ(result.violation, -1);
+        EXPECT_TRUE(result.complete);
+    }
+
+    EXPECT_FALSE(checker.check(bad.data(), bad.size()));
+    ASSERT_EQ(checker.results().size(), 3);
+    EXPECT_EQ(checker.results()[0].role, "A");
+    EXPECT_EQ(checker.results()[0].violation, 2);
+    EXPECT_EQ(checker.results()[1].violation, -1);
+    EXPECT_TRUE(checker.results()[1].complete);
+    EXPECT_EQ(checker.results()[2].violation, 2);
+
+    EXPECT_THROW(checker.check(bad.data(), bad.size() - 1), std::runtime_error);
+
+    // An event out of range is reported after every Role has a violation.
+    std::string late = header;
+    for (std::uint32_t ev : { 2, 1, 3,  0, 1, 3 }) {
+        put_u32(late, ev);
+    }
+    for (unsigned int i=0; i<10000; i++) {
+        for (std::uint32_t ev : { 0, 1, 0 }) {
+            put_u32(late, ev);
+        }
+    }
+    for (std::uint32_t ev : { 0, 5, 0 }) {
+        put_u32(late, ev);
+    }
+    for (unsigned int num_threads : { 1, 2, 3 }) {
+        checker.set_num_threads(num_threads);
+        EXPECT_THROW(checker.check(late.data(), late.size()), std::runtime_error);
+    }
+    checker.set_num_threads(2);
+
+    // Memory-mapped trace file.
+    char path[] = "/tmp/sesstype-trace-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, bad.data(), bad.size()), static_cast<ssize_t>(bad.size()));
+    close(fd);
+    EXPECT_FALSE(checker.check_file(path));
+    EXPECT_EQ(st_tree_check_trace(session, path), 2);
+    unlink(path);
+
+    delete session;
+}
+
+/**
+ * \test Explorer finds deadlocks and orphan messages with a witness.
+ */
+TEST_F(FSMTest, Explore)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+
+    // A: B?X; B!Y    B: A?Y; A!X
+    auto *local_a = new BlockNode();
+    local_a->append_child(recv("X", B));
+    local_a->append_child(send("Y", B));
+    auto *local_b = new BlockNode();
+    local_b->append_child(recv("Y", A));
+    local_b->append_child(send("X", A));
+    std::unique_ptr<util::CFSM> fsm_a(compile(local_a)), fsm_b(compile(local_b));
+
+    util::Explorer deadlock({ "A", "B" }, { fsm_a.get(), fsm_b.get() });
+    deadlock.set_num_threads(2);
+    auto report = deadlock.run();
+    EXPECT_TRUE(report.complete);
+    EXPECT_TRUE(report.deadlock);
+    EXPECT_EQ(report.deadlock_trace.size(), 0);
+    EXPECT_FALSE(report.orphan);
+
+    // A: B!Z; B!Y    B: A?Y
+    auto *local_a2 = new BlockNode();
+    local_a2->append_child(send("Z", B));
+    local_a2->append_child(send("Y", B));
+    std::unique_ptr<util::CFSM> fsm_a2(compile(local_a2));
+    util::Explorer orphan({ "A", "B" }, { fsm_a2.get(), fsm_b.get() });
+    report = orphan.run();
+    EXPECT_TRUE(report.deadlock); // B waits for Y behind Z.
+    ASSERT_EQ(report.deadlock_trace.size(), 2);
+    EXPECT_EQ(report.deadlock_trace[0].role, 0);
+    EXPECT_EQ(report.deadlock_trace[0].action, fsm_a2->find_action(ST_CFSM_SEND, "B", "Z"));
+
+    // A: B!Y; B!Z    B: A?Y; A!X   A never receives X and B never receives Z.
+    auto *local_a3 = new BlockNode();
+    local_a3->append_child(send("Y", B));
+    local_a3->append_child(send("Z", B));
+    std::unique_ptr<util::CFSM> fsm_a3(compile(local_a3));
+    util::Explorer orphan2({ "A", "B" }, { fsm_a3.get(), fsm_b.get() });
+    report = orphan2.run();
+    EXPECT_FALSE(report.deadlock);
+    EXPECT_TRUE(report.orphan);
+    EXPECT_EQ(report.orphan_trace.size(), 4);
+
+    // A: B!X; B!X; C!Go    B: C?W; A?X; A?X    C: A?Go; B!W
+    // With channel bound 1, A is stuck on its second X only because of the bound.
+    auto *C = new Role("C");
+    auto *local_a4 = new BlockNode();
+    local_a4->append_child(send("X", B));
+    local_a4->append_child(send("X", B));
+    local_a4->append_child(send("Go", C));
+    auto *local_b4 = new BlockNode();
+    local_b4->append_child(recv("W", C));
+    local_b4->append_child(recv("X", A));
+    local_b4->append_child(recv("X", A));
+    auto *local_c4 = new BlockNode();
+    local_c4->append_child(recv("Go", A));
+    local_c4->append_child(send("W", B));
+    std::unique_ptr<util::CFSM> fsm_a4(compile(local_a4)), fsm_b4(compile(local_b4)),
+        fsm_c4(compile(local_c4));
+    util::Explorer bounded({ "A", "B", "C" }, { fsm_a4.get(), fsm_b4.get(), fsm_c4.get() });
+    bounded.set_channel_bound(1);
+    report = bounded.run();
+    EXPECT_FALSE(report.deadlock);
+    EXPECT_TRUE(report.saturated);
+    ASSERT_EQ(report.saturated_trace.size(), 1);
+    EXPECT_EQ(report.saturated_trace[0].action, fsm_a4->find_action(ST_CFSM_SEND, "B", "X"));
+    bounded.set_channel_bound(2);
+    report = bounded.run();
+    EXPECT_FALSE(report.deadlock);
+    EXPECT_FALSE(report.orphan);
+    EXPECT_TRUE(report.saturated_trace.empty());
+
+    delete local_a;
+    delete local_b;
+    delete local_a2;
+    delete local_a3;
+    delete local_a4;
+    delete local_b4;
+    delete local_c4;
+    delete A;
+    delete B;
+    delete C;
+}
+
+/**
+ * \test Projections of a global Session are deadlock-free.
+ */
+TEST_F(FSMTest, ExploreSession)
+{
+    // rec L { choice at A { A->B: More(); B->C: Fwd(); continue L; } or { A->B: Done(); B->C: Done(); } }
+    auto *session = new Session("Explore");
+    session->add_role(new Role("A"));
+    session->add_role(new Role("B"));
+    session->add_role(new Role("C"));
+    auto *A = session->role("A"), *B = session->role("B"), *C = session->role("C");
+    auto *root = new BlockNode();
+    auto *recur = new RecurNode("L");
+    auto *choice = new ChoiceNode(new Role("A"));
+    auto *more = new BlockNode();
+    more->append_child(interaction("More", A, B));
+    more->append_child(interaction("Fwd", B, C));
+    more->append_child(new ContinueNode("L"));
+    auto *done = new BlockNode();
+    done->append_child(interaction("Done", A, B));
+    done->append_child(interaction("Done", B, C));
+    choice->append_child(more);
+    choice->append_child(done);
+    recur->append_child(choice);
+    root->append_child(recur);
+    session->set_root(root);
+
+    util::Explorer explorer(session);
+    explorer.set_num_threads(4);
+    explorer.set_channel_bound(2);
+    auto report = explorer.run();
+    EXPECT_TRUE(report.complete);
+    EXPECT_FALSE(report.deadlock);
+    EXPECT_FALSE(report.orphan);
+    EXPECT_TRUE(report.saturated); // A can run ahead of B and C.
+    EXPECT_GT(report.num_states, 1);
+
+    delete session;
+}
+
+/**
+ * \test Channel bounds of bounded and unbounded Sessions.
+ */
+TEST_F(FSMTest, ChannelBounds)
+{
+    // rec L { par { A->B: X(); } and { A->B: Y(); } B->A: Ack(); continue L; }
+    auto *session = new Session("Bounded");
+    session->add_role(new Role("A"));
+    session->add_role(new Role("B"));
+    auto *A = session->role("A"), *B = session->role("B");
+    auto *root = new BlockNode();
+    auto *recur = new RecurNode("L");
+    auto *par = new ParNode();
+    auto *x = new BlockNode();
+    x->append_child(interaction("X", A, B));
+    auto *y = new BlockNode();
+    y->append_child(interaction("Y", A, B));
+    par->append_child(x);
+    par->append_child(y);
+    recur->append_child(par);
+    recur->append_child(interaction("Ack", B, A));
+    recur->append_child(new ContinueNode("L"));
+    root->append_child(recur);
+    session->set_root(root);
+
+    util::ChannelBounds bounds(session);
+    bounds.set_num_threads(2);
+    EXPECT_TRUE(bounds.run());
+    EXPECT_TRUE(bounds.is_complete());
+    EXPECT_TRUE(bounds.is_exact());
+    EXPECT_EQ(bounds.queue_bound("A", "B"), 2);
+    EXPECT_EQ(bounds.queue_bound("B", "A"), 1);
+    EXPECT_EQ(bounds.queue_bound("A", "A"), 0);
+    ASSERT_EQ(bounds.channels().size(), 3);
+    for (auto &channel : bounds.channels()) {
+        EXPECT_TRUE(channel.bounded);
+        EXPECT_TRUE(channel.exact);
+        EXPECT_EQ(channel.bound, 1);
+    }
+    delete session;
+
+    // A->B: Hello(); rec L { A->B: M(); B->C: N(); C->B: Ack(); continue L; }
+    // A runs ahead of B.
+    auto *ahead = new Session("Unbounded");
+    ahead->add_role(new Role("A"));
+    ahead->add_role(new Role("B"));
+    ahead->add_role(new Role("C"));
+    A = ahead->role("A");
+    B = ahead->role("B");
+    auto *C = ahead->role("C");
+    root = new BlockNode();
+    root->append_child(interaction("Hello", A, B));
+    recur = new RecurNode("L");
+    recur->append_child(interaction("M", A, B));
+    recur->append_child(interaction("N", B, C));
+    recur->append_child(interaction("Ack", C, B));
+    recur->append_child(new ContinueNode("L"));
+    root->append_child(recur);
+    ahead->set_root(root);
+
+    util::ChannelBounds unbounded(ahead);
+    unbounded.set_max_bound(8);
+    EXPECT_FALSE(unbounded.run());
+    EXPECT_FALSE(unbounded.is_exact());
+    EXPECT_EQ(unbounded.queue_bound("A", "B"), -1);
+    EXPECT_EQ(unbounded.queue_bound("B", "C"), 1);
+    ASSERT_EQ(unbounded.channels().size(), 4);
+    for (auto &channel : unbounded.channels()) {
+        // Bounds of every channel are lower bounds, not only of A->B. Hello
+        // shares the unbounded A->B queue with M, but is itself bounded.
+        EXPECT_FALSE(channel.exact);
+        if (channel.label == "M") {
+            EXPECT_FALSE(channel.bounded);
+            EXPECT_EQ(channel.bound, 8);
+        } else {
+            EXPECT_TRUE(channel.bounded);
+            EXPECT_EQ(channel.bound, 1);
+        }
+    }
+    delete ahead;
+}
+
+/**
+ * \test Communication graph and automaton export.
+ */
+TEST_F(FSMTest, GraphExport)
+{
+    auto *session = new Session("G");
+    session->add_role(new Role("A"));
+    session->add_role(new Role("B"));
+    session->add_role(new Role("C"));
+    session->add_role(new Role("D"));
+    auto *A = session->role("A"), *B = session->role("B"), *C = session->role("C");
+    auto *root = new BlockNode();
+    auto *recur = new RecurNode("L");
+    recur->append_child(interaction("L", A, B));
+    recur->append_child(interaction("M", A, B));
+    recur->append_child(interaction("L", A, B));
+    recur->append_child(interaction("N", B, C));
+    recur->append_child(new ContinueNode("L"));
+    root->append_child(recur);
+    session->set_root(root);
+
+    util::CommGraph graph = util::comm_graph(*session);
+    EXPECT_EQ(graph.num_roles(), 4);
+    EXPECT_EQ(graph.num_edges(), 2);
+    EXPECT_EQ(graph.edge("A", "B")->occurrences, 3);
+    EXPECT_EQ(graph.edge("A", "B")->labels.at("L"), 2);
+    EXPECT_EQ(graph.edge("B", "A"), nullptr);
+
+    std::stringstream dot;
+    {
+        util::OutputBuffer buf(dot);
+        graph.write_dot(buf, "G");
+    }
+    EXPECT_EQ(dot.str(),
+        "digraph \"G\" {\n"
+        "  \"A\";\n  \"B\";\n  \"C\";\n  \"D\";\n"
+        "  \"A\" -> \"B\" [label=\"L x2\\nM\", weight=3];\n"
+        "  \"B\" -> \"C\" [label=\"N\", weight=1];\n"
+        "}\n");
+
+    std::stringstream graphml;
+    {
+        util::OutputBuffer buf(graphml);
+        graph.set_max_labels(1);
+        graph.write_graphml(buf, "G");
+    }
+    // Every key precedes the graph element.
+    EXPECT_EQ(graphml.str().find(
+        "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+        "  <key id=\"label\" for=\"edge\" attr.name=\"label\" attr.type=\"string\"/>\n"
+        "  <key id=\"occurrences\" for=\"edge\" attr.name=\"occurrences\" attr.type=\"long\"/>\n"
+        "  <graph id=\"G\" edgedefault=\"directed\">\n"
+        "    <node id=\"A\"/>\n"), graphml.str().find("<graphml"));
+    EXPECT_LT(graphml.str().rfind("<key "), graphml.str().find("<graph "));
+    EXPECT_NE(graphml.str().find(
+        "<edge source=\"A\" target=\"B\"><data key=\"label\">L x2, (+1 more)</data>"
+        "<data key=\"occurrences\">3</data></edge>"), std::string::npos);
+
+    std::unique_ptr<util::CFSM> fsm(util::CFSMBuilder::compile(root, B));
+    ASSERT_NE(fsm, nullptr);
+    std::stringstream fsm_dot;
+    {
+        util::OutputBuffer buf(fsm_dot);
+        util::write_dot(*fsm, buf, "B");
+    }
+    EXPECT_NE(fsm_dot.str().find("s0 -> s1 [label=\"A?L\"];"), std::string::npos);
+    EXPECT_NE(fsm_dot.str().find("[label=\"C!N\"];"), std::string::npos);
+    std::stringstream fsm_graphml;
+    {
+        util::OutputBuffer buf(fsm_graphml);
+        util::write_graphml(*fsm, buf, "B");
+    }
+    EXPECT_NE(fsm_graphml.str().find("<key id=\"final\""), std::string::npos);
+    EXPECT_LT(fsm_graphml.str().rfind("<key "), fsm_graphml.str().find("<graph "));
+    EXPECT_LT(fsm_graphml.str().find("<graph "), fsm_graphml.str().find("<node "));
+
+    delete session;
+
+    // Parameterised Roles are aggregated into summary edges.
+    parameterised::Session psession("P");
+    auto *W = new parameterised::Role("W");
+    W->add_param(new parameterised::VarExpr("N"));
+    psession.add_role(W);
+    auto *proot = new parameterised::BlockNode();
+    for (int i=0; i<3; i++) {
+        parameterised::MsgSig msg("Data");
+        auto *pinteraction = new parameterised::InteractionNode(&msg);
+        parameterised::Role from("W"), to("W");
+        from.add_param(new parameterised::VarExpr("i"));
+        to.add_param(new parameterised::AddExpr(new parameterised::VarExpr("i"),
+                                                new parameterised::ValExpr(i + 1)));
+        pinteraction->set_sndr(&from);
+        pinteraction->add_rcvr(&to);
+        proot->append_child(pinteraction);
+    }
+    psession.set_root(proot);
+
+    util::CommGraph summary = parameterised::util::comm_graph(psession);
+    EXPECT_EQ(summary.num_roles(), 1);
+    EXPECT_EQ(summary.num_edges(), 1);
+    EXPECT_EQ(summary.edge("W[*]", "W[*]")->occurrences, 3);
+    util::CommGraph exact = parameterised::util::comm_graph(psession, false);
+    EXPECT_EQ(exact.num_edges(), 3);
+    EXPECT_NE(exact.edge("W[i]", "W[(i+1)]"), nullptr);
+}
+
+} // namespace tests
+} // namespace sesstype
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
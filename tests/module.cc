@@ -3,8 +3,12 @@
  * \brief Tests for sesstype::Module and sesstype::Import.
  */
 
+#include <regex>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -12,6 +16,12 @@
 #include "sesstype/session.h"
 #include "sesstype/parameterised/module.h"
 #include "sesstype/parameterised/session.h"
+#include "sesstype/node/block.h"
+#include "sesstype/node/continue.h"
+#include "sesstype/node/interaction.h"
+#include "sesstype/node/recur.h"
+#include "sesstype/util/print.h"
+#include "sesstype/util/project.h"
 
 namespace sesstype {
 namespace tests {
@@ -128,6 +138,92 @@ TEST_F(ModuleTest, Module_Alias)
   ASSERT_THROW(empty.import("C"), std::out_of_range);
 }
 
+/**
+ * \test Frozen Module is immutable and can be read from many threads.
+ */
+TEST_F(ModuleTest, Module_Freeze)
+{
+  sesstype::Module module("M");
+  auto *p = new sesstype::Session("P");
+  p->add_role(new sesstype::Role("A"));
+  p->add_role(new sesstype::Role("B"));
+  auto *root = new sesstype::BlockNode();
+  auto *recur = new sesstype::RecurNode("T");
+  auto *interaction = new sesstype::InteractionNode(new sesstype::MsgSig("M"));
+  interaction->set_sndr(p->role("A"));
+  interaction->add_rcvr(p->role("B"));
+  recur->append_child(interaction);
+  recur->append_child(new sesstype::ContinueNode("T"));
+  root->append_child(recur);
+  p->set_root(root);
+  module.add_session(p);
+  auto *q = new sesstype::Session("Q");
+  module.add_session(q);
+
+  auto *unfrozen_p = module.session_at(0);
+  ASSERT_NE(st_module_freeze(&module), nullptr);
+  EXPECT_TRUE(module.is_frozen());
+  EXPECT_TRUE(p->is_frozen());
+  EXPECT_TRUE(root->is_frozen());
+  EXPECT_TRUE(interaction->is_frozen());
+  EXPECT_EQ(module.session_at(0), unfrozen_p);
+  EXPECT_NE(module.session_at(0), module.session_at(1));
+  ASSERT_THROW(module.session_at(2), std::out_of_range);
+
+  sesstype::Session r("R");
+  sesstype::Role c("C");
+  sesstype::ContinueNode cont("T");
+  ASSERT_THROW(module.add_session(&r), std::logic_error);
+  ASSERT_THROW(module.set_name("N"), std::logic_error);
+  ASSERT_THROW(p->add_role(&c), std::logic_error);
+  ASSERT_THROW(p->set_root(nullptr), std::logic_error);
+  ASSERT_THROW(root->append_child(&cont), std::logic_error);
+  ASSERT_THROW(interaction->set_msg(interaction->msg()), std::logic_error);
+  EXPECT_EQ(recur->num_children(), 2);
+
+  // Roles and MsgSigs are frozen with their Session and Nodes.
+  sesstype::MsgPayload payload("int");
+  ASSERT_THROW(p->role("A")->set_name("C"), std::logic_error);
+  ASSERT_THROW(interaction->sndr()->set_name("C"), std::logic_error);
+  ASSERT_THROW(interaction->rcvr()->set_name("C"), std::logic_error);
+  ASSERT_THROW(interaction->msg()->add_payload(&payload), std::logic_error);
+  EXPECT_EQ(interaction->sndr()->name(), "A");
+  EXPECT_EQ(interaction->msg()->num_payloads(), 0);
+
+  // Concurrent projection and printing of the shared Session.
+  std::vector<std::string> outputs(8);
+  std::vector<std::thread> threads;
+  for (unsigned int i=0; i<outputs.size(); i++) {
+    threads.emplace_back([&, i]() {
+      const sesstype::Session *session = module.session("P");
+      sesstype::util::ProjectionVisitor projector(session->role(i % 2 ? "A" : "B"));
+      session->root()->accept(projector);
+      std::stringstream ss;
+      sesstype::util::Print printer(ss);
+      projector.get_root()->accept(printer);
+      outputs[i] = std::regex_replace(ss.str(), std::regex("@0x[0-9a-f]+"), "");
+      delete projector.get_root();
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (unsigned int i=2; i<outputs.size(); i++) {
+    EXPECT_EQ(outputs[i], outputs[i % 2]);
+  }
+  EXPECT_NE(outputs[0], outputs[1]);
+
+  // A copy of a frozen Session can be modified.
+  sesstype::Session copy(*p);
+  EXPECT_FALSE(copy.is_frozen());
+  copy.add_role(new sesstype::Role("C"));
+  copy.role("A")->set_name("A");
+  dynamic_cast<sesstype::BlockNode *>(copy.root())->append_child(new sesstype::BlockNode());
+
+  delete p;
+  delete q;
+}
+
 } // namespace tests
 } // namespace sesstype
 
@@ -5,7 +5,12 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "sesstype/msg.h"
 #include "sesstype/role.h"
@@ -18,7 +23,13 @@
 #include "sesstype/node/par.h"
 #include "sesstype/node/interruptible.h"
 #include "sesstype/node/nested.h"
+#include "sesstype/util/bind_recur.h"
 #include "sesstype/util/empty_visitor.h"
+#include "sesstype/util/msg_aggregate.h"
+#include "sesstype/util/project.h"
+#include "sesstype/util/parallel.h"
+#include "sesstype/util/print.h"
+#include "sesstype/util/traversal.h"
 
 #include "sesstype/parameterised/expr.h"
 #include "sesstype/parameterised/expr/var.h"
@@ -152,6 +163,87 @@ TEST_F(NodeTest, TestContinueNode)
     delete node;
 }
 
+/**
+ * \test Binding ContinueNode to RecurNode.
+ */
+TEST_F(NodeTest, TestRecurBinding)
+{
+    auto *ALICE = new Role("Alice");
+    auto *BOB = new Role("Bob");
+
+    // rec Outer { rec Inner { A->B; continue Outer; continue Inner; } }
+    auto *outer = new sesstype::RecurNode("Outer");
+    auto *inner = new sesstype::RecurNode("Inner");
+    auto *interaction = new sesstype::InteractionNode(new MsgSig("M"));
+    interaction->set_sndr(ALICE);
+    interaction->add_rcvr(BOB);
+    auto *cont_outer = new sesstype::ContinueNode("Outer");
+    auto *cont_inner = new sesstype::ContinueNode("Inner");
+    inner->append_child(interaction);
+    inner->append_child(cont_outer);
+    inner->append_child(cont_inner);
+    outer->append_child(inner);
+    EXPECT_FALSE(cont_outer->is_bound());
+
+    util::RecurBinder binder;
+    outer->accept(binder);
+    EXPECT_TRUE(binder.is_valid());
+    EXPECT_EQ(cont_outer->scope(), 1);
+    EXPECT_EQ(cont_inner->scope(), 0);
+
+    util::RecurScope scopes;
+    scopes.push(outer);
+    scopes.push(inner);
+    EXPECT_EQ(scopes.target(cont_outer), outer);
+    EXPECT_EQ(scopes.target(cont_inner), inner);
+    EXPECT_TRUE(cont_outer->is_bound_to(outer, scopes.stamp()));
+    EXPECT_FALSE(cont_outer->is_bound_to(inner, scopes.stamp()));
+
+    // Binding is preserved by clone and projection.
+    auto *outer_clone = outer->clone();
+    auto *inner_clone = dynamic_cast<sesstype::RecurNode *>(outer_clone->child(0));
+    EXPECT_EQ(dynamic_cast<sesstype::ContinueNode *>(inner_clone->child(1))->scope(), 1);
+
+    util::ProjectionVisitor projector(BOB);
+    outer->accept(projector);
+    auto *local = dynamic_cast<BlockNode *>(projector.get_root());
+    auto *local_inner = dynamic_cast<sesstype::RecurNode *>(
+            dynamic_cast<sesstype::RecurNode *>(local->child(0))->child(0));
+    EXPECT_EQ(dynamic_cast<sesstype::ContinueNode *>(local_inner->child(1))->scope(), 1);
+    EXPECT_EQ(dynamic_cast<sesstype::ContinueNode *>(local_inner->child(2))->scope(), 0);
+
+    // Editing an enclosing RecurNode makes the binding stale, the target is
+    // then found by label.
+    inner->set_label("Outer");
+    util::RecurScope edited;
+    edited.push(outer);
+    edited.push(inner);
+    EXPECT_TRUE(cont_outer->is_bound());
+    EXPECT_FALSE(cont_outer->is_bound_to(outer, edited.stamp()));
+    EXPECT_EQ(edited.target(cont_outer), inner);
+    inner->set_label("Inner");
+    util::walk(outer, binder);
+    util::RecurScope rebound;
+    rebound.push(outer);
+    rebound.push(inner);
+    EXPECT_TRUE(cont_outer->is_bound_to(outer, rebound.stamp()));
+
+    // Relabelling unbinds, unknown labels are reported.
+    cont_inner->set_label("Unknown");
+    EXPECT_FALSE(cont_inner->is_bound());
+    util::RecurBinder binder2;
+    outer->accept(binder2);
+    EXPECT_FALSE(binder2.is_valid());
+    EXPECT_EQ(st_continue_node_get_scope(cont_inner), -1);
+    EXPECT_FALSE(st_node_bind_recur(outer));
+
+    delete local;
+    delete outer_clone;
+    delete outer;
+    delete ALICE;
+    delete BOB;
+}
+
 /**
  * \test ChoiceNode operations.
  */
@@ -367,6 +459,316 @@ TEST_F(NodeTest, CloneTest)
     delete node2;
 }
 
+/**
+ * \test Iterative pre-order and post-order traversal.
+ */
+TEST_F(NodeTest, TestTraversal)
+{
+    // { rec R { choice { cont R } } ; par {} }
+    auto *root = new sesstype::BlockNode();
+    auto *recur = new sesstype::RecurNode("R");
+    auto *choice = new sesstype::ChoiceNode(new Role("A"));
+    auto *cont = new sesstype::ContinueNode("R");
+    auto *par = new sesstype::ParNode();
+    choice->append_child(cont);
+    recur->append_child(choice);
+    root->append_child(recur);
+    root->append_child(par);
+
+    std::vector<sesstype::Node *> pre, post;
+    for (auto *node : util::preorder(root)) {
+        pre.push_back(node);
+    }
+    for (auto *node : util::postorder(root)) {
+        post.push_back(node);
+    }
+    EXPECT_EQ(pre, std::vector<sesstype::Node *>({ root, recur, choice, cont, par }));
+    EXPECT_EQ(post, std::vector<sesstype::Node *>({ cont, choice, recur, par, root }));
+
+    util::PreOrderIterator it(root);
+    ++it;
+    EXPECT_EQ(it.depth(), 1);
+    it.skip_children();
+    EXPECT_EQ(*it, par);
+    delete root;
+
+    // Deep nesting is bounded by heap, not call stack.
+    const unsigned int depth = 10000;
+    root = new sesstype::RecurNode("R");
+    auto *blk = dynamic_cast<sesstype::BlockNode *>(root);
+    for (unsigned int i=1; i<depth; i++) {
+        auto *child = new sesstype::RecurNode("R" + std::to_string(i));
+        blk->append_child(child);
+        blk = child;
+    }
+    cont = new sesstype::ContinueNode("R");
+    blk->append_child(cont);
+
+    unsigned int count = 0;
+    for (auto *node : util::postorder(root)) {
+        if (count++ == 0) {
+            EXPECT_EQ(node, cont);
+        }
+    }
+    EXPECT_EQ(count, depth + 1);
+
+    util::RecurBinder binder;
+    util::walk(root, binder);
+    EXPECT_TRUE(binder.is_valid());
+    EXPECT_EQ(cont->scope(), depth - 1);
+
+    // Projection and printing use the iterative walk.
+    auto *A = new Role("A");
+    util::ProjectionVisitor projector(A);
+    root->accept(projector);
+    count = 0;
+    for (auto *node : util::postorder(projector.get_root())) {
+        (void)node;
+        count++;
+    }
+    EXPECT_EQ(count, depth + 2); // Local root block, RecurNodes and ContinueNode.
+    std::stringstream ss;
+    util::Print printer(ss);
+    root->accept(printer);
+    std::string printed = ss.str();
+    EXPECT_EQ(std::count(printed.begin(), printed.end(), '\n'), depth + 3); // Header and Nodes.
+    delete projector.get_root();
+    delete A;
+    delete root;
+}
+
+/**
+ * \test Fusion of adjacent interactions between the same Roles.
+ */
+TEST_F(NodeTest, TestMsgAggregate)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+    auto interaction = [](std::string label, std::string name, Role *from, Role *to) {
+        MsgSig msg(label);
+        if (!name.empty()) {
+            MsgPayload payload("int", name);
+            msg.add_payload(&payload);
+        }
+        auto *node = new sesstype::InteractionNode(&msg);
+        node->set_sndr(from);
+        node->add_rcvr(to);
+        return node;
+    };
+
+    // A->B: X(int x); A->B: Y(int y); A->B: Z(int x); B->A: Ack();
+    // rec R { A->B: P(); A->B: Q(); continue R; }
+    // interruptible { A->B: I(); A->B: J(); }
+    auto *root = new sesstype::BlockNode();
+    root->append_child(interaction("X", "x", A, B));
+    root->append_child(interaction("Y", "y", A, B));
+    root->append_child(interaction("Z", "x", A, B));
+    root->append_child(interaction("Ack", "", B, A));
+    auto *recur = new sesstype::RecurNode("R");
+    recur->append_child(interaction("P", "", A, B));
+    recur->append_child(interaction("Q", "", A, B));
+    recur->append_child(new sesstype::ContinueNode("R"));
+    root->append_child(recur);
+    auto *interruptible = new sesstype::InterruptibleNode();
+    interruptible->append_child(interaction("I", "", A, B));
+    interruptible->append_child(interaction("J", "", A, B));
+    root->append_child(interruptible);
+
+    util::MsgAggregator aggregator;
+    util::walk(root, aggregator);
+    EXPECT_EQ(aggregator.num_fused(), 2);
+    ASSERT_EQ(root->num_children(), 5);
+    auto *xy = dynamic_cast<sesstype::InteractionNode *>(root->child(0));
+    EXPECT_EQ(xy->msg()->label(), "X_Y");
+    ASSERT_EQ(xy->msg()->num_payloads(), 2);
+    EXPECT_EQ(xy->msg()->payload(1)->name(), "y");
+    // Payload x would be repeated.
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(root->child(1))->msg()->label(), "Z");
+    ASSERT_EQ(recur->num_children(), 2);
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(recur->child(0))->msg()->label(), "P_Q");
+    EXPECT_EQ(interruptible->num_children(), 2);
+
+    // The receiver has one receive per fused message.
+    util::ProjectionVisitor projector(B);
+    root->accept(projector);
+    auto *local = dynamic_cast<sesstype::BlockNode *>(projector.get_root());
+    ASSERT_EQ(local->num_children(), 5);
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(local->child(0))->msg()->label(), "X_Y");
+
+    delete local;
+    delete root;
+
+    // choice at A { A->B: X(); } or { A->B: Y(); }   par { A->B: X(); } and { A->B: Y(); }
+    root = new sesstype::BlockNode();
+    auto *choice = new sesstype::ChoiceNode(A->clone());
+    choice->append_child(interaction("X", "", A, B));
+    choice->append_child(interaction("Y", "", A, B));
+    auto *par = new sesstype::ParNode();
+    par->append_child(interaction("X", "", A, B));
+    par->append_child(interaction("Y", "", A, B));
+    root->append_child(choice);
+    root->append_child(par);
+
+    util::MsgAggregator branches;
+    util::walk(root, branches);
+    EXPECT_EQ(branches.num_fused(), 0);
+    ASSERT_EQ(choice->num_children(), 2);
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(choice->child(0))->msg()->label(), "X");
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(choice->child(1))->msg()->label(), "Y");
+    ASSERT_EQ(par->num_children(), 2);
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(par->child(1))->msg()->label(), "Y");
+
+    delete root;
+    delete A;
+    delete B;
+}
+
+/**
+ * \test Parallel fold: statistics, structural hash and clone.
+ */
+TEST_F(NodeTest, TestParallelFold)
+{
+    auto *A = new Role("A");
+    auto *B = new Role("B");
+
+    // rec R { choice at A { { A->B: L0(); cont R } ... { A->B: L99(); } } }
+    auto *root = new sesstype::BlockNode();
+    auto *recur = new sesstype::RecurNode("R");
+    auto *choice = new sesstype::ChoiceNode(A->clone());
+    for (unsigned int i=0; i<100; i++) {
+        auto *branch = new sesstype::BlockNode();
+        auto *interaction = new sesstype::InteractionNode(new MsgSig("L" + std::to_string(i)));
+        interaction->set_sndr(A);
+        interaction->add_rcvr(B);
+        branch->append_child(interaction);
+        if (i % 2 == 0) {
+            branch->append_child(new sesstype::ContinueNode("R"));
+        }
+        choice->append_child(branch);
+    }
+    recur->append_child(choice);
+    root->append_child(recur);
+
+    util::ForkJoinPool pool(4);
+    auto stats = util::parallel_stats(pool, root);
+    EXPECT_EQ(stats.num_nodes, 3 + 100 + 100 + 50);
+    EXPECT_EQ(stats.depth, 5);
+    EXPECT_EQ(stats.num_by_type[ST_NODE_SENDRECV], 100);
+    EXPECT_EQ(stats.num_by_type[ST_NODE_CONTINUE], 50);
+
+    auto *copy = util::parallel_clone(pool, root);
+    EXPECT_NE(copy, root);
+    EXPECT_EQ(util::parallel_stats(pool, copy).num_nodes, stats.num_nodes);
+    EXPECT_EQ(util::parallel_hash(pool, copy), util::parallel_hash(pool, root));
+
+    auto *copy_choice = dynamic_cast<sesstype::ChoiceNode *>(
+            dynamic_cast<sesstype::RecurNode *>(dynamic_cast<sesstype::BlockNode *>(copy)->child(0))->child(0));
+    auto *branch = dynamic_cast<sesstype::BlockNode *>(copy_choice->child(42));
+    EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(branch->child(0))->msg()->label(), "L42");
+    MsgSig changed("Changed");
+    dynamic_cast<sesstype::InteractionNode *>(branch->child(0))->set_msg(&changed);
+    EXPECT_NE(util::parallel_hash(pool, copy), util::parallel_hash(pool, root));
+
+    // Parameterised Nodes are copied whole.
+    auto *loop = new sesstype::parameterised::ForNode(new sesstype::parameterised::RngExpr("i",
+            new sesstype::parameterised::ValExpr(1), new sesstype::parameterised::VarExpr("N")));
+    loop->append_child(new sesstype::parameterised::AllReduceNode());
+    root->append_child(loop);
+    auto *param_copy = dynamic_cast<sesstype::BlockNode *>(util::parallel_clone(pool, root));
+    ASSERT_EQ(param_copy->num_children(), 2);
+    auto *loop_copy = dynamic_cast<sesstype::parameterised::ForNode *>(param_copy->child(1));
+    ASSERT_NE(loop_copy, nullptr);
+    EXPECT_NE(loop_copy, loop);
+    EXPECT_EQ(loop_copy->num_children(), 1);
+    EXPECT_EQ(loop_copy->child(0)->type(), ST_NODE_ALLREDUCE);
+    delete param_copy;
+
+    // Partial results are discarded when a task throws.
+    std::atomic<long> live(0);
+    EXPECT_THROW(util::parallel_fold<long *>(pool, root,
+            [&live](Node *node) -> long * {
+                if (node->type() == ST_NODE_CONTINUE) {
+                    throw std::runtime_error("map");
+                }
+                live++;
+                return new long(1);
+            },
+            [&live](long *&acc, long *const &child) {
+                *acc += *child;
+                delete child;
+                live--;
+            },
+            2, [&live](long *&result) {
+                if (result != nullptr) {
+                    delete result;
+                    live--;
+                }
+            }), std::runtime_error);
+    EXPECT_EQ(live, 0);
+
+    delete copy;
+    delete root;
+    delete A;
+    delete B;
+}
+
+/**
+ * \test Detach, insert, splice and swap children of BlockNode.
+ */
+TEST_F(NodeTest, TestBlockRewrite)
+{
+    auto *blk = new sesstype::BlockNode();
+    auto *other = new sesstype::BlockNode();
+    std::vector<sesstype::Node *> nodes;
+    for (unsigned int i=0; i<6; i++) {
+        nodes.push_back(new sesstype::ContinueNode("L" + std::to_string(i)));
+    }
+    for (unsigned int i=0; i<3; i++) {
+        blk->append_child(nodes[i]);
+        other->append_child(nodes[i + 3]);
+    }
+
+    auto rev = blk->revision();
+    auto *detached = blk->detach_child(1);
+    EXPECT_EQ(detached, nodes[1]);
+    EXPECT_EQ(blk->num_children(), 2);
+    EXPECT_NE(blk->revision(), rev);
+
+    blk->insert_child(0, detached); // 1 0 2
+    EXPECT_EQ(blk->child(0), nodes[1]);
+    EXPECT_THROW(blk->insert_child(4, detached), std::out_of_range);
+
+    blk->splice(1, other, 1, 3);    // 1 4 5 0 2
+    EXPECT_EQ(other->num_children(), 1);
+    EXPECT_EQ(blk->num_children(), 5);
+    EXPECT_EQ(blk->child(1), nodes[4]);
+    EXPECT_EQ(blk->child(2), nodes[5]);
+    EXPECT_EQ(blk->child(3), nodes[0]);
+
+    blk->splice(5, blk, 0, 2);      // 5 0 2 1 4
+    EXPECT_EQ(blk->child(0), nodes[5]);
+    EXPECT_EQ(blk->child(3), nodes[1]);
+    EXPECT_EQ(blk->child(4), nodes[4]);
+    EXPECT_THROW(blk->splice(1, blk, 0, 2), std::out_of_range);
+
+    blk->swap_children(0, 4);       // 4 0 2 1 5
+    EXPECT_EQ(blk->child(0), nodes[4]);
+    EXPECT_EQ(blk->child(4), nodes[5]);
+
+    // C API.
+    st_node_swap_children(blk, 0, 1);
+    EXPECT_EQ(st_node_get_child(blk, 0), nodes[0]);
+    auto *node = st_node_detach_child(blk, 0);
+    st_node_insert_child(other, 1, node);
+    st_node_splice_children(other, 0, blk, 0, st_node_num_children(blk));
+    EXPECT_EQ(st_node_num_children(blk), 0);
+    EXPECT_EQ(st_node_num_children(other), 6);
+    EXPECT_EQ(st_node_get_child(other, 5), nodes[0]);
+
+    delete blk;
+    delete other;
+}
+
 } // namespace tests
 } // namespace sesstype
 
@@ -14,6 +14,9 @@
 #include "sesstype/node/interaction.h"
 #include "sesstype/node/recur.h"
 #include "sesstype/node/continue.h"
+#include "sesstype/node/choice.h"
+#include "sesstype/node/par.h"
+#include "sesstype/util/incremental_project.h"
 
 namespace sesstype {
 namespace tests {
@@ -21,6 +24,26 @@ namespace tests {
 class ProjectionTest : public ::testing::Test {
   protected:
     ProjectionTest() {}
+
+    /// Compare two local trees Node by Node.
+    static void expect_same_tree(Node *expected, Node *actual)
+    {
+        ASSERT_NE(actual, nullptr);
+        ASSERT_EQ(expected->type(), actual->type());
+        if (auto *interaction = dynamic_cast<InteractionNode *>(expected)) {
+            EXPECT_EQ(interaction->msg()->label(),
+                      dynamic_cast<InteractionNode *>(actual)->msg()->label());
+        }
+        auto *blk = dynamic_cast<BlockNode *>(expected);
+        if (blk == nullptr) {
+            return;
+        }
+        auto *actual_blk = dynamic_cast<BlockNode *>(actual);
+        ASSERT_EQ(blk->num_children(), actual_blk->num_children());
+        for (unsigned int i=0; i<blk->num_children(); i++) {
+            expect_same_tree(blk->child(i), actual_blk->child(i));
+        }
+    }
 };
 
 /**
@@ -114,6 +137,162 @@ TEST_F(ProjectionTest, BasicProjection)
     EXPECT_EQ(ep_bob_interact2->rcvr()->name(), "Mallory");
 }
 
+/**
+ * \test Incremental projection only reprojects modified subtrees.
+ */
+TEST_F(ProjectionTest, IncrementalProjection)
+{
+    auto *ALICE = new Role("Alice");
+    auto *BOB   = new Role("Bob");
+    auto *CAROL = new Role("Carol");
+
+    auto *root = new BlockNode();
+
+    // ALICE --First()--> BOB
+    auto *interact0 = new InteractionNode(new MsgSig("First"));
+    interact0->set_sndr(ALICE);
+    interact0->add_rcvr(BOB);
+    root->append_child(interact0);
+
+    // rec Rec0 { BOB --Second()--> ALICE; continue Rec0; }
+    auto *recur = new RecurNode("Rec0");
+    auto *interact1 = new InteractionNode(new MsgSig("Second"));
+    interact1->set_sndr(BOB);
+    interact1->add_rcvr(ALICE);
+    recur->append_child(interact1);
+    recur->append_child(new ContinueNode("Rec0"));
+    root->append_child(recur);
+
+    // rec Rec1 { ALICE --Third()--> CAROL; }
+    auto *recur2 = new RecurNode("Rec1");
+    auto *interact2 = new InteractionNode(new MsgSig("Third"));
+    interact2->set_sndr(ALICE);
+    interact2->add_rcvr(CAROL);
+    recur2->append_child(interact2);
+    root->append_child(recur2);
+
+    util::IncrementalProjection project_wrt_bob(root, BOB);
+    auto *ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.get_root());
+    EXPECT_EQ(ep_root->num_children(), 3);
+    auto *ep_recur = dynamic_cast<RecurNode *>(ep_root->child(1));
+    EXPECT_EQ(ep_recur->num_children(), 2);
+
+    // Nothing changed: everything is reused.
+    project_wrt_bob.update();
+    EXPECT_EQ(project_wrt_bob.num_projected(), 0);
+    EXPECT_EQ(project_wrt_bob.get_root(), ep_root);
+
+    // Modify a message in Rec1, Rec0 projection is reused.
+    interact2->set_msg(new MsgSig("Fourth"));
+    interact2->remove_rcvrs();
+    interact2->add_rcvr(BOB);
+    ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.update());
+    EXPECT_EQ(project_wrt_bob.num_projected(), 3); // interact2, Rec1, root
+    EXPECT_EQ(ep_root->child(1), ep_recur);
+    auto *ep_recur2 = dynamic_cast<RecurNode *>(ep_root->child(2));
+    EXPECT_EQ(ep_recur2->num_children(), 1);
+    auto *ep_interact2 = dynamic_cast<InteractionNode *>(ep_recur2->child(0));
+    EXPECT_EQ(ep_interact2->msg()->label(), "Fourth");
+
+    // Edit the MsgSig and a Role through the getters of interact2.
+    MsgPayload payload("int");
+    interact2->msg()->add_payload(&payload);
+    ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.update());
+    EXPECT_EQ(project_wrt_bob.num_projected(), 3); // interact2, Rec1, root
+    ep_recur2 = dynamic_cast<RecurNode *>(ep_root->child(2));
+    ep_interact2 = dynamic_cast<InteractionNode *>(ep_recur2->child(0));
+    EXPECT_EQ(ep_interact2->msg()->num_payloads(), 1);
+
+    interact2->sndr()->set_name("Dave");
+    ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.update());
+    EXPECT_EQ(project_wrt_bob.num_projected(), 3); // interact2, Rec1, root
+    EXPECT_EQ(ep_root->child(1), ep_recur);
+    ep_recur2 = dynamic_cast<RecurNode *>(ep_root->child(2));
+    ep_interact2 = dynamic_cast<InteractionNode *>(ep_recur2->child(0));
+    EXPECT_EQ(ep_interact2->sndr()->name(), "Dave");
+
+    // Append to root, the new child is projected.
+    auto *interact3 = new InteractionNode(new MsgSig("Fifth"));
+    interact3->set_sndr(CAROL);
+    interact3->add_rcvr(BOB);
+    root->append_child(interact3);
+    ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.update());
+    EXPECT_EQ(project_wrt_bob.num_projected(), 2); // interact3, root
+    EXPECT_EQ(ep_root->num_children(), 4);
+    EXPECT_EQ(ep_root->child(1), ep_recur);
+    EXPECT_EQ(ep_root->child(2), ep_recur2);
+
+    // Result matches a full projection.
+    util::ProjectionVisitor full(BOB);
+    root->accept(full);
+    auto *full_root = full.get_root();
+    expect_same_tree(full_root, ep_root);
+    delete full_root;
+
+    // Nested blocks are inlined except as branches of choice (here without
+    // a choice Role) and par.
+    auto interaction = [](std::string label, Role *from, Role *to) {
+        MsgSig msg(label);
+        auto *node = new InteractionNode(&msg);
+        node->set_sndr(from);
+        node->add_rcvr(to);
+        return node;
+    };
+    auto *block = new BlockNode();
+    auto *inner = new BlockNode();
+    block->append_child(interaction("Sixth", BOB, ALICE));
+    inner->append_child(interaction("Seventh", ALICE, BOB));
+    block->append_child(inner);
+    root->append_child(block);
+    auto *recur_block = new BlockNode();
+    recur_block->append_child(interaction("Eighth", CAROL, BOB));
+    recur2->append_child(recur_block);
+    auto *choice = new ChoiceNode();
+    for (auto label : { "Left", "Right" }) {
+        auto *branch = new BlockNode();
+        branch->append_child(interaction(label, ALICE, BOB));
+        choice->append_child(branch);
+    }
+    root->append_child(choice);
+    auto *par = new ParNode();
+    auto *left = new BlockNode();
+    left->append_child(interaction("Up", ALICE, BOB));
+    par->append_child(left);
+    par->append_child(interaction("Down", BOB, CAROL));
+    root->append_child(par);
+
+    ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.update());
+    util::ProjectionVisitor full2(BOB);
+    root->accept(full2);
+    full_root = full2.get_root();
+    expect_same_tree(full_root, ep_root);
+    delete full_root;
+
+    // Modify the inlined block, the rest is reused.
+    inner->append_child(interaction("Ninth", CAROL, BOB));
+    ep_root = dynamic_cast<BlockNode *>(project_wrt_bob.update());
+    EXPECT_EQ(project_wrt_bob.num_projected(), 4); // Ninth, inner, block, root
+    EXPECT_EQ(ep_root->child(1), ep_recur);
+    util::ProjectionVisitor full3(BOB);
+    root->accept(full3);
+    full_root = full3.get_root();
+    expect_same_tree(full_root, ep_root);
+    delete full_root;
+
+    // A global root which is not a block is wrapped like ProjectionVisitor.
+    util::IncrementalProjection project_recur(recur2, BOB);
+    util::ProjectionVisitor full4(BOB);
+    recur2->accept(full4);
+    full_root = full4.get_root();
+    expect_same_tree(full_root, project_recur.get_root());
+    delete full_root;
+
+    delete root;
+    delete ALICE;
+    delete BOB;
+    delete CAROL;
+}
+
 } // namespace tests
 } // namespace sesstype
 
@@ -4,12 +4,14 @@
  */
 #include <stdexcept>
 #include <string>
+#include <sstream>
 #include <iostream>
 
 #include "gtest/gtest.h"
 
 #include "sesstype/session.h"
 #include "sesstype/import.h"
+#include "sesstype/module.h"
 #include "sesstype/util.h"
 
 namespace sesstype {
@@ -34,6 +36,213 @@ TEST_F(SessionTest, EmptySession)
   EXPECT_EQ(empty.type(), ST_TYPE_GLOBAL);
 }
 
+/**
+ * \test Deep copy of session, sequential and parallel.
+ */
+TEST_F(SessionTest, CopySession)
+{
+  auto *session = new sesstype::Session("Unrolled");
+  session->add_role(new sesstype::Role("A"));
+  session->add_role(new sesstype::Role("B"));
+  auto *root = new sesstype::BlockNode();
+  for (unsigned int i=0; i<20000; i++) {
+    auto *node = new sesstype::InteractionNode(new sesstype::MsgSig("L" + std::to_string(i)));
+    node->set_sndr(session->role(i % 2 ? "A" : "B"));
+    node->add_rcvr(session->role(i % 2 ? "B" : "A"));
+    root->append_child(node);
+  }
+  session->set_root(root);
+
+  sesstype::Session copy(*session);
+  EXPECT_EQ(copy.name(), "Unrolled");
+  EXPECT_NE(copy.root(), session->root());
+  EXPECT_NE(copy.role("A"), session->role("A"));
+  EXPECT_EQ(copy.num_roles(), 2);
+
+  util::ForkJoinPool pool(4);
+  auto *parallel_copy = util::parallel_clone(pool, session);
+  EXPECT_EQ(parallel_copy->num_roles(), 2);
+  EXPECT_NE(parallel_copy->root(), session->root());
+  EXPECT_EQ(util::parallel_hash(pool, parallel_copy->root()), util::parallel_hash(pool, copy.root()));
+  auto *copy_root = dynamic_cast<sesstype::BlockNode *>(parallel_copy->root());
+  EXPECT_EQ(copy_root->num_children(), 20000);
+  EXPECT_EQ(dynamic_cast<sesstype::InteractionNode *>(copy_root->child(12345))->msg()->label(), "L12345");
+
+  delete session;
+  delete parallel_copy;
+}
+
+/**
+ * \test JSON and canonical text export of a session.
+ */
+TEST_F(SessionTest, ExportSession)
+{
+  sesstype::Module module("M");
+  module.add_import(new sesstype::Import("String", "java.lang", "S"));
+  auto *session = new sesstype::Session("P");
+  session->add_role(new sesstype::Role("B"));
+  session->add_role(new sesstype::Role("A"));
+  auto *root = new sesstype::BlockNode();
+  auto *recur = new sesstype::RecurNode("T");
+  auto *choice = new sesstype::ChoiceNode(new sesstype::Role("A"));
+  auto *msg = new sesstype::MsgSig("L");
+  msg->add_payload(new sesstype::MsgPayload("int", "x"));
+  msg->add_payload(new sesstype::MsgPayload("java.lang.String"));
+  auto *interaction = new sesstype::InteractionNode(msg);
+  delete msg;
+  interaction->set_sndr(session->role("A"));
+  interaction->add_rcvr(session->role("B"));
+  auto *branch = new sesstype::BlockNode();
+  branch->append_child(interaction);
+  branch->append_child(new sesstype::ContinueNode("T"));
+  choice->add_choice(branch);
+  auto *quit = new sesstype::BlockNode();
+  auto *quit_interaction = new sesstype::InteractionNode(new sesstype::MsgSig("to"));
+  quit_interaction->set_sndr(session->role("A"));
+  quit->append_child(quit_interaction);
+  choice->add_choice(quit);
+  recur->append_child(choice);
+  root->append_child(recur);
+  session->set_root(root);
+  module.add_session(session);
+
+  std::stringstream text;
+  {
+    util::OutputBuffer buf(text);
+    util::TextExport exporter(buf);
+    exporter.write(module);
+    EXPECT_TRUE(exporter.is_valid());
+  }
+  EXPECT_EQ(text.str(),
+      "module M;\n"
+      "import String from java.lang as S;\n"
+      "global protocol P(role A, role B) {\n"
+      "  rec T {\n"
+      "    choice at A {\n"
+      "      {\n"
+      "        L(int x, java.lang.String) from A to B;\n"
+      "        continue T;\n"
+      "      }\n"
+      "      {\n"
+      "        \"to\"() from A;\n"
+      "      }\n"
+      "    }\n"
+      "  }\n"
+      "}\n");
+
+  std::stringstream json;
+  {
+    util::OutputBuffer buf(json);
+    util::JsonExport exporter(buf);
+    exporter.write(*session);
+    EXPECT_TRUE(exporter.is_valid());
+  }
+  EXPECT_EQ(json.str(),
+      "{\"name\":\"P\",\"type\":\"global\",\"roles\":[\"A\",\"B\"],\"root\":"
+      "{\"node\":\"block\",\"children\":["
+      "{\"node\":\"recur\",\"label\":\"T\",\"children\":["
+      "{\"node\":\"choice\",\"at\":\"A\",\"children\":["
+      "{\"node\":\"block\",\"children\":["
+      "{\"node\":\"interaction\",\"from\":\"A\",\"to\":[\"B\"],\"msg\":{\"label\":\"L\",\"payloads\":["
+      "{\"type\":\"int\",\"name\":\"x\"},{\"type\":\"java.lang.String\",\"name\":\"\"}]}},"
+      "{\"node\":\"continue\",\"label\":\"T\"}]},"
+      "{\"node\":\"block\",\"children\":["
+      "{\"node\":\"interaction\",\"from\":\"A\",\"to\":[],\"msg\":{\"label\":\"to\",\"payloads\":[]}}]}]}]}]}}");
+
+  // Copies of a message own their payloads.
+  sesstype::MsgSig copy(*interaction->msg());
+  EXPECT_EQ(copy.num_payloads(), 2);
+  EXPECT_NE(copy.payload(0), interaction->msg()->payload(0));
+
+  delete session;
+}
+
+/**
+ * \test Canonical text is read back into a tree which exports identically.
+ */
+TEST_F(SessionTest, ReadText)
+{
+  const std::string text =
+      "module \"my module\";\n"
+      "import Int from C;\n"
+      "import String from java.lang as S;\n"
+      "global protocol Empty(role A);\n"
+      "global protocol P(role A, role B, role C) {\n"
+      "  rec T {\n"
+      "    choice at A {\n"
+      "      {\n"
+      "        L(int x, \"char[]\") from A to B, C;\n"
+      "        continue T;\n"
+      "      }\n"
+      "      {\n"
+      "        \"to\"() from A;\n"
+      "      }\n"
+      "    }\n"
+      "  }\n"
+      "  par {\n"
+      "    {\n"
+      "      M() from B to C;\n"
+      "    }\n"
+      "    N() to A;\n"
+      "  }\n"
+      "  do Q@s<L(int), K()>(A, B);\n"
+      "  interruptible s {\n"
+      "    O();\n"
+      "  } with { interrupt A: Stop(); }\n"
+      "}\n"
+      "local protocol P_A at A(role A, role B) {\n"
+      "  \"with \\\"quotes\\\"\"() to B;\n"
+      "}\n";
+
+  util::TextReader reader(text.data(), text.size());
+  sesstype::Module *module = reader.read_module();
+  EXPECT_EQ(module->name(), "my module");
+  EXPECT_EQ(module->num_sessions(), 3);
+  EXPECT_EQ(module->import("S")->from(), "java.lang");
+  EXPECT_EQ(module->session("P_A")->type(), ST_TYPE_LOCAL);
+  EXPECT_EQ(module->session("P_A")->endpoint()->name(), "A");
+  EXPECT_EQ(module->session("Empty")->root(), nullptr);
+  auto *root = dynamic_cast<sesstype::BlockNode *>(module->session("P")->root());
+  ASSERT_NE(root, nullptr);
+  EXPECT_EQ(root->num_children(), 4);
+  EXPECT_EQ(root->child(0)->type(), ST_NODE_RECUR);
+  auto *nested = dynamic_cast<sesstype::NestedNode *>(root->child(2));
+  ASSERT_NE(nested, nullptr);
+  EXPECT_EQ(nested->num_args(), 2);
+  EXPECT_EQ(nested->num_roleargs(), 2);
+
+  std::stringstream out;
+  {
+    util::OutputBuffer buf(out);
+    util::TextExport exporter(buf);
+    exporter.write(*module);
+  }
+  EXPECT_EQ(out.str(), text);
+
+  for (auto it=module->session_begin(); it!=module->session_end(); it++) {
+    delete it->second;
+  }
+  delete module;
+
+  // Deep nesting does not depend on the call stack.
+  std::string deep = "global protocol D(role A) ";
+  for (unsigned int i=0; i<10000; i++) deep += "{";
+  deep += "L() from A;";
+  for (unsigned int i=0; i<10000; i++) deep += "}";
+  st_tree *tree = st_tree_read_text(deep.c_str());
+  ASSERT_NE(tree, nullptr);
+  delete tree;
+
+  util::TextReader bad("global protocol P(role A) {\n  L() from A\n}", 42);
+  try {
+    delete bad.read_session();
+    FAIL();
+  } catch (std::runtime_error &e) {
+    EXPECT_EQ(std::string(e.what()), "Syntax error at 3:1: expected ';'");
+  }
+  EXPECT_EQ(st_tree_read_text("global protocol P(role A) { rec T { }"), nullptr);
+}
+
 } // namespace tests
 } // namespace sesstype
 
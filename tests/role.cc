@@ -6,15 +6,28 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 #include "sesstype/role.h"
 #include "sesstype/parameterised/expr.h"
+#include "sesstype/parameterised/expr/add.h"
 #include "sesstype/parameterised/expr/rng.h"
+#include "sesstype/parameterised/expr/sub.h"
 #include "sesstype/parameterised/expr/val.h"
+#include "sesstype/parameterised/expr/var.h"
+#include "sesstype/parameterised/msg.h"
+#include "sesstype/parameterised/nodes.h"
 #include "sesstype/parameterised/role.h"
 #include "sesstype/parameterised/role_grp.h"
+#include "sesstype/parameterised/session.h"
+#include "sesstype/parameterised/util/comm_graph.h"
+#include "sesstype/parameterised/util/placement.h"
+#include "sesstype/parameterised/util/role_layout.h"
 
 namespace sesstype {
 namespace tests {
@@ -87,6 +100,402 @@ TEST_F(RoleTest, BasicRolrGrp)
     delete grp_withname;
 }
 
+/**
+ * \test Rank-to-rank communication graph of a parameterised Session.
+ */
+TEST_F(RoleTest, CommGraph)
+{
+    using sesstype::parameterised::AddExpr;
+    using sesstype::parameterised::BlockNode;
+    using sesstype::parameterised::ForNode;
+    using sesstype::parameterised::InteractionNode;
+    using sesstype::parameterised::MsgPayload;
+    using sesstype::parameterised::MsgSig;
+    using sesstype::parameterised::RngExpr;
+    using sesstype::parameterised::Role;
+    using sesstype::parameterised::Session;
+    using sesstype::parameterised::SubExpr;
+    using sesstype::parameterised::ValExpr;
+    using sesstype::parameterised::VarExpr;
+    using sesstype::parameterised::util::CommGraph;
+
+    // global protocol P(role M, role W[1..N], role G[1..2][1..3]) {
+    //   Data(int) from M to W[1..N];
+    //   foreach (i:1..N-1) { Ring(double) from W[i] to W[i+1]; }
+    //   foreach (i:1..N) { Ring(double) from W[i] to W[i+1]; }
+    //   foreach (i:1..2) { foreach (j:1..2) { Halo(int) from G[i][j] to G[i][j+1]; } }
+    // }
+    Session session("P");
+    session.add_role(new Role("M"));
+    auto *w = new Role("W");
+    w->add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    session.add_role(w);
+    auto *g = new Role("G");
+    g->add_param(new RngExpr(new ValExpr(1), new ValExpr(2)));
+    g->add_param(new RngExpr(new ValExpr(1), new ValExpr(3)));
+    session.add_role(g);
+    auto *root = new BlockNode();
+
+    MsgSig data("Data");
+    MsgPayload data_payload("int");
+    data.add_payload(&data_payload);
+    auto *scatter = new InteractionNode(&data);
+    Role m("M"), w_all("W");
+    w_all.add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    scatter->set_sndr(&m);
+    scatter->add_rcvr(&w_all);
+    root->append_child(scatter);
+
+    MsgSig ring("Ring");
+    MsgPayload ring_payload("double");
+    ring.add_payload(&ring_payload);
+    Role w_i("W"), w_next("W");
+    w_i.add_param(new VarExpr("i"));
+    w_next.add_param(new AddExpr(new VarExpr("i"), new ValExpr(1)));
+    for (auto *to : { static_cast<sesstype::parameterised::Expr *>(new SubExpr(new VarExpr("N"), new ValExpr(1))),
+                      static_cast<sesstype::parameterised::Expr *>(new VarExpr("N")) }) {
+        auto *loop = new ForNode(new RngExpr("i", new ValExpr(1), to));
+        auto *interaction = new InteractionNode(&ring);
+        interaction->set_sndr(&w_i);
+        interaction->add_rcvr(&w_next);
+        loop->append_child(interaction);
+        root->append_child(loop);
+    }
+
+    auto *outer = new ForNode(new RngExpr("i", new ValExpr(1), new ValExpr(2)));
+    auto *inner = new ForNode(new RngExpr("j", new ValExpr(1), new ValExpr(2)));
+    MsgSig halo("Halo");
+    MsgPayload halo_payload("int");
+    halo.add_payload(&halo_payload);
+    auto *halo_interaction = new InteractionNode(&halo);
+    Role g_ij("G"), g_next("G");
+    g_ij.add_param(new VarExpr("i"));
+    g_ij.add_param(new VarExpr("j"));
+    g_next.add_param(new VarExpr("i"));
+    g_next.add_param(new AddExpr(new VarExpr("j"), new ValExpr(1)));
+    halo_interaction->set_sndr(&g_ij);
+    halo_interaction->add_rcvr(&g_next);
+    inner->append_child(halo_interaction);
+    outer->append_child(inner);
+    root->append_child(outer);
+    session.set_root(root);
+
+    const long n = 1000;
+    CommGraph graph;
+    graph.set_num_threads(4);
+    graph.build(session, { { "N", n } });
+
+    // Roles in order of name: G (6 ranks), M, W (n ranks).
+    ASSERT_EQ(graph.num_ranks(), 6 + 1 + n);
+    EXPECT_EQ(graph.rank("G", { 2, 2 }), 4);
+    EXPECT_EQ(graph.rank("M"), 6);
+    EXPECT_EQ(graph.rank("W", { 1 }), 7);
+    EXPECT_EQ(graph.role(6), "M");
+    EXPECT_EQ(graph.index(5), std::vector<long>({ 2, 3 }));
+    EXPECT_EQ(graph.layout("W").size(), n);
+    EXPECT_THROW(graph.rank("W", { n + 1 }), std::out_of_range);
+    EXPECT_THROW(graph.rank("X"), std::out_of_range);
+
+    EXPECT_EQ(graph.num_edges(), n + (n - 1) + 4);
+    EXPECT_EQ(graph.num_dropped(), 1);
+    EXPECT_EQ(graph.row_offsets().back(), graph.num_edges());
+    unsigned long e = graph.find_edge(graph.rank("M"), graph.rank("W", { 5 }));
+    ASSERT_LT(e, graph.num_edges());
+    EXPECT_EQ(graph.msgs()[e], 1);
+    EXPECT_EQ(graph.bytes()[e], 4);
+    e = graph.find_edge(graph.rank("W", { 3 }), graph.rank("W", { 4 }));
+    ASSERT_LT(e, graph.num_edges());
+    EXPECT_EQ(graph.msgs()[e], 2);
+    EXPECT_EQ(graph.bytes()[e], 16);
+    EXPECT_LT(graph.find_edge(graph.rank("G", { 2, 2 }), graph.rank("G", { 2, 3 })), graph.num_edges());
+    EXPECT_EQ(graph.find_edge(graph.rank("W", { 4 }), graph.rank("W", { 3 })), graph.num_edges());
+
+    // The graph does not depend on the number of threads.
+    CommGraph serial;
+    serial.set_num_threads(1);
+    serial.build(session, { { "N", n } });
+    EXPECT_EQ(serial.row_offsets(), graph.row_offsets());
+    EXPECT_EQ(serial.columns(), graph.columns());
+    EXPECT_EQ(serial.msgs(), graph.msgs());
+    EXPECT_EQ(serial.bytes(), graph.bytes());
+
+    EXPECT_THROW(graph.build(session, { }), std::invalid_argument);
+
+    // global protocol Q(role W[1..N]) {
+    //   foreach (i:1..N-1 except 3) { Ring(double) from W[i] to W[i+1]; }
+    //   foreach (i:1..N-1) { Up(int) from W[i] to W[i+1] if W[2..4]; }
+    // }
+    Session skip("Q");
+    auto *w_q = new Role("W");
+    w_q->add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    skip.add_role(w_q);
+    auto *skip_root = new BlockNode();
+    auto *except_loop = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1))));
+    except_loop->set_except(new ValExpr(3));
+    auto *except_interaction = new InteractionNode(&ring);
+    except_interaction->set_sndr(&w_i);
+    except_interaction->add_rcvr(&w_next);
+    except_loop->append_child(except_interaction);
+    skip_root->append_child(except_loop);
+    auto *cond_loop = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1))));
+    auto *cond_interaction = new InteractionNode(&data);
+    cond_interaction->set_sndr(&w_i);
+    cond_interaction->add_rcvr(&w_next);
+    auto *cond = new Role("W");
+    cond->add_param(new RngExpr(new ValExpr(2), new ValExpr(4)));
+    cond_interaction->set_cond(cond);
+    cond_loop->append_child(cond_interaction);
+    skip_root->append_child(cond_loop);
+    skip.set_root(skip_root);
+
+    CommGraph skip_graph;
+    skip_graph.build(skip, { { "N", 6 } });
+    EXPECT_EQ(skip_graph.num_dropped(), 0);
+    EXPECT_EQ(skip_graph.num_edges(), 5);
+    e = skip_graph.find_edge(skip_graph.rank("W", { 3 }), skip_graph.rank("W", { 4 }));
+    ASSERT_LT(e, skip_graph.num_edges());
+    EXPECT_EQ(skip_graph.msgs()[e], 1);
+    EXPECT_EQ(skip_graph.bytes()[e], 4);
+    e = skip_graph.find_edge(skip_graph.rank("W", { 2 }), skip_graph.rank("W", { 3 }));
+    ASSERT_LT(e, skip_graph.num_edges());
+    EXPECT_EQ(skip_graph.msgs()[e], 2);
+    EXPECT_EQ(skip_graph.bytes()[e], 12);
+    e = skip_graph.find_edge(skip_graph.rank("W", { 1 }), skip_graph.rank("W", { 2 }));
+    ASSERT_LT(e, skip_graph.num_edges());
+    EXPECT_EQ(skip_graph.msgs()[e], 1);
+    EXPECT_EQ(skip_graph.bytes()[e], 8);
+    e = skip_graph.find_edge(skip_graph.rank("W", { 5 }), skip_graph.rank("W", { 6 }));
+    ASSERT_LT(e, skip_graph.num_edges());
+    EXPECT_EQ(skip_graph.msgs()[e], 1);
+
+    // global protocol R(role W[1..N]) {
+    //   foreach (t:1..1000) { foreach (i:1..N-1) { Ring(double) from W[i] to W[i+1]; } }
+    // }
+    // More messages than a worker buffers before merging them.
+    Session steps("R");
+    auto *w_r = new Role("W");
+    w_r->add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    steps.add_role(w_r);
+    auto *steps_root = new BlockNode();
+    auto *time_loop = new ForNode(new RngExpr("t", new ValExpr(1), new ValExpr(1000)));
+    auto *ring_loop = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1))));
+    auto *step = new InteractionNode(&ring);
+    step->set_sndr(&w_i);
+    step->add_rcvr(&w_next);
+    ring_loop->append_child(step);
+    time_loop->append_child(ring_loop);
+    steps_root->append_child(time_loop);
+    steps.set_root(steps_root);
+    for (unsigned int num_threads : { 1u, 4u }) {
+        CommGraph steps_graph;
+        steps_graph.set_num_threads(num_threads);
+        steps_graph.build(steps, { { "N", 100 } });
+        ASSERT_EQ(steps_graph.num_edges(), 99);
+        for (unsigned long k=0; k<steps_graph.num_edges(); k++) {
+            EXPECT_EQ(steps_graph.msgs()[k], 1000);
+            EXPECT_EQ(steps_graph.bytes()[k], 8000);
+        }
+    }
+
+    // A condition on a Role outside of the interaction is rejected.
+    cond_interaction->set_cond(new Role("M"));
+    cond_interaction->cond()->add_param(new ValExpr(1));
+    EXPECT_THROW(skip_graph.build(skip, { { "N", 6 } }), std::invalid_argument);
+}
+
+/**
+ * \test Index to rank mapping of a multi-dimensional Role.
+ */
+TEST_F(RoleTest, RoleLayout)
+{
+    using sesstype::parameterised::RngExpr;
+    using sesstype::parameterised::ValExpr;
+    using sesstype::parameterised::VarExpr;
+    using sesstype::parameterised::util::RoleLayout;
+
+    // role W[1..N][0..M-1] with N=3, M=4
+    sesstype::parameterised::Role w("W");
+    w.add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+    w.add_param(new RngExpr(new ValExpr(0), new sesstype::parameterised::SubExpr(new VarExpr("M"), new ValExpr(1))));
+    RoleLayout row(&w, { { "N", 3 }, { "M", 4 } });
+    EXPECT_EQ(row.num_dimens(), 2);
+    EXPECT_EQ(row.size(), 12);
+    EXPECT_EQ(row.rank({ 1, 0 }), 0);
+    EXPECT_EQ(row.rank({ 1, 3 }), 3);
+    EXPECT_EQ(row.rank({ 2, 1 }), 5);
+    EXPECT_EQ(row.index(5), std::vector<long>({ 2, 1 }));
+    EXPECT_THROW(row.rank({ 0, 0 }), std::out_of_range);
+    EXPECT_THROW(row.rank({ 1 }), std::out_of_range);
+    EXPECT_THROW(row.index(12), std::out_of_range);
+    EXPECT_THROW(RoleLayout(&w, { { "N", 3 } }), std::invalid_argument);
+
+    RoleLayout col(&w, { { "N", 3 }, { "M", 4 } }, ST_LAYOUT_COL_MAJOR);
+    EXPECT_EQ(col.rank({ 2, 1 }), 4);
+    EXPECT_EQ(col.index(4), std::vector<long>({ 2, 1 }));
+    for (unsigned long r=0; r<col.size(); r++) {
+        EXPECT_EQ(col.rank(col.index(r)), r);
+    }
+
+    // Custom order of three dimensions: 1 slowest, then 2, then 0.
+    RoleLayout grid("G", { 0, 0, 0 }, { 2, 3, 4 });
+    grid.set_order({ 1, 2, 0 });
+    EXPECT_EQ(grid.stride(0), 1);
+    EXPECT_EQ(grid.stride(2), 2);
+    EXPECT_EQ(grid.stride(1), 8);
+    EXPECT_EQ(grid.rank({ 1, 2, 3 }), 1 + 3 * 2 + 2 * 8);
+    EXPECT_THROW(grid.set_order({ 0, 0, 1 }), std::invalid_argument);
+
+    // Stencil neighbours, with the second dimension periodic.
+    EXPECT_EQ(RoleLayout::stencil(2).size(), 4);
+    EXPECT_EQ(RoleLayout::stencil(3, true).size(), 26);
+    unsigned long n;
+    EXPECT_FALSE(row.neighbour(row.rank({ 1, 0 }), { -1, 0 }, n));
+    EXPECT_FALSE(row.neighbour(row.rank({ 1, 0 }), { 0, -1 }, n));
+    row.set_periodic(1, true);
+    ASSERT_TRUE(row.neighbour(row.rank({ 1, 0 }), { 0, -1 }, n));
+    EXPECT_EQ(n, row.rank({ 1, 3 }));
+    auto neighbours = row.neighbours(row.rank({ 1, 0 }), RoleLayout::stencil(2));
+    EXPECT_EQ(neighbours, std::vector<unsigned long>({ row.rank({ 2, 0 }), row.rank({ 1, 3 }), row.rank({ 1, 1 }) }));
+    EXPECT_EQ(row.neighbours(row.rank({ 2, 2 }), RoleLayout::stencil(2, true)).size(), 8);
+
+    std::stringstream ss;
+    row.write_cart(ss);
+    EXPECT_EQ(ss.str(), "W dims=3,4 periods=0,1 from=1,0 order=0,1\n");
+}
+
+/**
+ * \test Placement of synthetic ring, stencil and all-to-all protocols.
+ */
+TEST_F(RoleTest, Placement)
+{
+    using sesstype::parameterised::AddExpr;
+    using sesstype::parameterised::BlockNode;
+    using sesstype::parameterised::Expr;
+    using sesstype::parameterised::ForNode;
+    using sesstype::parameterised::InteractionNode;
+    using sesstype::parameterised::MsgPayload;
+    using sesstype::parameterised::MsgSig;
+    using sesstype::parameterised::RngExpr;
+    using sesstype::parameterised::Role;
+    using sesstype::parameterised::Session;
+    using sesstype::parameterised::SubExpr;
+    using sesstype::parameterised::ValExpr;
+    using sesstype::parameterised::VarExpr;
+    using sesstype::parameterised::util::CommGraph;
+    using sesstype::parameterised::util::Placement;
+
+    MsgSig msg("M");
+    MsgPayload payload("double");
+    msg.add_payload(&payload);
+
+    // foreach (i:1..N-d_i) foreach (j:1..N-d_j) { M(double) from G[i][j] to G[i+d_i][j+d_j]; }
+    auto stencil = [&](Session &session, long di, long dj) {
+        auto *outer = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(di))));
+        auto *inner = new ForNode(new RngExpr("j", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(dj))));
+        auto *interaction = new InteractionNode(&msg);
+        Role sndr("G"), rcvr("G");
+        sndr.add_param(new VarExpr("i"));
+        sndr.add_param(new VarExpr("j"));
+        rcvr.add_param(new AddExpr(new VarExpr("i"), new ValExpr(di)));
+        rcvr.add_param(new AddExpr(new VarExpr("j"), new ValExpr(dj)));
+        interaction->set_sndr(&sndr);
+        interaction->add_rcvr(&rcvr);
+        inner->append_child(interaction);
+        outer->append_child(inner);
+        dynamic_cast<BlockNode *>(session.root())->append_child(outer);
+    };
+    auto grid_role = [](unsigned int num_dimens) {
+        auto *role = new Role(num_dimens == 1 ? "W" : "G");
+        for (unsigned int d=0; d<num_dimens; d++) {
+            role->add_param(new RngExpr(new ValExpr(1), new VarExpr("N")));
+        }
+        return role;
+    };
+    // Round-robin placement, as done by a scheduler unaware of the protocol.
+    auto round_robin = [](unsigned long num_ranks, unsigned long num_nodes, unsigned long span) {
+        std::vector<unsigned long> slots;
+        for (unsigned long r=0; r<num_ranks; r++) {
+            slots.push_back((r % num_nodes) * span + r / num_nodes);
+        }
+        return slots;
+    };
+
+    // Ring of 64 ranks on 4 nodes of 2 sockets of 8 cores.
+    Session ring("Ring");
+    ring.add_role(grid_role(1));
+    ring.set_root(new BlockNode());
+    auto *loop = new ForNode(new RngExpr("i", new ValExpr(1), new SubExpr(new VarExpr("N"), new ValExpr(1))));
+    auto *interaction = new InteractionNode(&msg);
+    Role w_i("W"), w_next("W");
+    w_i.add_param(new VarExpr("i"));
+    w_next.add_param(new AddExpr(new VarExpr("i"), new ValExpr(1)));
+    interaction->set_sndr(&w_i);
+    interaction->add_rcvr(&w_next);
+    loop->append_child(interaction);
+    dynamic_cast<BlockNode *>(ring.root())->append_child(loop);
+
+    CommGraph ring_graph;
+    ring_graph.build(ring, { { "N", 64 } });
+    Placement placement({ 4, 2, 8 });
+    EXPECT_EQ(placement.capacity(), 64);
+    placement.place(ring_graph);
+    std::vector<unsigned long> sorted(placement.slots());
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    EXPECT_EQ(placement.traffic(ring_graph, 0), 3 * 8);
+    EXPECT_EQ(placement.traffic(ring_graph, 1), 7 * 8);
+    Placement blind({ 4, 2, 8 });
+    blind.set_slots(round_robin(64, 4, 16));
+    EXPECT_EQ(blind.traffic(ring_graph, 0), 63 * 8);
+
+    // 5-point stencil on an 8x8 grid, on 4 nodes of 16 cores.
+    Session grid("Stencil");
+    grid.add_role(grid_role(2));
+    grid.set_root(new BlockNode());
+    stencil(grid, 0, 1);
+    stencil(grid, 1, 0);
+    CommGraph grid_graph;
+    grid_graph.build(grid, { { "N", 8 } });
+    Placement grid_placement({ 4, 16 });
+    grid_placement.set_weight(ST_PLACE_MSGS);
+    grid_placement.place(grid_graph);
+    EXPECT_LE(grid_placement.traffic(grid_graph, 0), 24);
+    blind.set_weight(ST_PLACE_MSGS);
+    blind.set_slots(round_robin(64, 4, 16));
+    EXPECT_EQ(blind.traffic(grid_graph, 0), 56);
+
+    // All-to-all of 16 ranks on 2 nodes: every balanced placement is optimal.
+    Session all("AllToAll");
+    all.add_role(grid_role(1));
+    auto *root = new BlockNode();
+    auto *outer = new ForNode(new RngExpr("i", new ValExpr(1), new VarExpr("N")));
+    auto *inner = new ForNode(new RngExpr("j", new ValExpr(1), new VarExpr("N")));
+    auto *exchange = new InteractionNode(&msg);
+    Role w_j("W");
+    w_j.add_param(new VarExpr("j"));
+    exchange->set_sndr(&w_i);
+    exchange->add_rcvr(&w_j);
+    inner->append_child(exchange);
+    outer->append_child(inner);
+    root->append_child(outer);
+    all.set_root(root);
+    CommGraph all_graph;
+    all_graph.build(all, { { "N", 16 } });
+    Placement all_placement({ 2, 8 });
+    all_placement.set_weight(ST_PLACE_MSGS);
+    all_placement.place(all_graph);
+    EXPECT_EQ(all_placement.traffic(all_graph, 0), 2 * 8 * 8);
+    for (unsigned int node=0; node<2; node++) {
+        unsigned long count = 0;
+        for (unsigned long r=0; r<16; r++) {
+            count += all_placement.domain(r, 0) == node;
+        }
+        EXPECT_EQ(count, 8);
+    }
+
+    EXPECT_THROW(Placement({ 2, 4 }).place(all_graph), std::invalid_argument);
+}
+
 } // namespace tests
 } // namespace sesstype
 